@@ -11,9 +11,25 @@
 #define NOMINMAX
 #include <windows.h>
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#if !defined(PATTERNS_DISABLE_SIMD) && !defined(_MSC_VER)
+#include <immintrin.h>
+#include <cpuid.h>
+#endif
 
 #if PATTERNS_USE_HINTS
 #include <map>
+#include <tuple>
+#include <cstdio>
+#include <cstring>
 #endif
 
 
@@ -53,11 +69,130 @@ ptrdiff_t details::get_process_base()
 
 
 #if PATTERNS_USE_HINTS
+struct hint_key
+{
+	uint32_t timestamp;
+	uint32_t checksum;
+	uint32_t imageSize;
+	uint64_t hash;
+
+	bool operator<(const hint_key& right) const
+	{
+		return std::tie(timestamp, checksum, imageSize, hash) < std::tie(right.timestamp, right.checksum, right.imageSize, right.hash);
+	}
+};
+
+struct hint_entry
+{
+	std::vector<uint32_t> rvas;
+
+	// false if the scan stopped at maxCount, rvas are then only the first matches
+	bool complete = false;
+};
+
+static std::mutex g_hintsMutex;
+static bool g_hintsDirty = false;
+static hint_cache_stats g_hintStats{};
+
 static auto& getHints()
 {
-	static std::multimap<uint64_t, uintptr_t> hints;
+	static std::map<hint_key, hint_entry> hints;
 	return hints;
 }
+
+static bool GetModuleFingerprint(uintptr_t module, hint_key& key)
+{
+	auto dosHeader = reinterpret_cast<PIMAGE_DOS_HEADER>(module);
+	if (dosHeader->e_magic != IMAGE_DOS_SIGNATURE)
+	{
+		return false;
+	}
+
+	auto ntHeader = reinterpret_cast<PIMAGE_NT_HEADERS>(module + dosHeader->e_lfanew);
+	if (ntHeader->Signature != IMAGE_NT_SIGNATURE)
+	{
+		return false;
+	}
+
+	key.timestamp = ntHeader->FileHeader.TimeDateStamp;
+	key.checksum = ntHeader->OptionalHeader.CheckSum;
+	key.imageSize = ntHeader->OptionalHeader.SizeOfImage;
+	return true;
+}
+
+static bool LookupHint(uintptr_t module, uint64_t hash, size_t patternSize, hint_entry& hint)
+{
+	hint_key key{};
+	if (!GetModuleFingerprint(module, key))
+	{
+		return false;
+	}
+	key.hash = hash;
+
+	std::lock_guard<std::mutex> lock(g_hintsMutex);
+
+	auto it = getHints().find(key);
+	if (it == getHints().end())
+	{
+		return false;
+	}
+
+	for (uint32_t rva : it->second.rvas)
+	{
+		if (rva > key.imageSize || key.imageSize - rva < patternSize)
+		{
+			return false;
+		}
+	}
+
+	hint = it->second;
+	return true;
+}
+
+static void StoreHint(uintptr_t module, uint64_t hash, std::vector<uint32_t>&& rvas, bool complete)
+{
+	hint_key key{};
+	if (!GetModuleFingerprint(module, key))
+	{
+		return;
+	}
+	key.hash = hash;
+
+	std::lock_guard<std::mutex> lock(g_hintsMutex);
+
+	auto& entry = getHints()[key];
+
+	// never replace a full match list with a partial one
+	if ((entry.complete && !complete) || (entry.complete == complete && entry.rvas == rvas))
+	{
+		return;
+	}
+
+	entry.rvas = std::move(rvas);
+	entry.complete = complete;
+
+	g_hintStats.stored++;
+	g_hintsDirty = true;
+}
+
+static void StoreHint(uintptr_t module, uint64_t hash, const std::vector<pattern_match>& matches, bool complete)
+{
+	std::vector<uint32_t> rvas;
+	rvas.reserve(matches.size());
+
+	for (const auto& match : matches)
+	{
+		rvas.push_back(static_cast<uint32_t>(reinterpret_cast<uintptr_t>(match.get<void>()) - module));
+	}
+
+	StoreHint(module, hash, std::move(rvas), complete);
+}
+
+static void CountHint(bool hit)
+{
+	std::lock_guard<std::mutex> lock(g_hintsMutex);
+	(hit ? g_hintStats.hits : g_hintStats.misses)++;
+}
 #endif
 
 static void TransformPattern(std::string_view pattern, std::basic_string<uint8_t>& data, std::basic_string<uint8_t>& mask)
@@ -104,6 +239,151 @@ static void TransformPattern(std::string_view pattern, std::basic_string<uint8_t
 	}
 }
 
+static inline bool MatchAt(const uint8_t* ptr, const uint8_t* pattern, const uint8_t* mask, size_t size)
+{
+	for (size_t k = 0; k < size; k++)
+	{
+		if (pattern[k] != (ptr[k] & mask[k]))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+#if !defined(PATTERNS_DISABLE_SIMD)
+
+// MSVC emits AVX2 intrinsics without any per-function opt-in, GCC/Clang need the target attribute
+#ifdef _MSC_VER
+#define PATTERNS_TARGET_AVX2
+#else
+#define PATTERNS_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+enum class scan_isa
+{
+	scalar,
+	sse2,
+	avx2,
+};
+
+static scan_isa DetectScanISA()
+{
+#ifdef _MSC_VER
+	int regs[4];
+
+	__cpuid(regs, 0);
+	const int maxLeaf = regs[0];
+
+	__cpuid(regs, 1);
+	const bool sse2 = (regs[3] & (1 << 26)) != 0;
+	const bool osxsave = (regs[2] & (1 << 27)) != 0;
+	const bool avx = (regs[2] & (1 << 28)) != 0;
+
+	if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 6) == 6)
+	{
+		__cpuidex(regs, 7, 0);
+
+		if (regs[1] & (1 << 5))
+		{
+			return scan_isa::avx2;
+		}
+	}
+
+	return sse2 ? scan_isa::sse2 : scan_isa::scalar;
+#else
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx2"))
+	{
+		return scan_isa::avx2;
+	}
+
+	return __builtin_cpu_supports("sse2") ? scan_isa::sse2 : scan_isa::scalar;
+#endif
+}
+
+static scan_isa GetScanISA()
+{
+	static const scan_isa isa = DetectScanISA();
+	return isa;
+}
+
+static inline unsigned long LowestSetBit(uint32_t bits)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, bits);
+	return index;
+#else
+	return static_cast<unsigned long>(__builtin_ctz(bits));
+#endif
+}
+
+// Compares two fixed anchor bytes of the pattern against 16 consecutive start positions at once and only runs
+// the full masked compare for positions where both anchors hit. Advances 'i' past everything it has checked,
+// the caller finishes the tail (less than one vector) with the scalar scanner.
+// Returns true once onMatch asks to stop.
+template<typename TCallback>
+static bool ScanSSE2(uintptr_t& i, uintptr_t last, const uint8_t* pattern, const uint8_t* mask, size_t size, size_t a0, size_t a1, TCallback&& onMatch)
+{
+	const __m128i v0 = _mm_set1_epi8(static_cast<char>(pattern[a0]));
+	const __m128i v1 = _mm_set1_epi8(static_cast<char>(pattern[a1]));
+
+	for (; i <= last && last - i >= 15; i += 16)
+	{
+		const __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(i + a0));
+		const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(i + a1));
+
+		uint32_t bits = static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(b0, v0), _mm_cmpeq_epi8(b1, v1))));
+
+		while (bits != 0)
+		{
+			const uintptr_t candidate = i + LowestSetBit(bits);
+			bits &= bits - 1;
+
+			if (MatchAt(reinterpret_cast<const uint8_t*>(candidate), pattern, mask, size) && onMatch(candidate))
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+// Same as ScanSSE2, 32 start positions per step.
+template<typename TCallback>
+PATTERNS_TARGET_AVX2 static bool ScanAVX2(uintptr_t& i, uintptr_t last, const uint8_t* pattern, const uint8_t* mask, size_t size, size_t a0, size_t a1, TCallback&& onMatch)
+{
+	const __m256i v0 = _mm256_set1_epi8(static_cast<char>(pattern[a0]));
+	const __m256i v1 = _mm256_set1_epi8(static_cast<char>(pattern[a1]));
+
+	for (; i <= last && last - i >= 31; i += 32)
+	{
+		const __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(i + a0));
+		const __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(i + a1));
+
+		uint32_t bits = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(b0, v0), _mm256_cmpeq_epi8(b1, v1))));
+
+		while (bits != 0)
+		{
+			const uintptr_t candidate = i + LowestSetBit(bits);
+			bits &= bits - 1;
+
+			if (MatchAt(reinterpret_cast<const uint8_t*>(candidate), pattern, mask, size) && onMatch(candidate))
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+#endif
+
 class executable_meta
 {
 private:
@@ -151,152 +431,855 @@ public:
 	inline uintptr_t end() const   { return m_end; }
 };
 
-namespace details
-{
+// start positions per shard; a shard also reads up to pattern size - 1 bytes past its last position, so matches
+// straddling two shards are found by the first one
+static constexpr size_t scan_shard_size = 256 * 1024;
 
-void basic_pattern_impl::Initialize(std::string_view pattern)
-{
-	// get the hash for the base pattern
-#if PATTERNS_USE_HINTS
-	m_hash = fnv_1()(pattern);
-#endif
+// below this a single thread finishes before the workers would have woken up
+static constexpr size_t scan_parallel_threshold = 2 * scan_shard_size;
 
-	// transform the base pattern from IDA format to canonical format
-	TransformPattern(pattern, m_bytes, m_mask);
+static constexpr unsigned scan_max_workers = 4;
 
-#if PATTERNS_USE_HINTS
-	// if there's hints, try those first
-#if PATTERNS_CAN_SERIALIZE_HINTS
-	if (m_rangeStart == reinterpret_cast<uintptr_t>(GetModuleHandle(nullptr)))
-#endif
-	{
-		auto range = getHints().equal_range(m_hash);
+static thread_local bool t_inScanJob = false;
 
-		if (range.first != range.second)
-		{
-			std::for_each(range.first, range.second, [&] (const auto& hint)
-			{
-				ConsiderHint(hint.second);
-			});
+static bool IsLoaderLockHeld()
+{
+#if defined(_MSC_VER) && defined(_M_IX86)
+	const auto peb = reinterpret_cast<const uint8_t*>(__readfsdword(0x30));
+	const auto loaderLock = *reinterpret_cast<RTL_CRITICAL_SECTION* const*>(peb + 0xA0);
+#elif defined(_MSC_VER) && defined(_M_X64)
+	const auto peb = reinterpret_cast<const uint8_t*>(__readgsqword(0x60));
+	const auto loaderLock = *reinterpret_cast<RTL_CRITICAL_SECTION* const*>(peb + 0x110);
+#else
+	// host builds (tools/sigcheck) have no loader lock to worry about
+	return false;
+#endif
 
-			// if the hints succeeded, we don't need to do anything more
-			if (!m_matches.empty())
-			{
-				m_matched = true;
-				return;
-			}
-		}
-	}
+#ifdef _MSC_VER
+	return loaderLock && static_cast<DWORD>(reinterpret_cast<uintptr_t>(loaderLock->OwningThread)) == GetCurrentThreadId();
 #endif
 }
 
-void basic_pattern_impl::EnsureMatches(uint32_t maxCount)
+// Created on first use and never destroyed: the workers only ever sleep on m_wake between jobs, and joining them
+// from a static destructor at exit would wait on threads the OS has already killed.
+class scan_pool
 {
-	if (m_matched || (!m_rangeStart && !m_rangeEnd))
-	{
-		return;
-	}
-
-	// scan the executable for code
-	executable_meta executable = m_rangeStart != 0 && m_rangeEnd != 0 ? executable_meta(m_rangeStart, m_rangeEnd) : executable_meta(m_rangeStart);
+private:
+	std::mutex m_runMutex;
 
-	auto matchSuccess = [&] (uintptr_t address)
-	{
-#if PATTERNS_USE_HINTS
-		getHints().emplace(m_hash, address);
-#else
-		(void)address;
-#endif
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	std::condition_variable m_done;
 
-		return (m_matches.size() == maxCount);
-	};
+	const std::function<void(size_t)>* m_job = nullptr;
+	size_t m_count = 0;
+	std::atomic<size_t> m_next{ 0 };
+	size_t m_active = 0;
+	uint64_t m_generation = 0;
 
-	const uint8_t* pattern = m_bytes.data();
-	const uint8_t* mask = m_mask.data();
-	const size_t maskSize = m_mask.size();
-	const size_t lastWild = m_mask.find_last_not_of(uint8_t(0xFF));
+	unsigned m_workers = 0;
 
-	ptrdiff_t Last[256];
+	scan_pool()
+	{
+		const unsigned cores = std::thread::hardware_concurrency();
+		m_workers = cores > 1 ? std::min(cores - 1, scan_max_workers) : 0;
 
-	std::fill(std::begin(Last), std::end(Last), lastWild == std::string::npos ? -1 : static_cast<ptrdiff_t>(lastWild) );
+		for (unsigned i = 0; i < m_workers; i++)
+		{
+			std::thread(&scan_pool::WorkerMain, this).detach();
+		}
+	}
 
-	for ( ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(maskSize); ++i )
+	void Drain(const std::function<void(size_t)>& job, size_t count)
 	{
-		if ( Last[ pattern[i] ] < i )
+		for (size_t index = m_next++; index < count; index = m_next++)
 		{
-			Last[ pattern[i] ] = i;
+			job(index);
 		}
 	}
 
-	__try
+	void WorkerMain()
 	{
-		for (uintptr_t i = executable.begin(), end = executable.end() - maskSize; i <= end;)
+		t_inScanJob = true;
+
+		uint64_t seen = 0;
+
+		for (;;)
 		{
-			uint8_t* ptr = reinterpret_cast<uint8_t*>(i);
-			ptrdiff_t j = maskSize - 1;
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wake.wait(lock, [&] { return m_generation != seen; });
 
-			while ((j >= 0) && pattern[j] == (ptr[j] & mask[j])) j--;
+			seen = m_generation;
 
-			if (j < 0)
-			{
-				m_matches.emplace_back(ptr);
+			const auto job = m_job;
+			const size_t count = m_count;
 
-				if (matchSuccess(i))
-				{
-					break;
-				}
-				i++;
+			lock.unlock();
+
+			Drain(*job, count);
+
+			lock.lock();
+
+			if (--m_active == 0)
+			{
+				m_done.notify_all();
 			}
-			else i += std::max(ptrdiff_t(1), j - Last[ptr[j]]);
 		}
 	}
-	__except ((GetExceptionCode() == EXCEPTION_ACCESS_VIOLATION) ? EXCEPTION_EXECUTE_HANDLER : EXCEPTION_CONTINUE_SEARCH)
+
+public:
+	static scan_pool& Get()
 	{
+		static scan_pool* pool = new scan_pool();
+		return *pool;
 	}
 
-	m_matched = true;
-}
+	inline unsigned GetWorkerCount() const
+	{
+		return m_workers;
+	}
 
-bool basic_pattern_impl::ConsiderHint(uintptr_t offset)
+	void Run(size_t count, const std::function<void(size_t)>& job)
+	{
+		std::lock_guard<std::mutex> runLock(m_runMutex);
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			m_job = &job;
+			m_count = count;
+			m_next = 0;
+			m_active = m_workers;
+			m_generation++;
+		}
+
+		m_wake.notify_all();
+
+		t_inScanJob = true;
+		Drain(job, count);
+		t_inScanJob = false;
+
+		// every worker has to check in, 'job' goes out of scope once this returns
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_done.wait(lock, [&] { return m_active == 0; });
+	}
+};
+
+bool details::scan_workers_available()
 {
-	uint8_t* ptr = reinterpret_cast<uint8_t*>(offset);
+	// the loader lock check comes first, the pool must not be created while it is held
+	return !t_inScanJob && !IsLoaderLockHeld() && scan_pool::Get().GetWorkerCount() != 0;
+}
 
-#if PATTERNS_CAN_SERIALIZE_HINTS
-	const uint8_t* pattern = m_bytes.data();
-	const uint8_t* mask = m_mask.data();
+void details::scan_parallel_for(size_t count, const std::function<void(size_t)>& fn)
+{
+	if (count > 1 && scan_workers_available())
+	{
+		scan_pool::Get().Run(count, fn);
+		return;
+	}
 
-	for (size_t i = 0, j = m_mask.size(); i < j; i++)
+	for (size_t index = 0; index < count; index++)
 	{
-		if (pattern[i] != (ptr[i] & mask[i]))
-		{
-			return false;
-		}
+		fn(index);
 	}
-#endif
+}
 
-	m_matches.emplace_back(ptr);
+// number of scan_shard_size shards for 'size' start positions, 1 if the range is too small to be worth splitting
+static size_t GetShardCount(size_t size)
+{
+	if (size < scan_parallel_threshold || !details::scan_workers_available())
+	{
+		return 1;
+	}
 
-	return true;
+	return (size + scan_shard_size - 1) / scan_shard_size;
 }
 
-#if PATTERNS_USE_HINTS && PATTERNS_CAN_SERIALIZE_HINTS
-void basic_pattern_impl::hint(uint64_t hash, uintptr_t address)
+struct scan_pattern
+{
+	const uint8_t* bytes;
+	const uint8_t* mask;
+	size_t size;
+
+	// Boyer-Moore-Horspool table
+	const ptrdiff_t* skip;
+
+#if !defined(PATTERNS_DISABLE_SIMD)
+	size_t firstFixed = 0;
+	size_t lastFixed = 0;
+	scan_isa isa = scan_isa::scalar;
+#endif
+};
+
+// Appends the matches starting in [i, last] to 'out' until it holds maxCount of them.
+static void ScanShard(const scan_pattern& pattern, uintptr_t i, uintptr_t last, uint32_t maxCount, std::vector<uintptr_t>& out)
 {
-	auto& hints = getHints();
+	auto onMatch = [&] (uintptr_t address)
+	{
+		out.push_back(address);
+		return (out.size() == maxCount);
+	};
+
+	bool done = false;
 
-	auto range = hints.equal_range(hash);
+#if !defined(PATTERNS_DISABLE_SIMD)
+	if (pattern.isa == scan_isa::avx2)
+	{
+		done = ScanAVX2(i, last, pattern.bytes, pattern.mask, pattern.size, pattern.firstFixed, pattern.lastFixed, onMatch);
+	}
+	else if (pattern.isa == scan_isa::sse2)
+	{
+		done = ScanSSE2(i, last, pattern.bytes, pattern.mask, pattern.size, pattern.firstFixed, pattern.lastFixed, onMatch);
+	}
+#endif
 
-	for (auto it = range.first; it != range.second; ++it)
+	for (; !done && i <= last;)
 	{
-		if (it->second == address)
+		uint8_t* ptr = reinterpret_cast<uint8_t*>(i);
+		ptrdiff_t j = pattern.size - 1;
+
+		while ((j >= 0) && pattern.bytes[j] == (ptr[j] & pattern.mask[j])) j--;
+
+		if (j < 0)
 		{
-			return;
+			if (onMatch(i))
+			{
+				break;
+			}
+			i++;
 		}
+		else i += std::max(ptrdiff_t(1), j - pattern.skip[ptr[j]]);
 	}
-
-	hints.emplace(hash, address);
 }
-#endif
 
-}
+// false if the shard ran into unreadable memory, the matches found up to there are kept
+static bool ScanShardGuarded(const scan_pattern& pattern, uintptr_t first, uintptr_t last, uint32_t maxCount, std::vector<uintptr_t>* out)
+{
+#ifdef _MSC_VER
+	__try
+#endif
+	{
+		ScanShard(pattern, first, last, maxCount, *out);
+	}
+#ifdef _MSC_VER
+	__except ((GetExceptionCode() == EXCEPTION_ACCESS_VIOLATION) ? EXCEPTION_EXECUTE_HANDLER : EXCEPTION_CONTINUE_SEARCH)
+	{
+		return false;
+	}
+#endif
+
+	return true;
+}
+
+namespace details
+{
+
+void basic_pattern_impl::Initialize(std::string_view pattern)
+{
+	// get the hash for the base pattern
+#if PATTERNS_USE_HINTS
+	m_hash = fnv_1()(pattern);
+#endif
+
+	// transform the base pattern from IDA format to canonical format
+	TransformPattern(pattern, m_bytes, m_mask);
+
+#if PATTERNS_USE_HINTS
+	InitializeHints();
+#endif
+}
+
+void basic_pattern_impl::Initialize(const pattern_literal_view& literal)
+{
+	// already transformed at compile time, nothing to parse or allocate
+	m_literal = literal;
+
+#if PATTERNS_USE_HINTS
+	m_hash = literal.hash;
+
+	InitializeHints();
+#endif
+}
+
+#if PATTERNS_USE_HINTS
+void basic_pattern_impl::InitializeHints()
+{
+	// if there's hints, try those first
+	if (m_rangeStart != 0 && m_rangeEnd == 0)
+	{
+		hint_entry hint;
+
+		if (LookupHint(m_rangeStart, m_hash, pattern_size(), hint))
+		{
+			for (uint32_t rva : hint.rvas)
+			{
+				if (!ConsiderHint(m_rangeStart + rva))
+				{
+					m_matches.clear();
+					break;
+				}
+			}
+
+			// if the hints succeeded, we don't need to scan unless a query asks for more than they hold, see EnsureMatches
+			if (!m_matches.empty())
+			{
+				CountHint(true);
+
+				m_hintLimit = static_cast<uint32_t>(m_matches.size());
+				m_hintComplete = hint.complete;
+				return;
+			}
+		}
+
+		CountHint(false);
+	}
+}
+#endif
+
+void basic_pattern_impl::EnsureMatches(uint32_t maxCount)
+{
+	if (m_matched || (!m_rangeStart && !m_rangeEnd))
+	{
+		return;
+	}
+
+#if PATTERNS_USE_HINTS
+	// A hint answers a query when it holds every match or at least maxCount of them. Either way the result is cut to
+	// maxCount, the matches a scan stopping there would have found, whatever count the recording query asked for.
+	// A partial hint with fewer matches than asked for is dropped and the range scanned.
+	if (m_hintLimit != 0)
+	{
+		if (m_hintComplete || maxCount <= m_hintLimit)
+		{
+			if (m_matches.size() > maxCount)
+			{
+				m_matches.erase(m_matches.begin() + maxCount, m_matches.end());
+			}
+
+			m_matched = true;
+			return;
+		}
+
+		m_matches.clear();
+		m_hintLimit = 0;
+	}
+#endif
+
+	// scan the executable for code
+	executable_meta executable = m_rangeStart != 0 && m_rangeEnd != 0 ? executable_meta(m_rangeStart, m_rangeEnd) : executable_meta(m_rangeStart);
+
+	const uint8_t* pattern = pattern_bytes();
+	const uint8_t* mask = pattern_mask();
+	const size_t maskSize = pattern_size();
+	const std::basic_string_view<uint8_t> maskView(mask, maskSize);
+
+	// literals come with the skip table precomputed
+	ptrdiff_t LastStorage[256];
+	const ptrdiff_t* Last = m_literal.skip;
+
+	if (!Last)
+	{
+		const size_t lastWild = maskView.find_last_not_of(uint8_t(0xFF));
+
+		std::fill(std::begin(LastStorage), std::end(LastStorage), lastWild == std::string::npos ? -1 : static_cast<ptrdiff_t>(lastWild) );
+
+		for ( ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(maskSize); ++i )
+		{
+			if ( LastStorage[ pattern[i] ] < i )
+			{
+				LastStorage[ pattern[i] ] = i;
+			}
+		}
+
+		Last = LastStorage;
+	}
+
+	scan_pattern scan{ pattern, mask, maskSize, Last };
+
+#if !defined(PATTERNS_DISABLE_SIMD)
+	// anchor on the first and last fixed bytes; a pattern made only of wildcards stays on the scalar path
+	scan.firstFixed = maskView.find(uint8_t(0xFF));
+	scan.lastFixed = maskView.find_last_of(uint8_t(0xFF));
+	scan.isa = scan.firstFixed != std::string::npos ? GetScanISA() : scan_isa::scalar;
+#endif
+
+	if (executable.end() >= executable.begin() + maskSize)
+	{
+		const uintptr_t first = executable.begin();
+		const uintptr_t last = executable.end() - maskSize;
+
+		const size_t shards = GetShardCount(last - first + 1);
+
+		std::vector<std::vector<uintptr_t>> results(shards);
+		std::vector<char> completed(shards);
+
+		// once a shard alone has maxCount matches, the shards after it can't contribute any
+		std::atomic<size_t> satisfied{ SIZE_MAX };
+
+		details::scan_parallel_for(shards, [&] (size_t index)
+		{
+			if (index > satisfied.load(std::memory_order_relaxed))
+			{
+				return;
+			}
+
+			const uintptr_t shardFirst = first + index * scan_shard_size;
+			const uintptr_t shardLast = index == shards - 1 ? last : shardFirst + scan_shard_size - 1;
+
+			completed[index] = ScanShardGuarded(scan, shardFirst, shardLast, maxCount, &results[index]);
+
+			if (results[index].size() >= maxCount)
+			{
+				size_t current = satisfied.load(std::memory_order_relaxed);
+				while (index < current && !satisfied.compare_exchange_weak(current, index, std::memory_order_relaxed));
+			}
+		});
+
+		// stitch the shards together in address order, a fault ends the scan there like it does for a single shard
+		for (size_t index = 0; index < shards && m_matches.size() < maxCount; index++)
+		{
+			for (uintptr_t address : results[index])
+			{
+				if (m_matches.size() == maxCount)
+				{
+					break;
+				}
+
+				m_matches.emplace_back(reinterpret_cast<void*>(address));
+			}
+
+			if (!completed[index])
+			{
+				break;
+			}
+		}
+	}
+
+#if PATTERNS_USE_HINTS
+	if (m_rangeEnd == 0 && !m_matches.empty())
+	{
+		StoreHint(m_rangeStart, m_hash, m_matches, m_matches.size() < maxCount);
+	}
+#endif
+
+	m_matched = true;
+}
+
+bool basic_pattern_impl::ConsiderHint(uintptr_t offset)
+{
+	uint8_t* ptr = reinterpret_cast<uint8_t*>(offset);
+
+#if PATTERNS_CAN_SERIALIZE_HINTS
+	const uint8_t* pattern = pattern_bytes();
+	const uint8_t* mask = pattern_mask();
+
+	for (size_t i = 0, j = pattern_size(); i < j; i++)
+	{
+		if (pattern[i] != (ptr[i] & mask[i]))
+		{
+			return false;
+		}
+	}
+#endif
+
+	m_matches.emplace_back(ptr);
+
+	return true;
+}
+
+}
+
+// prefer the first two consecutive fixed bytes as the anchor, they make the pair filter in scan() exact
+static size_t FindBatchAnchor(const uint8_t* mask, size_t size)
+{
+	for (size_t i = 0; i + 1 < size; i++)
+	{
+		if (mask[i] == 0xFF && mask[i + 1] == 0xFF)
+		{
+			return i;
+		}
+	}
+
+	for (size_t i = 0; i < size; i++)
+	{
+		if (mask[i] == 0xFF)
+		{
+			return i;
+		}
+	}
+
+	return 0;
+}
+
+size_t pattern_batch::add(std::string_view pattern)
+{
+	entry e;
+	TransformPattern(pattern, e.bytes, e.mask);
+
+#if PATTERNS_USE_HINTS
+	e.hash = fnv_1()(pattern);
+#endif
+
+	e.anchor = FindBatchAnchor(e.mask.data(), e.mask.size());
+
+	m_entries.push_back(std::move(e));
+	m_scanned = false;
+
+	return m_entries.size() - 1;
+}
+
+size_t pattern_batch::add(const pattern_literal_view& literal)
+{
+	entry e;
+	e.literal = literal;
+
+#if PATTERNS_USE_HINTS
+	e.hash = literal.hash;
+#endif
+
+	e.anchor = FindBatchAnchor(literal.mask, literal.size);
+
+	m_entries.push_back(std::move(e));
+	m_scanned = false;
+
+	return m_entries.size() - 1;
+}
+
+struct pattern_batch::scan_state
+{
+	// the whole range, patterns may not extend past it
+	uintptr_t begin;
+	uintptr_t end;
+
+	const std::vector<uint32_t>* buckets;
+	const uint32_t* pairFilter;
+	size_t pending;
+};
+
+void pattern_batch::scan()
+{
+	if (m_scanned)
+	{
+		return;
+	}
+
+	m_scanned = true;
+
+	if (!m_rangeStart && !m_rangeEnd)
+	{
+		return;
+	}
+
+	executable_meta executable = m_rangeStart != 0 && m_rangeEnd != 0 ? executable_meta(m_rangeStart, m_rangeEnd) : executable_meta(m_rangeStart);
+
+	// bucket the pending patterns by their anchor byte, and keep a bitmap of the anchor byte and the byte after it
+	// so most positions are rejected with a single bit test
+	std::vector<uint32_t> buckets[256];
+	uint32_t pairFilter[65536 / 32] = {};
+	size_t pending = 0;
+
+#if PATTERNS_USE_HINTS
+	const bool useHints = m_rangeEnd == 0;
+#endif
+
+	for (size_t i = 0; i < m_entries.size(); i++)
+	{
+		entry& e = m_entries[i];
+
+		if (e.match || e.get_size() == 0)
+		{
+			continue;
+		}
+
+#if PATTERNS_USE_HINTS
+		if (useHints)
+		{
+			hint_entry hint;
+
+			if (LookupHint(m_rangeStart, e.hash, e.get_size(), hint) && !hint.rvas.empty() &&
+				MatchAt(reinterpret_cast<const uint8_t*>(m_rangeStart + hint.rvas[0]), e.get_bytes(), e.get_mask(), e.get_size()))
+			{
+				e.match = reinterpret_cast<void*>(m_rangeStart + hint.rvas[0]);
+				CountHint(true);
+				continue;
+			}
+
+			CountHint(false);
+		}
+#endif
+
+		// wildcard-only patterns match at the start of the range, same as hook::pattern
+		const uint8_t* bytes = e.get_bytes();
+		const uint8_t* mask = e.get_mask();
+		const size_t size = e.get_size();
+
+		if (std::find(mask, mask + size, uint8_t(0xFF)) == mask + size)
+		{
+			if (executable.end() - executable.begin() >= size)
+			{
+				e.match = reinterpret_cast<void*>(executable.begin());
+			}
+			continue;
+		}
+
+		buckets[bytes[e.anchor]].push_back(static_cast<uint32_t>(i));
+		pending++;
+
+		if (e.anchor + 1 < size && mask[e.anchor + 1] == 0xFF)
+		{
+			const uint32_t pair = bytes[e.anchor] | (bytes[e.anchor + 1] << 8);
+			pairFilter[pair / 32] |= 1u << (pair % 32);
+		}
+		else
+		{
+			for (uint32_t next = 0; next < 256; next++)
+			{
+				const uint32_t pair = bytes[e.anchor] | (next << 8);
+				pairFilter[pair / 32] |= 1u << (pair % 32);
+			}
+		}
+	}
+
+	if (pending != 0)
+	{
+		const scan_state state{ executable.begin(), executable.end(), buckets, pairFilter, pending };
+		const size_t shards = GetShardCount(executable.end() - executable.begin());
+
+		std::vector<std::vector<void*>> results(shards);
+		std::vector<char> completed(shards);
+
+		details::scan_parallel_for(shards, [&] (size_t index)
+		{
+			const uintptr_t from = executable.begin() + index * scan_shard_size;
+			const uintptr_t to = index == shards - 1 ? executable.end() : from + scan_shard_size;
+
+			results[index].resize(m_entries.size());
+			completed[index] = scan_range(state, from, to, results[index].data());
+		});
+
+		// each entry takes its match from the first shard that has one, a fault ends the scan there
+		for (size_t index = 0; index < shards; index++)
+		{
+			for (size_t i = 0; i < m_entries.size(); i++)
+			{
+				if (!m_entries[i].match)
+				{
+					m_entries[i].match = results[index][i];
+				}
+			}
+
+			if (!completed[index])
+			{
+				break;
+			}
+		}
+	}
+
+#if PATTERNS_USE_HINTS
+	// only the first match is known, so these are stored as partial hints
+	if (useHints)
+	{
+		for (const auto& bucket : buckets)
+		{
+			for (uint32_t index : bucket)
+			{
+				if (m_entries[index].match)
+				{
+					StoreHint(m_rangeStart, m_entries[index].hash, std::vector<uint32_t>{ static_cast<uint32_t>(reinterpret_cast<uintptr_t>(m_entries[index].match) - m_rangeStart) }, false);
+				}
+			}
+		}
+	}
+#endif
+}
+
+bool pattern_batch::scan_range(const scan_state& state, uintptr_t from, uintptr_t to, void** matches) const
+{
+#ifdef _MSC_VER
+	__try
+#endif
+	{
+		scan_range_unguarded(state, from, to, matches);
+	}
+#ifdef _MSC_VER
+	__except ((GetExceptionCode() == EXCEPTION_ACCESS_VIOLATION) ? EXCEPTION_EXECUTE_HANDLER : EXCEPTION_CONTINUE_SEARCH)
+	{
+		return false;
+	}
+#endif
+
+	return true;
+}
+
+void pattern_batch::scan_range_unguarded(const scan_state& state, uintptr_t from, uintptr_t to, void** matches) const
+{
+	const uintptr_t begin = state.begin;
+	const uintptr_t end = state.end;
+	size_t pending = state.pending;
+
+	for (uintptr_t p = from; p < to && pending != 0; p++)
+	{
+		const uint8_t* ptr = reinterpret_cast<const uint8_t*>(p);
+
+		// the last byte has no successor, only patterns that end on their anchor can match there
+		if (p + 1 < end)
+		{
+			const uint32_t pair = ptr[0] | (ptr[1] << 8);
+
+			if ((state.pairFilter[pair / 32] & (1u << (pair % 32))) == 0)
+			{
+				continue;
+			}
+		}
+
+		const auto& bucket = state.buckets[ptr[0]];
+
+		for (uint32_t index : bucket)
+		{
+			const entry& e = m_entries[index];
+
+			if (matches[index])
+			{
+				continue;
+			}
+
+			// the anchor sits at a fixed offset in each pattern, so its matches are still found in ascending order
+			if (p - begin < e.anchor)
+			{
+				continue;
+			}
+
+			const uintptr_t start = p - e.anchor;
+
+			if (end - start < e.get_size())
+			{
+				continue;
+			}
+
+			if (MatchAt(reinterpret_cast<const uint8_t*>(start), e.get_bytes(), e.get_mask(), e.get_size()))
+			{
+				matches[index] = reinterpret_cast<void*>(start);
+				pending--;
+			}
+		}
+	}
+}
+
+#if PATTERNS_USE_HINTS
+hint_cache_stats get_hint_cache_stats()
+{
+	std::lock_guard<std::mutex> lock(g_hintsMutex);
+	return g_hintStats;
+}
+
+#if PATTERNS_CAN_SERIALIZE_HINTS
+// file layout: magic, entry count, then per entry the hint_key fields, the complete flag, the rva count and the rvas
+static constexpr char hint_cache_magic[4] = { 'H', 'P', 'C', '1' };
+
+bool load_hint_cache(const wchar_t* path)
+{
+	FILE* f = _wfopen(path, L"rb");
+	if (!f)
+	{
+		return false;
+	}
+
+	std::map<hint_key, hint_entry> hints;
+	char magic[4];
+	uint32_t count = 0;
+	bool ok = fread(magic, sizeof(magic), 1, f) == 1 && memcmp(magic, hint_cache_magic, sizeof(magic)) == 0 &&
+		fread(&count, sizeof(count), 1, f) == 1;
+
+	for (uint32_t i = 0; ok && i < count; i++)
+	{
+		hint_key key{};
+		hint_entry entry;
+		uint8_t complete = 0;
+		uint32_t rvaCount = 0;
+
+		ok = fread(&key.timestamp, sizeof(key.timestamp), 1, f) == 1 &&
+			fread(&key.checksum, sizeof(key.checksum), 1, f) == 1 &&
+			fread(&key.imageSize, sizeof(key.imageSize), 1, f) == 1 &&
+			fread(&key.hash, sizeof(key.hash), 1, f) == 1 &&
+			fread(&complete, sizeof(complete), 1, f) == 1 &&
+			fread(&rvaCount, sizeof(rvaCount), 1, f) == 1 &&
+			rvaCount != 0 && rvaCount <= 0x10000;
+
+		if (ok)
+		{
+			entry.rvas.resize(rvaCount);
+			entry.complete = complete != 0;
+			ok = fread(entry.rvas.data(), sizeof(uint32_t), rvaCount, f) == rvaCount;
+		}
+
+		if (ok)
+		{
+			hints.emplace(key, std::move(entry));
+		}
+	}
+
+	fclose(f);
+
+	if (!ok)
+	{
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(g_hintsMutex);
+
+	// hints recorded before the load (from scans that already ran) win over the file
+	getHints().merge(hints);
+	g_hintStats.loaded = count;
+
+	return true;
+}
+
+bool save_hint_cache(const wchar_t* path)
+{
+	std::lock_guard<std::mutex> lock(g_hintsMutex);
+
+	if (!g_hintsDirty)
+	{
+		return true;
+	}
+
+	FILE* f = _wfopen(path, L"wb");
+	if (!f)
+	{
+		return false;
+	}
+
+	const auto& hints = getHints();
+	const uint32_t count = static_cast<uint32_t>(hints.size());
+
+	fwrite(hint_cache_magic, sizeof(hint_cache_magic), 1, f);
+	fwrite(&count, sizeof(count), 1, f);
+
+	for (const auto& [key, entry] : hints)
+	{
+		const uint8_t complete = entry.complete ? 1 : 0;
+		const uint32_t rvaCount = static_cast<uint32_t>(entry.rvas.size());
+
+		fwrite(&key.timestamp, sizeof(key.timestamp), 1, f);
+		fwrite(&key.checksum, sizeof(key.checksum), 1, f);
+		fwrite(&key.imageSize, sizeof(key.imageSize), 1, f);
+		fwrite(&key.hash, sizeof(key.hash), 1, f);
+		fwrite(&complete, sizeof(complete), 1, f);
+		fwrite(&rvaCount, sizeof(rvaCount), 1, f);
+		fwrite(entry.rvas.data(), sizeof(uint32_t), rvaCount, f);
+	}
+
+	const bool ok = ferror(f) == 0;
+	fclose(f);
+
+	if (ok)
+	{
+		g_hintsDirty = false;
+	}
+
+	return ok;
+}
+#endif
+#endif
 }
\ No newline at end of file
@@ -8,10 +8,15 @@
 #pragma once
 
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <vector>
 #include <string>
 #include <string_view>
 
+#include "pattern_literal.h"
+
 #if defined(_CPPUNWIND) && !defined(PATTERNS_SUPPRESS_EXCEPTIONS)
 #define PATTERNS_ENABLE_EXCEPTIONS
 #endif
@@ -64,14 +69,31 @@ namespace hook
 	{
 		ptrdiff_t get_process_base();
 
+		// Large scans are split into shards that run on a small pool of worker threads.
+		// False while the calling thread holds the loader lock (DllMain): workers can't start before it is released,
+		// so everything runs on the calling thread then. Also false from inside a scan_parallel_for job.
+		bool scan_workers_available();
+
+		// Calls fn(0) .. fn(count - 1) on the workers and the calling thread and returns once all of them are done.
+		// Runs them in order on the calling thread when scan_workers_available() is false.
+		void scan_parallel_for(size_t count, const std::function<void(size_t)>& fn);
+
 		class basic_pattern_impl
 		{
 		protected:
 			std::basic_string<uint8_t> m_bytes;
 			std::basic_string<uint8_t> m_mask;
 
+			// set for compile-time patterns, m_bytes/m_mask stay empty then
+			pattern_literal_view m_literal{};
+
 #if PATTERNS_USE_HINTS
 			uint64_t m_hash = 0;
+
+			// set when m_matches came from a hint: the number of matches it holds, and whether those are all matches in
+			// the module (otherwise the scan that recorded it stopped there)
+			uint32_t m_hintLimit = 0;
+			bool m_hintComplete = false;
 #endif
 
 			std::vector<pattern_match> m_matches;
@@ -84,6 +106,27 @@ namespace hook
 		protected:
 			void Initialize(std::string_view pattern);
 
+			void Initialize(const pattern_literal_view& literal);
+
+#if PATTERNS_USE_HINTS
+			void InitializeHints();
+#endif
+
+			inline const uint8_t* pattern_bytes() const
+			{
+				return m_literal.bytes ? m_literal.bytes : m_bytes.data();
+			}
+
+			inline const uint8_t* pattern_mask() const
+			{
+				return m_literal.bytes ? m_literal.mask : m_mask.data();
+			}
+
+			inline size_t pattern_size() const
+			{
+				return m_literal.bytes ? m_literal.size : m_mask.size();
+			}
+
 			bool ConsiderHint(uintptr_t offset);
 
 			void EnsureMatches(uint32_t maxCount);
@@ -123,6 +166,24 @@ namespace hook
 				Initialize(std::move(pattern));
 			}
 
+			explicit basic_pattern_impl(const pattern_literal_view& literal)
+				: basic_pattern_impl(get_process_base())
+			{
+				Initialize(literal);
+			}
+
+			inline basic_pattern_impl(void* module, const pattern_literal_view& literal)
+				: basic_pattern_impl(reinterpret_cast<uintptr_t>(module))
+			{
+				Initialize(literal);
+			}
+
+			inline basic_pattern_impl(uintptr_t begin, uintptr_t end, const pattern_literal_view& literal)
+				: basic_pattern_impl(begin, end)
+			{
+				Initialize(literal);
+			}
+
 			// Pretransformed patterns
 			inline basic_pattern_impl(std::basic_string_view<uint8_t> bytes, std::basic_string_view<uint8_t> mask)
 				: basic_pattern_impl(get_process_base())
@@ -132,11 +193,6 @@ namespace hook
 				m_mask = std::move(mask);
 			}
 
-		protected:
-#if PATTERNS_USE_HINTS && PATTERNS_CAN_SERIALIZE_HINTS
-			// define a hint
-			static void hint(uint64_t hash, uintptr_t address);
-#endif
 		};
 	}
 
@@ -169,6 +225,10 @@ namespace hook
 
 			m_matches.clear();
 			m_matched = false;
+#if PATTERNS_USE_HINTS
+			m_hintLimit = 0;
+			m_hintComplete = false;
+#endif
 			return std::forward<basic_pattern>(*this);
 		}
 
@@ -197,7 +257,7 @@ namespace hook
 		template<typename T = void>
 		inline auto get_first(ptrdiff_t offset = 0)
 		{
-			return get_one().get<T>(offset);
+			return get_one().template get<T>(offset);
 		}
 
 		template <typename Pred>
@@ -211,14 +271,6 @@ namespace hook
 			return std::forward<Pred>(pred);
 		}
 
-	public:
-#if PATTERNS_USE_HINTS && PATTERNS_CAN_SERIALIZE_HINTS
-		// define a hint
-		static void hint(uint64_t hash, uintptr_t address)
-		{
-			details::basic_pattern_impl::hint(hash, address);
-		}
-#endif
 	};
 
 	using pattern = basic_pattern<assert_err_policy>;
@@ -249,6 +301,22 @@ namespace hook
 		return make_range_pattern(begin, end, std::move(bytes));
 	}
 
+	template<typename T = void>
+	inline auto get_pattern(const pattern_literal_view& literal, ptrdiff_t offset = 0)
+	{
+		return pattern(literal).get_first<T>(offset);
+	}
+
+	inline auto module_pattern(void* module, const pattern_literal_view& literal)
+	{
+		return pattern(module, literal);
+	}
+
+	inline auto range_pattern(uintptr_t begin, uintptr_t end, const pattern_literal_view& literal)
+	{
+		return pattern(begin, end, literal);
+	}
+
 	namespace txn
 	{
 		using pattern = hook::basic_pattern<exception_err_policy>;
@@ -278,5 +346,131 @@ namespace hook
 		{
 			return make_range_pattern(begin, end, std::move(bytes));
 		}
+
+		template<typename T = void>
+		inline auto get_pattern(const pattern_literal_view& literal, ptrdiff_t offset = 0)
+		{
+			return pattern(literal).get_first<T>(offset);
+		}
+
+		inline auto module_pattern(void* module, const pattern_literal_view& literal)
+		{
+			return pattern(module, literal);
+		}
+
+		inline auto range_pattern(uintptr_t begin, uintptr_t end, const pattern_literal_view& literal)
+		{
+			return pattern(begin, end, literal);
+		}
 	}
+
+	// Resolves many patterns against one module in a single pass over its code, instead of one full scan per
+	// hook::pattern. Only the first match of each pattern is recorded.
+	class pattern_batch
+	{
+	private:
+		struct entry
+		{
+			std::basic_string<uint8_t> bytes;
+			std::basic_string<uint8_t> mask;
+
+			// set for compile-time patterns instead of bytes/mask
+			pattern_literal_view literal{};
+
+			size_t anchor = 0;
+			void* match = nullptr;
+
+#if PATTERNS_USE_HINTS
+			uint64_t hash = 0;
+#endif
+
+			inline const uint8_t* get_bytes() const
+			{
+				return literal.bytes ? literal.bytes : bytes.data();
+			}
+
+			inline const uint8_t* get_mask() const
+			{
+				return literal.bytes ? literal.mask : mask.data();
+			}
+
+			inline size_t get_size() const
+			{
+				return literal.bytes ? literal.size : bytes.size();
+			}
+		};
+
+		std::vector<entry> m_entries;
+
+		uintptr_t m_rangeStart;
+		uintptr_t m_rangeEnd;
+
+		bool m_scanned = false;
+
+		struct scan_state;
+
+	private:
+		// scans anchor positions [from, to) into 'matches' (one slot per entry), false if it hit unreadable memory
+		bool scan_range(const scan_state& state, uintptr_t from, uintptr_t to, void** matches) const;
+
+		void scan_range_unguarded(const scan_state& state, uintptr_t from, uintptr_t to, void** matches) const;
+
+	public:
+		explicit pattern_batch(void* module)
+			: m_rangeStart(reinterpret_cast<uintptr_t>(module)), m_rangeEnd(0)
+		{
+		}
+
+		pattern_batch(uintptr_t begin, uintptr_t end)
+			: m_rangeStart(begin), m_rangeEnd(end)
+		{
+		}
+
+		// returns the index to query the result with
+		size_t add(std::string_view pattern);
+
+		size_t add(const pattern_literal_view& literal);
+
+		void scan();
+
+		inline size_t size() const
+		{
+			return m_entries.size();
+		}
+
+		inline bool empty(size_t index)
+		{
+			scan();
+			return m_entries[index].match == nullptr;
+		}
+
+		template<typename T = void>
+		inline T* get_first(size_t index, ptrdiff_t offset = 0)
+		{
+			scan();
+			assert(m_entries[index].match != nullptr);
+			return pattern_match(m_entries[index].match).get<T>(offset);
+		}
+	};
+
+#if PATTERNS_USE_HINTS
+	// Hints are stored per module fingerprint (PE timestamp, checksum and image size) as RVAs. A pattern whose
+	// module and hash have a hint is verified at that address instead of scanning the module.
+	struct hint_cache_stats
+	{
+		uint32_t loaded;
+		uint32_t hits;
+		uint32_t misses;
+		uint32_t stored;
+	};
+
+	hint_cache_stats get_hint_cache_stats();
+
+#if PATTERNS_CAN_SERIALIZE_HINTS
+	bool load_hint_cache(const wchar_t* path);
+
+	// only writes the file if hints were added since it was loaded
+	bool save_hint_cache(const wchar_t* path);
+#endif
+#endif
 }
\ No newline at end of file
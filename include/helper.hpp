@@ -16,15 +16,16 @@
 #include <bit>
 #include <chrono>
 #include <cctype>
-#include <future>
 #include <unordered_map>
 #include <mutex>
 #include <shared_mutex>
 #include <initializer_list>
 #include <thread>
+#include <atomic>
 #include <filesystem>
 #include <stdexcept>
 #include <cassert>
+#include "Hooking.Patterns.h"
 
 
 template<typename T>
@@ -213,18 +214,56 @@ namespace Memory
 		return bytes;
 	}
 
-	inline std::uint8_t* PatternScan(void* module, const char* signature)
+	// first match starting in [first, last], the pattern may run up to s - 1 bytes past 'last'
+	inline std::uint8_t* PatternScanRange(std::uint8_t* first, std::uint8_t* last, const std::uint8_t* patternBytes, const std::uint8_t* patternMask, std::size_t s, std::size_t anchor_index, int anchor_value)
 	{
-		if (!module || !signature)
+		std::uint8_t* memchr_search_start = first + anchor_index;
+
+		std::uint8_t* memchr_search_end = last + anchor_index;
+
+		std::uint8_t* p = memchr_search_start;
+
+		while (p <= memchr_search_end)
 		{
-			return nullptr;
-		}
+			void* found = std::memchr(p, static_cast<int>(anchor_value), static_cast<std::size_t>(memchr_search_end - p + 1));
+
+			if (!found)
+			{
+				break;
+			}
+
+			std::uint8_t* foundByte = reinterpret_cast<std::uint8_t*>(found);
+
+			std::uint8_t* candidate = foundByte - anchor_index;
+
+			bool ok = true;
 
-		auto patternBytes = get_pattern_bytes_cached(signature);
+			for (std::size_t j = 0; j < s; ++j)
+			{
+				if ((candidate[j] & patternMask[j]) != patternBytes[j])
+				{
+					ok = false;
+					break;
+				}
+			}
+
+			if (ok)
+			{
+				return candidate;
+			}
 
-		const std::size_t s = patternBytes.size();
+			p = foundByte + 1;
+		}
 
-		if (s == 0)
+		return nullptr;
+	}
+
+	// core scanner, 'mask' is 0xFF for fixed bytes and 0x00 for wildcards (wildcard bytes are 0)
+	// The committed regions are collected first and cut into shards of start positions, large modules are then
+	// scanned on the hook::pattern worker pool. The result is still the first match in section order.
+	inline std::uint8_t* PatternScan(void* module, const std::uint8_t* patternBytes, const std::uint8_t* patternMask, std::size_t s)
+	{
+		if (!module || !patternBytes || s == 0)
 		{
 			return nullptr;
 		}
@@ -235,7 +274,7 @@ namespace Memory
 
 		for (std::size_t i = 0; i < s; ++i)
 		{
-			if (patternBytes[i] != -1)
+			if (patternMask[i] == 0xFF)
 			{
 				anchor_index = i; anchor_value = patternBytes[i];
 				break;
@@ -284,6 +323,18 @@ namespace Memory
 			}
 		}
 
+		constexpr std::size_t shard_size = 256 * 1024;
+
+		struct Shard
+		{
+			std::uint8_t* first;
+			std::uint8_t* last;
+		};
+
+		std::vector<Shard> shards;
+
+		std::size_t totalSize = 0;
+
 		for (unsigned idx = 0; idx < order.size(); ++idx)
 		{
 			PIMAGE_SECTION_HEADER sh = &firstSection[order[idx]];
@@ -343,66 +394,95 @@ namespace Memory
 						return rStart;
 					}
 
-					std::uint8_t* lastPossible = rEnd - s;
-
-					if (lastPossible < rStart)
+					// a match has to fit in the region, shards only split the start positions
+					if (rEnd - rStart >= static_cast<std::ptrdiff_t>(s))
 					{
+						std::uint8_t* lastPossible = rEnd - s;
 
-					}
-					else
-					{
-						std::uint8_t* memchr_search_start = rStart + anchor_index;
+						for (std::uint8_t* first = rStart; first <= lastPossible; first += (std::min)(shard_size, static_cast<std::size_t>(lastPossible - first) + 1))
+						{
+							shards.push_back({ first, first + (std::min)(shard_size - 1, static_cast<std::size_t>(lastPossible - first)) });
+						}
 
-						std::uint8_t* memchr_search_end = lastPossible + anchor_index;
+						totalSize += static_cast<std::size_t>(lastPossible - rStart) + 1;
+					}
+				}
 
-						std::uint8_t* p = memchr_search_start;
+				if (regionTop <= queryPtr)
+				{
+					break;
+				}
 
-						while (p <= memchr_search_end)
-						{
-							void* found = std::memchr(p, static_cast<int>(anchor_value), static_cast<std::size_t>(memchr_search_end - p + 1));
+				queryPtr = regionTop;
+			}
+		}
 
-							if (!found)
-							{
-								break;
-							}
+		if (totalSize < 2 * shard_size || !hook::details::scan_workers_available())
+		{
+			for (const auto& shard : shards)
+			{
+				if (std::uint8_t* found = PatternScanRange(shard.first, shard.last, patternBytes, patternMask, s, anchor_index, anchor_value))
+				{
+					return found;
+				}
+			}
 
-							std::uint8_t* foundByte = reinterpret_cast<std::uint8_t*>(found);
+			return nullptr;
+		}
 
-							std::uint8_t* candidate = foundByte - anchor_index;
+		std::vector<std::uint8_t*> results(shards.size(), nullptr);
 
-							bool ok = true;
+		// shards after one that found a match can't hold the first one
+		std::atomic<std::size_t> firstHit{ SIZE_MAX };
 
-							for (std::size_t j = 0; j < s; ++j)
-							{
-								int pb = patternBytes[j];
+		hook::details::scan_parallel_for(shards.size(), [&](std::size_t index)
+			{
+				if (index > firstHit.load(std::memory_order_relaxed))
+				{
+					return;
+				}
 
-								if (pb != -1 && candidate[j] != static_cast<std::uint8_t>(pb))
-								{
-									ok = false;
-									break;
-								}
-							}
+				results[index] = PatternScanRange(shards[index].first, shards[index].last, patternBytes, patternMask, s, anchor_index, anchor_value);
 
-							if (ok)
-							{
-								return candidate;
-							}
+				if (results[index])
+				{
+					std::size_t current = firstHit.load(std::memory_order_relaxed);
 
-							p = foundByte + 1;
-						}
+					while (index < current && !firstHit.compare_exchange_weak(current, index, std::memory_order_relaxed))
+					{
 					}
 				}
+			});
 
-				if (regionTop <= queryPtr)
-				{
-					break;
-				}
+		const std::size_t hit = firstHit.load();
 
-				queryPtr = regionTop;
-			}
+		return hit != SIZE_MAX ? results[hit] : nullptr;
+	}
+
+	inline std::uint8_t* PatternScan(void* module, const hook::pattern_literal_view& pattern)
+	{
+		return PatternScan(module, pattern.bytes, pattern.mask, pattern.size);
+	}
+
+	inline std::uint8_t* PatternScan(void* module, const char* signature)
+	{
+		if (!module || !signature)
+		{
+			return nullptr;
 		}
 
-		return nullptr;
+		auto patternInts = get_pattern_bytes_cached(signature);
+
+		std::vector<std::uint8_t> patternBytes(patternInts.size());
+		std::vector<std::uint8_t> patternMask(patternInts.size());
+
+		for (std::size_t i = 0; i < patternInts.size(); ++i)
+		{
+			patternBytes[i] = patternInts[i] != -1 ? static_cast<std::uint8_t>(patternInts[i]) : 0;
+			patternMask[i] = patternInts[i] != -1 ? 0xFF : 0x00;
+		}
+
+		return PatternScan(module, patternBytes.data(), patternMask.data(), patternBytes.size());
 	}
 
 	template<typename... Sigs, typename = std::enable_if_t<(std::is_convertible_v<Sigs, const char*> && ...)>>
@@ -495,59 +575,22 @@ namespace Memory
 			}
 		}
 
-		if (tasks.size() <= 1)
-		{
-			std::vector<std::uint8_t*> results;
-
-			results.reserve(tasks.size());
-
-			for (const auto& t : tasks)
-			{
-				if (!t.module)
-				{
-
-					results.push_back(nullptr);
-
-					continue;
-				}
-
-				results.push_back(PatternScan(t.module, t.sig));
-			}
-
-			return results;
-		}
-
-		std::vector<std::future<std::uint8_t*>> futures;
+		// each scan already spreads its module over the worker pool, one thread per signature on top of that
+		// only fights over the same cores
+		std::vector<std::uint8_t*> results;
 
-		futures.reserve(tasks.size());
+		results.reserve(tasks.size());
 
 		for (const auto& t : tasks)
 		{
 			if (!t.module)
-			{
-				futures.emplace_back(std::async(std::launch::deferred, []() -> std::uint8_t* { return nullptr; }));
-				continue;
-			}
-
-			futures.emplace_back(std::async(std::launch::async, [m = t.module, s = t.sig]() -> std::uint8_t*
-				{
-					return PatternScan(m, s);
-				}));
-		}
-
-		std::vector<std::uint8_t*> results;
-
-		results.reserve(futures.size());
-
-		for (size_t i = 0; i < futures.size(); ++i)
-		{
-			if (!tasks[i].module)
 			{
 				results.push_back(nullptr);
+
 				continue;
 			}
 
-			results.push_back(futures[i].get());
+			results.push_back(PatternScan(t.module, t.sig));
 		}
 
 		return results;
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Compile-time IDA-style patterns: "8B 15 ? ? ? ? 8B 42"_sig is parsed into byte/mask arrays and a skip table by
+// the compiler and lives in read-only data, so constructing a hook::pattern or calling Memory::PatternScan with it
+// parses and allocates nothing. A malformed literal is a build error.
+//
+// Tokens are separated by spaces, a token is two hex digits or a "?" wildcard byte. The runtime parser reads every
+// '?' as a byte of its own, so "??" (one byte in IDA, two at runtime) is rejected rather than guessed at.
+
+namespace hook
+{
+	// what hook::pattern, hook::pattern_batch and Memory::PatternScan take, points into static storage
+	struct pattern_literal_view
+	{
+		const uint8_t* bytes;
+		const uint8_t* mask;
+
+		// Boyer-Moore-Horspool table, built the same way EnsureMatches builds it for runtime patterns
+		const ptrdiff_t* skip;
+
+		size_t size;
+
+		// FNV-1 of the source text, same as the hint hash of the equivalent runtime pattern
+		uint64_t hash;
+
+		const char* text;
+	};
+
+	namespace details
+	{
+		template<size_t N>
+		struct pattern_string
+		{
+			char value[N];
+
+			consteval pattern_string(const char (&str)[N])
+			{
+				for (size_t i = 0; i < N; i++)
+				{
+					value[i] = str[i];
+				}
+			}
+		};
+
+		consteval bool is_pattern_hex(char ch)
+		{
+			return (ch >= '0' && ch <= '9') || (ch >= 'A' && ch <= 'F') || (ch >= 'a' && ch <= 'f');
+		}
+
+		consteval uint8_t pattern_hex_value(char ch)
+		{
+			if (ch >= 'A' && ch <= 'F') return uint8_t(ch - 'A' + 10);
+			if (ch >= 'a' && ch <= 'f') return uint8_t(ch - 'a' + 10);
+			return uint8_t(ch - '0');
+		}
+
+		struct pattern_parse_result
+		{
+			size_t count;
+			const char* error;
+		};
+
+		// Calls 'emit(byte, mask)' per token, stops at the first malformed one
+		template<size_t N, typename TEmit>
+		consteval pattern_parse_result parse_pattern(const pattern_string<N>& str, TEmit&& emit)
+		{
+			size_t count = 0;
+			size_t i = 0;
+
+			while (i + 1 < N)
+			{
+				if (str.value[i] == ' ')
+				{
+					i++;
+					continue;
+				}
+
+				size_t length = 0;
+				while (i + length + 1 < N && str.value[i + length] != ' ')
+				{
+					length++;
+				}
+
+				const char first = str.value[i];
+				const char second = length > 1 ? str.value[i + 1] : '\0';
+
+				if (length == 1 && first == '?')
+				{
+					emit(uint8_t(0), uint8_t(0));
+				}
+				else if (length == 2 && is_pattern_hex(first) && is_pattern_hex(second))
+				{
+					emit(uint8_t((pattern_hex_value(first) << 4) | pattern_hex_value(second)), uint8_t(0xFF));
+				}
+				else if (first == '?')
+				{
+					return { count, "ambiguous wildcard in pattern literal, write one \"?\" per byte" };
+				}
+				else
+				{
+					return { count, "malformed pattern literal, expected two hex digits or a \"?\" wildcard" };
+				}
+
+				count++;
+				i += length;
+			}
+
+			if (count == 0)
+			{
+				return { 0, "empty pattern literal" };
+			}
+
+			return { count, nullptr };
+		}
+
+		template<size_t N>
+		consteval const char* pattern_error(const pattern_string<N>& str)
+		{
+			return parse_pattern(str, [](uint8_t, uint8_t) {}).error;
+		}
+
+		// Throwing is not allowed in a constant expression, so a malformed pattern stops compilation here
+		template<size_t N>
+		consteval size_t pattern_size(const pattern_string<N>& str)
+		{
+			const pattern_parse_result result = parse_pattern(str, [](uint8_t, uint8_t) {});
+			if (result.error)
+			{
+				throw result.error;
+			}
+
+			return result.count;
+		}
+
+		template<pattern_string Str>
+		struct pattern_literal
+		{
+			static constexpr size_t size = pattern_size(Str);
+
+			uint8_t bytes[size] = {};
+			uint8_t mask[size] = {};
+			ptrdiff_t skip[256] = {};
+			uint64_t hash = 0;
+
+			consteval pattern_literal()
+			{
+				size_t index = 0;
+				parse_pattern(Str, [&](uint8_t byte, uint8_t byteMask)
+				{
+					bytes[index] = byte;
+					mask[index] = byteMask;
+					index++;
+				});
+
+				ptrdiff_t lastWild = -1;
+				for (size_t i = 0; i < size; i++)
+				{
+					if (mask[i] != 0xFF)
+					{
+						lastWild = ptrdiff_t(i);
+					}
+				}
+
+				for (auto& entry : skip)
+				{
+					entry = lastWild;
+				}
+
+				for (size_t i = 0; i < size; i++)
+				{
+					if (skip[bytes[i]] < ptrdiff_t(i))
+					{
+						skip[bytes[i]] = ptrdiff_t(i);
+					}
+				}
+
+				hash = 14695981039346656037u;
+				for (size_t i = 0; Str.value[i] != '\0'; i++)
+				{
+					hash *= 1099511628211u;
+					hash ^= uint64_t(Str.value[i]);
+				}
+			}
+		};
+
+		template<pattern_string Str>
+		inline constexpr pattern_literal<Str> pattern_literal_storage{};
+	}
+
+	inline namespace literals
+	{
+		template<details::pattern_string Str>
+		constexpr pattern_literal_view operator""_sig()
+		{
+			constexpr const auto& literal = details::pattern_literal_storage<Str>;
+			return { literal.bytes, literal.mask, literal.skip, literal.size, literal.hash, Str.value };
+		}
+	}
+
+	// the forms a literal takes, each parsed the way TransformPattern parses the same text at runtime
+	static_assert(details::pattern_size(details::pattern_string("8B 42")) == 2, "two hex digits are one byte");
+	static_assert(details::pattern_size(details::pattern_string("8B ? 42")) == 3, "\"?\" is one wildcard byte");
+	static_assert(details::pattern_size(details::pattern_string("  8B  ?  ")) == 2, "runs of spaces separate tokens");
+	static_assert(details::pattern_error(details::pattern_string("8B ?? 42")) != nullptr, "\"??\" is two bytes at runtime, one in IDA");
+	static_assert(details::pattern_error(details::pattern_string("8B ?? ?")) != nullptr, "\"??\" is rejected anywhere");
+	static_assert(details::pattern_error(details::pattern_string("8B42")) != nullptr, "a token is exactly one byte");
+	static_assert(details::pattern_error(details::pattern_string("8B 4")) != nullptr, "a lone hex digit is rejected");
+	static_assert(details::pattern_error(details::pattern_string("8B G2")) != nullptr, "non-hex digits are rejected");
+	static_assert(details::pattern_error(details::pattern_string("   ")) != nullptr, "an empty pattern is rejected");
+}
@@ -1112,6 +1112,18 @@ SystemInfo system_info() {
     return info;
 }
 
+// no trapping on linux, batches only exist for the api
+void begin_trap_batch() {
+}
+
+bool trap_batch_unprotect(uint8_t* address, size_t len) {
+    return vm_protect(address, len, VM_ACCESS_RWX).has_value();
+}
+
+size_t end_trap_batch() {
+    return 0;
+}
+
 void trap_threads([[maybe_unused]] uint8_t* from, [[maybe_unused]] uint8_t* to, [[maybe_unused]] size_t len,
     const std::function<void()>& run_fn) {
     auto from_protect = vm_protect(from, len, VM_ACCESS_RWX).value_or(0);
@@ -1135,6 +1147,7 @@ void fix_ip([[maybe_unused]] ThreadContext ctx, [[maybe_unused]] uint8_t* old_ip
 #include <map>
 #include <memory>
 #include <mutex>
+#include <set>
 
 
 #if SAFETYHOOK_OS_WINDOWS
@@ -1341,6 +1354,14 @@ public:
         return nullptr;
     }
 
+    bool is_held_page(uint8_t* address) {
+        return m_held_pages.count(align_down(address, 0x1000)) != 0;
+    }
+
+    // Pages patched by a trap batch, threads executing there wait until the batch restores them
+    void hold_page(uint8_t* page) { m_held_pages.insert(align_down(page, 0x1000)); }
+    void release_held_pages() { m_held_pages.clear(); }
+
     void add_trap(uint8_t* from, uint8_t* to, size_t len) {
         TrapInfo info{};
         info.from_page_start = align_down(from, 0x1000);
@@ -1356,6 +1377,7 @@ public:
 
 private:
     std::map<uint8_t*, TrapInfo> m_traps;
+    std::set<uint8_t*> m_held_pages;
     PVOID m_trap_veh{};
 
     static LONG CALLBACK trap_handler(PEXCEPTION_POINTERS exp) {
@@ -1370,7 +1392,7 @@ private:
         auto* trap = instance->find_trap(faulting_address);
 
         if (trap == nullptr) {
-            if (instance->find_trap_page(faulting_address) != nullptr) {
+            if (instance->find_trap_page(faulting_address) != nullptr || instance->is_held_page(faulting_address)) {
                 return EXCEPTION_CONTINUE_EXECUTION;
             } else {
                 return EXCEPTION_CONTINUE_SEARCH;
@@ -1394,6 +1416,118 @@ bool TrapManager::is_destructed = false;
 void find_me() {
 }
 
+// PAGE_READWRITE keeps other threads out of a page, but this module and VirtualProtect itself have to stay
+// executable for the thread changing the protection.
+static DWORD trap_protection(uint8_t* start, uint8_t* end) {
+    MEMORY_BASIC_INFORMATION find_me_mbi{};
+    MEMORY_BASIC_INFORMATION mbi{};
+
+    VirtualQuery(reinterpret_cast<void*>(find_me), &find_me_mbi, sizeof(find_me_mbi));
+    VirtualQuery(start, &mbi, sizeof(mbi));
+
+    if (mbi.AllocationBase == find_me_mbi.AllocationBase) {
+        return PAGE_EXECUTE_READWRITE;
+    }
+
+    auto* vp_start = reinterpret_cast<uint8_t*>(&VirtualProtect);
+    auto* vp_end = vp_start + 0x20;
+
+    if (!(end < vp_start || vp_end < start)) {
+        return PAGE_EXECUTE_READWRITE;
+    }
+
+    return PAGE_READWRITE;
+}
+
+struct TrapBatchPage {
+    DWORD original;
+    DWORD current;
+};
+
+static thread_local bool t_trap_batch_active = false;
+static thread_local std::map<uint8_t*, TrapBatchPage> t_trap_batch_pages;
+
+// Gives every page of [address, address + len) its trapping protection until end_trap_batch(), whatever an earlier
+// write in the batch left it at.
+static bool trap_batch_protect(uint8_t* address, size_t len) {
+    const auto page_size = system_info().page_size;
+    bool success = true;
+
+    for (auto* page = align_down(address, page_size); page < address + len; page += page_size) {
+        const auto protect = trap_protection(page, page + page_size);
+        auto it = t_trap_batch_pages.find(page);
+
+        if (it != t_trap_batch_pages.end() && it->second.current == protect) {
+            continue;
+        }
+
+        DWORD old_protect;
+
+        if (!VirtualProtect(page, page_size, protect, &old_protect)) {
+            success = false;
+            continue;
+        }
+
+        if (it == t_trap_batch_pages.end()) {
+            t_trap_batch_pages.emplace(page, TrapBatchPage{old_protect, protect});
+        } else {
+            it->second.current = protect;
+        }
+    }
+
+    return success;
+}
+
+void begin_trap_batch() {
+    t_trap_batch_active = true;
+}
+
+bool trap_batch_unprotect(uint8_t* address, size_t len) {
+    if (!t_trap_batch_active) {
+        return false;
+    }
+
+    // no trap to redirect through, threads reaching a patched page just wait for the batch to end
+    if (!TrapManager::is_destructed) {
+        std::scoped_lock lock{TrapManager::mutex};
+
+        if (TrapManager::instance == nullptr) {
+            TrapManager::instance = std::make_unique<TrapManager>();
+        }
+
+        const auto page_size = system_info().page_size;
+
+        for (auto* page = align_down(address, page_size); page < address + len; page += page_size) {
+            TrapManager::instance->hold_page(page);
+        }
+    }
+
+    return trap_batch_protect(address, len);
+}
+
+size_t end_trap_batch() {
+    const auto page_size = system_info().page_size;
+    const auto count = t_trap_batch_pages.size();
+
+    for (auto& [page, info] : t_trap_batch_pages) {
+        DWORD old_protect;
+        VirtualProtect(page, page_size, info.original, &old_protect);
+    }
+
+    t_trap_batch_pages.clear();
+    t_trap_batch_active = false;
+
+    if (!TrapManager::is_destructed) {
+        std::scoped_lock lock{TrapManager::mutex};
+
+        if (TrapManager::instance != nullptr) {
+            TrapManager::instance->release_held_pages();
+        }
+    }
+
+    return count;
+}
+
 void trap_threads(uint8_t* from, uint8_t* to, size_t len, const std::function<void()>& run_fn) {
     MEMORY_BASIC_INFORMATION find_me_mbi{};
     MEMORY_BASIC_INFORMATION from_mbi{};
@@ -1429,6 +1563,22 @@ void trap_threads(uint8_t* from, uint8_t* to, size_t len, const std::function<vo
         TrapManager::instance->add_trap(from, to, len);
     }
 
+    if (t_trap_batch_active) {
+        // the hooked pages stay trapped until end_trap_batch(), 'to' (usually a trampoline page other hooks run
+        // through) only for the write
+        trap_batch_protect(from, len);
+
+        DWORD to_protect;
+        VirtualProtect(to, len, new_protect, &to_protect);
+
+        if (run_fn) {
+            run_fn();
+        }
+
+        VirtualProtect(to, len, to_protect, &to_protect);
+        return;
+    }
+
     DWORD from_protect;
     DWORD to_protect;
 
@@ -184,6 +184,23 @@ using ThreadContext = void*;
 
 void SAFETYHOOK_API trap_threads(uint8_t* from, uint8_t* to, size_t len, const std::function<void()>& run_fn);
 
+/// @brief Starts a trap batch on the calling thread. Until end_trap_batch(), trap_threads() changes the protection
+/// of each hooked page only once and leaves it trapped, so hooks enabled together trap other threads for one
+/// window instead of one per hook. The pages threads are redirected to (trampolines) are restored right after each
+/// write.
+/// @note Nothing may execute code on the touched pages from this thread until the batch ends.
+void SAFETYHOOK_API begin_trap_batch();
+
+/// @brief Makes [address, address + len) writable for the rest of the current batch, for plain writes (patches)
+/// made next to the hooks. The pages get the same trapping protection as hooked pages: other threads reaching them
+/// wait in the trap handler until end_trap_batch().
+/// @return false if no batch is active or a page could not be unprotected.
+bool SAFETYHOOK_API trap_batch_unprotect(uint8_t* address, size_t len);
+
+/// @brief Restores every page changed since begin_trap_batch().
+/// @return The number of pages that were changed.
+size_t SAFETYHOOK_API end_trap_batch();
+
 /// @brief Will modify the context of a thread's IP to point to a new address if its IP is at the old address.
 /// @param ctx The thread context to modify.
 /// @param old_ip The old IP address.
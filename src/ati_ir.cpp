@@ -0,0 +1,688 @@
+#include "ati_ir.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+// ============================================================================
+// BUILD
+// ============================================================================
+
+static uint8_t ATIIR_RegIndex(GLuint reg) {
+    if (reg >= GL_REG_0_ATI && reg <= GL_REG_5_ATI)
+        return (uint8_t)(reg - GL_REG_0_ATI);
+    return 0;   // anything else was always written as r0
+}
+
+static uint8_t ATIIR_Rep(GLuint rep) {
+    switch (rep) {
+    case GL_RED:   return 0;
+    case GL_GREEN: return 1;
+    case GL_BLUE:  return 2;
+    case GL_ALPHA: return 3;
+    }
+    return ATI_IR_NO_REP;
+}
+
+static ATIIRSource ATIIR_Literal(float x, float y, float z, float w) {
+    ATIIRSource src;
+    src.kind = ATIIRSourceKind::Literal;
+    src.value[0] = x;
+    src.value[1] = y;
+    src.value[2] = z;
+    src.value[3] = w;
+    return src;
+}
+
+static ATIIRSource ATIIR_Source(GLuint index, GLuint rep, GLuint mod, const float constants[8][4], uint8_t constantsSet) {
+    ATIIRSource src;
+    src.rep = ATIIR_Rep(rep);
+    src.mod = (uint8_t)mod;
+
+    if (index >= GL_REG_0_ATI && index <= GL_REG_5_ATI) {
+        src.kind = ATIIRSourceKind::Reg;
+        src.index = (uint8_t)(index - GL_REG_0_ATI);
+    }
+    else if (index >= GL_CON_0_ATI && index <= GL_CON_7_ATI) {
+        src.index = (uint8_t)(index - GL_CON_0_ATI);
+        if (constantsSet & (1 << src.index)) {
+            src.kind = ATIIRSourceKind::Literal;
+            memcpy(src.value, constants[src.index], sizeof(src.value));
+        }
+        else {
+            src.kind = ATIIRSourceKind::Const;
+        }
+    }
+    else if (index == GL_PRIMARY_COLOR_ARB) {
+        src.kind = ATIIRSourceKind::PrimaryColor;
+    }
+    else if (index == GL_SECONDARY_INTERPOLATOR_ATI) {
+        src.kind = ATIIRSourceKind::SecondaryColor;
+    }
+    else if (index == GL_ZERO || index == GL_ONE) {
+        float value = index == GL_ONE ? 1.f : 0.f;
+        src.kind = ATIIRSourceKind::Literal;
+        src.value[0] = src.value[1] = src.value[2] = src.value[3] = value;
+    }
+    else {
+        src.kind = ATIIRSourceKind::Reg;
+        src.index = 0;
+    }
+
+    return src;
+}
+
+static bool ATIIR_TranslateOp(GLenum op, ATIIROp& out) {
+    switch (op) {
+    case GL_MOV_ATI:      out = ATIIROp::Mov; return true;
+    case GL_ADD_ATI:      out = ATIIROp::Add; return true;
+    case GL_MUL_ATI:      out = ATIIROp::Mul; return true;
+    case GL_SUB_ATI:      out = ATIIROp::Sub; return true;
+    case GL_MAD_ATI:      out = ATIIROp::Mad; return true;
+    case GL_LERP_ATI:     out = ATIIROp::Lerp; return true;
+    case GL_CND_ATI:      out = ATIIROp::Cnd; return true;
+    case GL_CND0_ATI:     out = ATIIROp::Cnd0; return true;
+    case GL_DOT3_ATI:     out = ATIIROp::Dot3; return true;
+    case GL_DOT4_ATI:     out = ATIIROp::Dot4; return true;
+    case GL_DOT2_ADD_ATI: out = ATIIROp::Dot2Add; return true;
+    }
+    return false;
+}
+
+ATIIRProgram ATIIR_Build(const std::vector<ATIAnyInstruction>& recorded, const float constants[8][4], uint8_t constantsSet) {
+    ATIIRProgram ir;
+    ir.insts.reserve(recorded.size());
+
+    for (const auto& any : recorded) {
+        ATIIRInst inst;
+
+        if (any.isSetup) {
+            const ATISetupInst& setup = any.setup;
+            inst.dst = ATIIR_RegIndex(setup.dst);
+            inst.writeMask = ATI_IR_XYZW;
+            inst.argCount = 1;
+
+            ATIIRSource& coord = inst.args[0];
+            if (setup.src >= GL_TEXTURE0_ARB && setup.src <= GL_TEXTURE7_ARB) {
+                coord.kind = ATIIRSourceKind::TexCoord;
+                coord.index = (uint8_t)(setup.src - GL_TEXTURE0_ARB);
+            }
+            else if (setup.isPassTexCoord && !(setup.src >= GL_REG_0_ATI && setup.src <= GL_REG_5_ATI)) {
+                continue;   // nothing to pass
+            }
+            else {
+                coord = ATIIR_Source(setup.src, GL_NONE, 0, constants, constantsSet);
+            }
+
+            if (setup.isPassTexCoord) {
+                inst.op = ATIIROp::Mov;
+            }
+            else {
+                // tex0 is a 2D texture, the others are cube maps
+                inst.op = ATIIROp::Sample;
+                inst.texUnit = inst.dst;
+                if (inst.texUnit == 0)
+                    inst.coordMask = ATI_IR_X | ATI_IR_Y;
+                else if (setup.swizzle == GL_SWIZZLE_STQ_ATI)
+                    inst.coordMask = ATI_IR_X | ATI_IR_Y | ATI_IR_W;
+                else
+                    inst.coordMask = ATI_IR_XYZ;
+            }
+        }
+        else {
+            const ATIInstruction& arith = any.arith;
+            inst.dst = ATIIR_RegIndex(arith.dst);
+            inst.dstMod = arith.dstMod;
+
+            if (arith.type == ALPHA_OP) {
+                inst.writeMask = ATI_IR_W;
+            }
+            else if (arith.dstMask == GL_NONE) {
+                inst.writeMask = ATI_IR_XYZ;    // color ops never write alpha
+            }
+            else {
+                if (arith.dstMask & GL_RED_BIT_ATI) inst.writeMask |= ATI_IR_X;
+                if (arith.dstMask & GL_GREEN_BIT_ATI) inst.writeMask |= ATI_IR_Y;
+                if (arith.dstMask & GL_BLUE_BIT_ATI) inst.writeMask |= ATI_IR_Z;
+            }
+
+            if (!ATIIR_TranslateOp(arith.op, inst.op)) {
+                inst.op = ATIIROp::Invalid;
+                inst.dstMod = 0;
+                ir.unknownOps.push_back(arith.op);
+            }
+            else {
+                inst.argCount = 3;  // missing arguments read as zero
+                for (int i = 0; i < arith.argCount && i < 3; i++) {
+                    inst.args[i] = ATIIR_Source(arith.args[i].index, arith.args[i].rep, arith.args[i].mod, constants, constantsSet);
+                }
+                if (inst.op == ATIIROp::Mov)
+                    inst.argCount = 1;
+                else if (inst.op != ATIIROp::Mad && inst.op != ATIIROp::Lerp && inst.op != ATIIROp::Cnd &&
+                    inst.op != ATIIROp::Cnd0 && inst.op != ATIIROp::Dot2Add)
+                    inst.argCount = 2;
+            }
+        }
+
+        ir.insts.push_back(inst);
+    }
+
+    return ir;
+}
+
+// Components of argument 'arg' the instruction evaluates, before the argument's rep picks one
+static uint8_t ATIIR_ArgComponents(const ATIIRInst& inst, int arg) {
+    switch (inst.op) {
+    case ATIIROp::Sample:  return inst.coordMask;
+    case ATIIROp::Dot3:    return ATI_IR_XYZ;
+    case ATIIROp::Dot4:    return ATI_IR_XYZW;
+    case ATIIROp::Dot2Add: return arg < 2 ? (ATI_IR_X | ATI_IR_Y) : ATI_IR_Z;
+    default:               return inst.writeMask;
+    }
+}
+
+uint8_t ATIIR_ArgReadMask(const ATIIRInst& inst, int arg) {
+    uint8_t comps = ATIIR_ArgComponents(inst, arg);
+    if (inst.args[arg].rep != ATI_IR_NO_REP)
+        return comps ? (uint8_t)(1 << inst.args[arg].rep) : 0;
+    return comps;
+}
+
+// ============================================================================
+// PASSES
+// ============================================================================
+
+// Literal with its rep and modifiers applied, in the order the wrapper always applied them
+static void ATIIR_ApplyModifiers(ATIIRSource& src) {
+    if (src.rep != ATI_IR_NO_REP) {
+        float value = src.value[src.rep];
+        src.value[0] = src.value[1] = src.value[2] = src.value[3] = value;
+    }
+
+    for (float& value : src.value) {
+        if (src.mod & GL_COMP_BIT_ATI) value = 1.f - value;
+        if (src.mod & GL_NEGATE_BIT_ATI) value = -value;
+        if (src.mod & GL_BIAS_BIT_ATI) value = value - 0.5f;
+        if (src.mod & GL_2X_BIT_ATI) value = value * 2.f;
+    }
+
+    src.rep = ATI_IR_NO_REP;
+    src.mod = 0;
+}
+
+static float ATIIR_DstScale(uint32_t dstMod) {
+    float scale = 1.f;
+    if (dstMod & GL_2X_BIT_ATI) scale *= 2.f;
+    if (dstMod & GL_4X_BIT_ATI) scale *= 4.f;
+    if (dstMod & GL_8X_BIT_ATI) scale *= 8.f;
+    if (dstMod & GL_HALF_BIT_ATI) scale *= 0.5f;
+    if (dstMod & GL_QUARTER_BIT_ATI) scale *= 0.25f;
+    if (dstMod & GL_EIGHTH_BIT_ATI) scale *= 0.125f;
+    return scale;
+}
+
+// All arguments are normalized literals
+static void ATIIR_Evaluate(const ATIIRInst& inst, float out[4]) {
+    const float* a = inst.args[0].value;
+    const float* b = inst.args[1].value;
+    const float* c = inst.args[2].value;
+
+    for (int i = 0; i < 4; i++) {
+        float value = 0.f;
+        switch (inst.op) {
+        case ATIIROp::Mov:     value = a[i]; break;
+        case ATIIROp::Add:     value = a[i] + b[i]; break;
+        case ATIIROp::Mul:     value = a[i] * b[i]; break;
+        case ATIIROp::Sub:     value = a[i] - b[i]; break;
+        case ATIIROp::Mad:     value = a[i] * b[i] + c[i]; break;
+        case ATIIROp::Lerp:    value = b[i] * (1.f - a[i]) + c[i] * a[i]; break;   // mix(arg2, arg3, arg1)
+        case ATIIROp::Cnd:     value = a[i] > 0.5f ? b[i] : c[i]; break;
+        case ATIIROp::Cnd0:    value = a[i] >= 0.f ? b[i] : c[i]; break;
+        case ATIIROp::Dot3:    value = a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; break;
+        case ATIIROp::Dot4:    value = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3]; break;
+        case ATIIROp::Dot2Add: value = a[0] * b[0] + a[1] * b[1] + c[2]; break;
+        default: break;
+        }
+
+        value *= ATIIR_DstScale(inst.dstMod);
+        if (inst.dstMod & GL_SATURATE_BIT_ATI)
+            value = value < 0.f ? 0.f : (value > 1.f ? 1.f : value);
+
+        out[i] = value;
+    }
+}
+
+void ATIIR_FoldConstants(ATIIRProgram& ir) {
+    float known[ATI_IR_REGISTERS][4] = {};
+    uint8_t knownMask[ATI_IR_REGISTERS] = {};
+
+    for (auto& inst : ir.insts) {
+        bool allLiteral = inst.op != ATIIROp::Sample && inst.op != ATIIROp::Invalid;
+
+        for (int i = 0; i < inst.argCount; i++) {
+            ATIIRSource& arg = inst.args[i];
+            uint8_t needed = ATIIR_ArgReadMask(inst, i);
+
+            if (arg.kind == ATIIRSourceKind::Reg && needed && (knownMask[arg.index] & needed) == needed) {
+                arg.kind = ATIIRSourceKind::Literal;
+                memcpy(arg.value, known[arg.index], sizeof(arg.value));
+            }
+
+            if (arg.kind == ATIIRSourceKind::Literal)
+                ATIIR_ApplyModifiers(arg);
+            else
+                allLiteral = false;
+        }
+
+        if (allLiteral) {
+            float result[4];
+            ATIIR_Evaluate(inst, result);
+
+            inst.op = ATIIROp::Mov;
+            inst.dstMod = 0;
+            inst.argCount = 1;
+            inst.args[0] = ATIIR_Literal(result[0], result[1], result[2], result[3]);
+        }
+
+        if (inst.op == ATIIROp::Mov && inst.args[0].kind == ATIIRSourceKind::Literal && inst.dstMod == 0) {
+            for (int c = 0; c < 4; c++) {
+                if (inst.writeMask & (1 << c))
+                    known[inst.dst][c] = inst.args[0].value[c];
+            }
+            knownMask[inst.dst] |= inst.writeMask;
+        }
+        else {
+            knownMask[inst.dst] &= ~inst.writeMask;
+        }
+    }
+}
+
+void ATIIR_EliminateDeadCode(ATIIRProgram& ir, const uint8_t liveOut[ATI_IR_REGISTERS]) {
+    uint8_t live[ATI_IR_REGISTERS];
+    memcpy(live, liveOut, sizeof(live));
+
+    std::vector<ATIIRInst> kept;
+    kept.reserve(ir.insts.size());
+
+    for (auto it = ir.insts.rbegin(); it != ir.insts.rend(); ++it) {
+        ATIIRInst inst = *it;
+
+        uint8_t used = inst.writeMask & live[inst.dst];
+        if (!used)
+            continue;
+
+        inst.writeMask = used;
+        live[inst.dst] &= ~used;
+
+        for (int i = 0; i < inst.argCount; i++) {
+            if (inst.args[i].kind == ATIIRSourceKind::Reg)
+                live[inst.args[i].index] |= ATIIR_ArgReadMask(inst, i);
+        }
+
+        kept.push_back(inst);
+    }
+
+    ir.insts.assign(kept.rbegin(), kept.rend());
+}
+
+static bool ATIIR_SameSource(const ATIIRSource& a, const ATIIRSource& b) {
+    if (a.kind != b.kind || a.rep != b.rep || a.mod != b.mod)
+        return false;
+    if (a.kind == ATIIRSourceKind::Literal)
+        return memcmp(a.value, b.value, sizeof(a.value)) == 0;
+    return a.index == b.index;
+}
+
+static bool ATIIR_CanMerge(const ATIIRInst& first, const ATIIRInst& next) {
+    if (first.op != next.op || first.dst != next.dst || (first.writeMask & next.writeMask) ||
+        first.dstMod != next.dstMod || first.argCount != next.argCount ||
+        first.texUnit != next.texUnit || first.coordMask != next.coordMask) {
+        return false;
+    }
+
+    for (int i = 0; i < next.argCount; i++) {
+        if (!ATIIR_SameSource(first.args[i], next.args[i]))
+            return false;
+
+        // 'next' must not need what 'first' wrote, the merged instruction reads before it writes
+        if (next.args[i].kind == ATIIRSourceKind::Reg && next.args[i].index == first.dst &&
+            (ATIIR_ArgReadMask(next, i) & first.writeMask)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void ATIIR_MergeWriteMasks(ATIIRProgram& ir) {
+    std::vector<ATIIRInst> merged;
+    merged.reserve(ir.insts.size());
+
+    for (const auto& inst : ir.insts) {
+        if (!merged.empty() && ATIIR_CanMerge(merged.back(), inst))
+            merged.back().writeMask |= inst.writeMask;
+        else
+            merged.push_back(inst);
+    }
+
+    ir.insts = std::move(merged);
+}
+
+// ============================================================================
+// GLSL
+// ============================================================================
+
+static int ATIIR_Count(uint8_t mask) {
+    int count = 0;
+    for (int c = 0; c < 4; c++)
+        count += (mask >> c) & 1;
+    return count;
+}
+
+static std::string ATIIR_Swizzle(uint8_t mask) {
+    std::string swizzle;
+    for (int c = 0; c < 4; c++) {
+        if (mask & (1 << c))
+            swizzle += "rgba"[c];
+    }
+    return swizzle;
+}
+
+static std::string ATIIR_Type(int width) {
+    return width == 1 ? "float" : "vec" + std::to_string(width);
+}
+
+static std::string ATIIR_Float(float value) {
+    if (!std::isfinite(value))
+        value = value > 0.f ? 3.402823e38f : (value < 0.f ? -3.402823e38f : 0.f);
+
+    char text[32];
+    snprintf(text, sizeof(text), "%.9g", value);
+
+    std::string result = text;
+    if (result.find_first_of(".e") == std::string::npos)
+        result += ".0";
+    return result;
+}
+
+static std::string ATIIR_LiteralText(const float value[4], uint8_t comps) {
+    int width = ATIIR_Count(comps);
+    std::vector<float> values;
+    for (int c = 0; c < 4; c++) {
+        if (comps & (1 << c))
+            values.push_back(value[c]);
+    }
+
+    if (width == 1)
+        return ATIIR_Float(values[0]);
+
+    bool same = true;
+    for (float v : values)
+        same &= v == values[0];
+
+    std::string text = ATIIR_Type(width) + "(";
+    for (size_t i = 0; i < (same ? 1 : values.size()); i++) {
+        if (i)
+            text += ", ";
+        text += ATIIR_Float(values[i]);
+    }
+    return text + ")";
+}
+
+static std::string ATIIR_SourceName(const ATIIRSource& src) {
+    switch (src.kind) {
+    case ATIIRSourceKind::Reg:            return "r" + std::to_string(src.index);
+    case ATIIRSourceKind::Const:          return "atiConst[" + std::to_string(src.index) + "]";
+    case ATIIRSourceKind::PrimaryColor:   return "gl_Color";
+    case ATIIRSourceKind::SecondaryColor: return "gl_SecondaryColor";
+    case ATIIRSourceKind::TexCoord:       return "gl_TexCoord[" + std::to_string(src.index) + "]";
+    default:                              return "vec4(0.0)";
+    }
+}
+
+// 'comps' are the components the argument is evaluated for, its rep may replicate one of them
+static std::string ATIIR_EmitArg(const ATIIRSource& src, uint8_t comps) {
+    int width = ATIIR_Count(comps);
+
+    if (src.kind == ATIIRSourceKind::Literal) {
+        ATIIRSource literal = src;
+        ATIIR_ApplyModifiers(literal);
+        return ATIIR_LiteralText(literal.value, comps);
+    }
+
+    std::string result = ATIIR_SourceName(src);
+    if (src.rep != ATI_IR_NO_REP)
+        result += std::string(".") + "rgba"[src.rep];
+    else if (comps != ATI_IR_XYZW)
+        result += "." + ATIIR_Swizzle(comps);
+
+    if (src.mod & GL_COMP_BIT_ATI) result = "(1.0 - " + result + ")";
+    if (src.mod & GL_NEGATE_BIT_ATI) result = "-(" + result + ")";
+    if (src.mod & GL_BIAS_BIT_ATI) result = "(" + result + " - 0.5)";
+    if (src.mod & GL_2X_BIT_ATI) result = "(" + result + " * 2.0)";
+
+    if (src.rep != ATI_IR_NO_REP && width > 1)
+        result = ATIIR_Type(width) + "(" + result + ")";
+
+    return result;
+}
+
+static std::string ATIIR_EmitInstruction(const ATIIRInst& inst) {
+    static const float magenta[4] = { 1.f, 0.f, 1.f, 1.f };
+
+    int width = ATIIR_Count(inst.writeMask);
+    std::string type = ATIIR_Type(width);
+
+    std::string args[3];
+    for (int i = 0; i < inst.argCount; i++)
+        args[i] = ATIIR_EmitArg(inst.args[i], ATIIR_ArgComponents(inst, i));
+
+    std::string expr;
+    switch (inst.op) {
+    case ATIIROp::Mov:
+        expr = args[0];
+        break;
+    case ATIIROp::Add:
+        expr = args[0] + " + " + args[1];
+        break;
+    case ATIIROp::Mul:
+        expr = args[0] + " * " + args[1];
+        break;
+    case ATIIROp::Sub:
+        expr = args[0] + " - " + args[1];
+        break;
+    case ATIIROp::Mad:
+        expr = args[0] + " * " + args[1] + " + " + args[2];
+        break;
+    case ATIIROp::Lerp:
+        expr = "mix(" + args[1] + ", " + args[2] + ", " + args[0] + ")";
+        break;
+    case ATIIROp::Cnd:
+    case ATIIROp::Cnd0: {
+        bool cnd0 = inst.op == ATIIROp::Cnd0;
+        if (width == 1)
+            expr = "((" + args[0] + (cnd0 ? " >= 0.0" : " > 0.5") + ") ? " + args[1] + " : " + args[2] + ")";
+        else
+            expr = "mix(" + args[2] + ", " + args[1] + ", " + type + "(" + (cnd0 ? "greaterThanEqual(" : "greaterThan(") +
+                args[0] + ", " + type + (cnd0 ? "(0.0)" : "(0.5)") + ")))";
+        break;
+    }
+    case ATIIROp::Dot3:
+    case ATIIROp::Dot4:
+        expr = "dot(" + args[0] + ", " + args[1] + ")";
+        break;
+    case ATIIROp::Dot2Add:
+        expr = "dot(" + args[0] + ", " + args[1] + ") + " + args[2];
+        break;
+    case ATIIROp::Sample:
+        expr = (inst.texUnit == 0 ? "texture2D(tex0, " : "textureCube(tex" + std::to_string(inst.texUnit) + ", ") + args[0] + ")";
+        if (inst.writeMask != ATI_IR_XYZW)
+            expr += "." + ATIIR_Swizzle(inst.writeMask);
+        break;
+    case ATIIROp::Invalid:
+        expr = ATIIR_LiteralText(magenta, inst.writeMask);   // magenta = error
+        break;
+    }
+
+    if ((inst.op == ATIIROp::Dot3 || inst.op == ATIIROp::Dot4 || inst.op == ATIIROp::Dot2Add) && width > 1)
+        expr = type + "(" + expr + ")";
+
+    float scale = ATIIR_DstScale(inst.dstMod);
+    if (scale != 1.f)
+        expr = "((" + expr + ") * " + ATIIR_Float(scale) + ")";
+    if (inst.dstMod & GL_SATURATE_BIT_ATI)
+        expr = "clamp(" + expr + ", 0.0, 1.0)";
+
+    std::string dst = "r" + std::to_string(inst.dst);
+    if (inst.writeMask != ATI_IR_XYZW)
+        dst += "." + ATIIR_Swizzle(inst.writeMask);
+
+    return "    " + dst + " = " + expr + ";\n";
+}
+
+void ATIIR_LiveOut(int debugMode, uint8_t liveOut[ATI_IR_REGISTERS]) {
+    memset(liveOut, 0, ATI_IR_REGISTERS);
+
+    switch (debugMode) {
+    case 0:
+    case -1:
+        liveOut[0] = ATI_IR_XYZ;    // normal for the fresnel term
+        liveOut[2] = ATI_IR_XYZ;
+        liveOut[3] = ATI_IR_XYZ;
+        break;
+    case 1:
+        liveOut[3] = ATI_IR_W;
+        break;
+    case 2:
+    case 4:
+        liveOut[3] = ATI_IR_XYZ;
+        break;
+    case 3:
+    case 5:
+        liveOut[2] = ATI_IR_XYZ;
+        break;
+    default:
+        liveOut[0] = ATI_IR_XYZW;
+        break;
+    }
+}
+
+static const char* g_atiUniforms =
+    "// Custom fog uniforms\n"
+    "#if ATI_FOG_MODE != 0\n"
+    "uniform vec4 fogColor;\n"
+    "#if ATI_FOG_MODE == 3\n"
+    "uniform float fogStart;\n"
+    "uniform float fogEnd;\n"
+    "#else\n"
+    "uniform float fogDensity;\n"
+    "#endif\n"
+    "#endif\n"
+    "#if ATI_DEBUG_MODE == 0 || ATI_DEBUG_MODE == -1\n"
+    "uniform float fresnelPower;\n"
+    "uniform float fresnelBias;\n"
+    "#endif\n";
+
+static const char* g_atiEpilogue =
+    "\n"
+    "#if ATI_DEBUG_MODE == 0 || ATI_DEBUG_MODE == -1\n"
+    "    // Use simplified Fresnel (avoid discontinuities), Z component of normal approximates the view angle\n"
+    "    vec3 normalVec = normalize((r0 * 2.0 - 1.0).xyz);\n"
+    "    float fresnel = fresnelBias + (1.0 - fresnelBias) * pow(clamp(1.0 - abs(normalVec.z), 0.0, 1.0), fresnelPower);\n"
+    "    fresnel = clamp(fresnel, 0.0, 1.0);\n"
+    "#if ATI_DEBUG_MODE == 0\n"
+    "    // Correct blend method\n"
+    "    r0.rgb = mix(r3.rgb, r2.rgb, fresnel) * gl_Color.rgb;\n"
+    "#else\n"
+    "    // (incorrect) blend method\n"
+    "    r0.rgb = mix(r2.rgb, r3.rgb, fresnel) * gl_Color.rgb;\n"
+    "#endif\n"
+    "    r0.a = gl_Color.a;\n"
+    "#elif ATI_DEBUG_MODE == 1\n"
+    "    gl_FragColor = vec4(r3.a, r3.a, r3.a, 1.0);  // Fresnel alpha\n"
+    "#elif ATI_DEBUG_MODE == 2\n"
+    "    gl_FragColor = vec4(r3.rgb, 1.0);  // Specular RGB\n"
+    "#elif ATI_DEBUG_MODE == 3\n"
+    "    gl_FragColor = vec4(r2.rgb, 1.0);  // Diffuse RGB\n"
+    "#elif ATI_DEBUG_MODE == 4\n"
+    "    gl_FragColor = vec4(r3.xyz * 0.5 + 0.5, 1.0);  // Reflection vector\n"
+    "#elif ATI_DEBUG_MODE == 5\n"
+    "    gl_FragColor = vec4(r2.xyz * 0.5 + 0.5, 1.0);  // Normal vector\n"
+    "#endif\n"
+    "\n"
+    "#if ATI_DEBUG_MODE <= 0 || ATI_DEBUG_MODE >= 6\n"
+    "#if ATI_FOG_MODE != 0\n"
+    "    // Apply fog\n"
+    "    const float LOG2 = 1.442695;\n"
+    "#if ATI_FOG_MODE == 1\n"
+    "    float fogFactor = exp2(-fogDensity * gl_FogFragCoord * LOG2);\n"
+    "#elif ATI_FOG_MODE == 2\n"
+    "    float fogFactor = exp2(-fogDensity * fogDensity * gl_FogFragCoord * gl_FogFragCoord * LOG2);\n"
+    "#else\n"
+    "    float fogFactor = (fogEnd - gl_FogFragCoord) / (fogEnd - fogStart);\n"
+    "#endif\n"
+    "    r0.rgb = mix(fogColor.rgb, r0.rgb, clamp(fogFactor, 0.0, 1.0));\n"
+    "#endif\n"
+    "    gl_FragColor = r0;\n"
+    "#endif\n";
+
+std::string ATIIR_TranslateToGLSL(const ATIIRProgram& folded, int variant) {
+    int debugMode = ATIVariant_DebugMode(variant);
+
+    uint8_t liveOut[ATI_IR_REGISTERS];
+    ATIIR_LiveOut(debugMode, liveOut);
+
+    ATIIRProgram ir = folded;
+    ATIIR_EliminateDeadCode(ir, liveOut);
+    ATIIR_MergeWriteMasks(ir);
+
+    bool registers[ATI_IR_REGISTERS] = {};
+    bool samplers[ATI_IR_REGISTERS] = {};
+    bool constants = false;
+
+    for (int r = 0; r < ATI_IR_REGISTERS; r++)
+        registers[r] = liveOut[r] != 0;
+
+    std::string body;
+    for (const auto& inst : ir.insts) {
+        registers[inst.dst] = true;
+        if (inst.op == ATIIROp::Sample)
+            samplers[inst.texUnit] = true;
+
+        for (int i = 0; i < inst.argCount; i++) {
+            if (inst.args[i].kind == ATIIRSourceKind::Reg)
+                registers[inst.args[i].index] = true;
+            else if (inst.args[i].kind == ATIIRSourceKind::Const)
+                constants = true;
+        }
+
+        body += ATIIR_EmitInstruction(inst);
+    }
+
+    std::string glsl;
+    glsl += "#define ATI_DEBUG_MODE " + std::to_string(debugMode) + "\n";
+    glsl += "#define ATI_FOG_MODE " + std::to_string(ATIVariant_Fog(variant)) + "\n\n";
+
+    for (int t = 0; t < ATI_IR_REGISTERS; t++) {
+        if (samplers[t])
+            glsl += (t == 0 ? "uniform sampler2D tex0;\n" : "uniform samplerCube tex" + std::to_string(t) + ";\n");
+    }
+
+    if (constants)
+        glsl += "uniform vec4 atiConst[8];\n";
+
+    glsl += g_atiUniforms;
+    glsl += "\nvoid main() {\n";
+
+    for (int r = 0; r < ATI_IR_REGISTERS; r++) {
+        if (registers[r])
+            glsl += "    vec4 r" + std::to_string(r) + " = vec4(0.0);\n";
+    }
+
+    glsl += "\n";
+    glsl += body;
+    glsl += g_atiEpilogue;
+    glsl += "}\n";
+
+    return glsl;
+}
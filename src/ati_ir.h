@@ -0,0 +1,172 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "GL/glew.h"
+
+// ============================================================================
+// ATI_fragment_shader recording and the IR it is translated through
+// ============================================================================
+// The hooks in opengl_ati_frag.cpp record the ATI calls as they come. At glEndFragmentShaderATI the recording is
+// built into a small typed IR (one instruction per ATI op, registers split into components by write mask) which
+// gets the shader-local constants folded in. Every variant (see ATIVariant_Index) then runs dead code elimination
+// against what its epilogue reads, merges the color/alpha halves of paired ops and is emitted as GLSL behind its
+// #defines, so the debug views and the fog mode cost no branches.
+//
+// The emitted code keeps the operand order and modifier order the wrapper always used (LERP as mix(arg2, arg3,
+// arg1), negate before bias), only what the IR proves unused or constant is gone. Unlike the string translator it
+// replaced, color ops leave alpha alone and destination scales apply to the whole result. No GL calls in here.
+
+enum ATIOpType { COLOR_OP, ALPHA_OP };
+
+struct ATISource {
+    GLuint index;
+    GLuint rep;
+    GLuint mod;
+};
+
+struct ATIInstruction {
+    ATIOpType type;
+    GLenum op;
+    GLuint dst;
+    GLuint dstMask;
+    GLuint dstMod;
+    int argCount;
+    ATISource args[3];
+};
+
+struct ATISetupInst {
+    bool isPassTexCoord;
+    GLuint dst;
+    GLuint src;
+    GLenum swizzle;
+};
+
+struct ATIAnyInstruction {
+    bool isSetup;
+    union {
+        ATISetupInst setup;
+        ATIInstruction arith;
+    };
+};
+
+constexpr int ATI_IR_REGISTERS = 6;
+constexpr int ATI_IR_CONSTANTS = 8;
+
+// component bits of write and read masks
+constexpr uint8_t ATI_IR_X = 1;
+constexpr uint8_t ATI_IR_Y = 2;
+constexpr uint8_t ATI_IR_Z = 4;
+constexpr uint8_t ATI_IR_W = 8;
+constexpr uint8_t ATI_IR_XYZ = ATI_IR_X | ATI_IR_Y | ATI_IR_Z;
+constexpr uint8_t ATI_IR_XYZW = ATI_IR_XYZ | ATI_IR_W;
+
+constexpr uint8_t ATI_IR_NO_REP = 0xFF;
+
+enum class ATIIROp : uint8_t {
+    Mov,
+    Add,
+    Mul,
+    Sub,
+    Mad,
+    Lerp,
+    Cnd,
+    Cnd0,
+    Dot3,
+    Dot4,
+    Dot2Add,
+    Sample,     // texture 'texUnit' looked up at args[0]
+    Invalid,    // unknown opcode, writes magenta
+};
+
+enum class ATIIRSourceKind : uint8_t {
+    Reg,
+    Const,          // atiConst[index], not set inside the shader so left to the uniform
+    PrimaryColor,
+    SecondaryColor,
+    TexCoord,       // gl_TexCoord[index]
+    Literal,        // 'value', with rep and modifiers already applied
+};
+
+struct ATIIRSource {
+    ATIIRSourceKind kind = ATIIRSourceKind::Literal;
+    uint8_t index = 0;
+    uint8_t rep = ATI_IR_NO_REP;    // component replicated to all, ATI_IR_NO_REP reads component by component
+    uint8_t mod = 0;                // GL_COMP_BIT_ATI, GL_NEGATE_BIT_ATI, GL_BIAS_BIT_ATI, GL_2X_BIT_ATI
+    float value[4] = {};
+};
+
+struct ATIIRInst {
+    ATIIROp op = ATIIROp::Mov;
+    uint8_t dst = 0;                // register
+    uint8_t writeMask = 0;
+    uint8_t texUnit = 0;            // Sample
+    uint8_t coordMask = 0;          // Sample: what it reads of args[0]
+    uint32_t dstMod = 0;            // scale and saturate bits
+    uint8_t argCount = 0;
+    ATIIRSource args[3];
+};
+
+struct ATIIRProgram {
+    std::vector<ATIIRInst> insts;
+    std::vector<GLenum> unknownOps; // for the caller to warn about
+};
+
+// Variants: r_arb_fragment_shader_debug (-1..5, 6 for anything else, which draws r0 unblended) times the fog mode.
+// The debug views 1..5 skip fog, so they only exist with ATI_FOG_OFF.
+enum ATIFogVariant : uint8_t {
+    ATI_FOG_OFF,
+    ATI_FOG_EXP,
+    ATI_FOG_EXP2,
+    ATI_FOG_LINEAR,
+};
+
+constexpr int ATI_VARIANT_COUNT = 8 * 4;
+
+inline int ATIVariant_Index(int debugMode, int fog) {
+    if (debugMode < -1 || debugMode > 5)
+        debugMode = 6;
+    if (debugMode >= 1 && debugMode <= 5)
+        fog = ATI_FOG_OFF;
+    return (debugMode + 1) * 4 + fog;
+}
+
+inline int ATIVariant_DebugMode(int index) {
+    return index / 4 - 1;
+}
+
+inline int ATIVariant_Fog(int index) {
+    return index % 4;
+}
+
+inline int ATIVariant_FogFromMode(GLint mode) {
+    if (mode == GL_EXP)
+        return ATI_FOG_EXP;
+    if (mode == GL_EXP2)
+        return ATI_FOG_EXP2;
+    return ATI_FOG_LINEAR;
+}
+
+// 'constantsSet' has a bit for every constant set inside the shader, those are folded in as literals
+ATIIRProgram ATIIR_Build(const std::vector<ATIAnyInstruction>& recorded, const float constants[8][4], uint8_t constantsSet);
+
+// Components of a register an instruction's argument reads
+uint8_t ATIIR_ArgReadMask(const ATIIRInst& inst, int arg);
+
+// Forward pass: literal arguments get their modifiers applied, registers holding known values are replaced by them
+// and instructions with only literal arguments are evaluated into a move
+void ATIIR_FoldConstants(ATIIRProgram& ir);
+
+// Backward pass: drops instructions whose results nothing reads and narrows write masks to the components that are
+// read. 'liveOut' is what the epilogue reads of each register.
+void ATIIR_EliminateDeadCode(ATIIRProgram& ir, const uint8_t liveOut[ATI_IR_REGISTERS]);
+
+// What the epilogue of a debug view (ATIVariant_DebugMode) reads of r0..r5, the 'liveOut' its variants run dead code
+// elimination against
+void ATIIR_LiveOut(int debugMode, uint8_t liveOut[ATI_IR_REGISTERS]);
+
+// Joins an instruction with the next one when they compute the same thing into other components of the same register
+void ATIIR_MergeWriteMasks(ATIIRProgram& ir);
+
+// Full fragment shader for one variant, runs the per-variant passes on a copy of the folded IR
+std::string ATIIR_TranslateToGLSL(const ATIIRProgram& folded, int variant);
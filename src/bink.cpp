@@ -37,7 +37,20 @@ namespace bink_game {
 
     class component final : public component_interface
     {
+        void* roq_played = nullptr;
+
     public:
+        bool is_scan_phase(component_phase phase) override
+        {
+            return phase == component_phase::post_unpack;
+        }
+
+        void prepare(component_phase) override
+        {
+            auto pattern = hook::pattern("88 99 ? ? ? ? C7 05"_sig);
+            roq_played = pattern.empty() ? nullptr : pattern.get_first();
+        }
+
         void post_unpack() override
         {
             auto BinkDoFrameptr = GetProcAddress("binkw32.dll","_BinkDoFrame@4");
@@ -51,10 +64,8 @@ namespace bink_game {
                 BinkDoFrameog = safetyhook::create_inline(BinkDoFrameptr, BinkDoFrame_hook);
             }
 
-            auto pattern = hook::pattern("88 99 ? ? ? ? C7 05");
-
-            if (!pattern.empty() && sp_mp(1)) {
-                static auto roq_test_fix1 = safetyhook::create_mid(pattern.get_first(0), [](SafetyHookContext& ctx) {
+            if (roq_played && sp_mp(1)) {
+                static auto roq_test_fix1 = safetyhook::create_mid(roq_played, [](SafetyHookContext& ctx) {
 
                     cin_cache* cin_tables = (cin_cache*)0x877558;
                     if (cinematic_reset_RoQPlayed && cinematic_reset_RoQPlayed->base->integer != 0) {
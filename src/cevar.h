@@ -1,7 +1,10 @@
 #pragma once
 #include "shared.h"
-#include <unordered_map>
+#include <cstdint>
 #include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
 
 typedef struct cvar_s
 {
@@ -46,7 +49,22 @@ typedef struct cevar_s {
 // ============================================================================
 // CEVAR SYSTEM - GLOBAL STORAGE
 // ============================================================================
-extern std::unordered_map<cvar_t*, cevar_t*> g_cevars;
+// Engine cvars all live in one fixed cvar_t array, so two cvar pointers are a multiple of sizeof(cvar_t) apart and
+// less than the array apart. Cevars are stored by value in a dense table indexed by the distance from the first cvar
+// a cevar was created for (the middle slot), which makes the cvar -> cevar lookup pointer arithmetic.
+constexpr size_t CEVAR_MAX_CVARS = 2048; // MAX_CVARS_NEW, in case the engine array gets enlarged
+constexpr size_t CEVAR_SLOT_COUNT = CEVAR_MAX_CVARS * 2;
+
+extern cevar_t g_cevarSlots[CEVAR_SLOT_COUNT];
+extern uintptr_t g_cevarSlotOrigin;
+
+// The rare cevar whose cvar is not part of the engine array (a cvar_t the game allocated elsewhere), looked up by
+// pointer once the slot check fails
+extern std::unordered_map<cvar_t*, cevar_t> g_cevarsOutside;
+
+inline size_t Cevar_Slot(const cvar_t* cvar) {
+    return ((uintptr_t)cvar - g_cevarSlotOrigin + CEVAR_MAX_CVARS * sizeof(cvar_t)) / sizeof(cvar_t);
+}
 
 // ============================================================================
 // CEVAR HELPER - Get cevar from cvar without modifying struct
@@ -54,11 +72,42 @@ extern std::unordered_map<cvar_t*, cevar_t*> g_cevars;
 inline cevar_t* Cevar_FromCvar(cvar_t* cvar) {
     if (!cvar) return nullptr;
 
-    auto it = g_cevars.find(cvar);
-    if (it != g_cevars.end()) {
-        return it->second;
+    // anything too far below the origin wraps around to a huge slot, the base check rejects pointers that are not
+    // the start of a cevar's cvar
+    size_t slot = Cevar_Slot(cvar);
+    if (slot < CEVAR_SLOT_COUNT && g_cevarSlots[slot].base == cvar)
+        return &g_cevarSlots[slot];
+
+    if (g_cevarsOutside.empty())
+        return nullptr;
+
+    auto it = g_cevarsOutside.find(cvar);
+    return it != g_cevarsOutside.end() ? &it->second : nullptr;
+}
+
+// ============================================================================
+// CEVAR NAME FILTER - Cheap "could this be a cevar" test by name
+// ============================================================================
+// One bit per case-insensitive name hash, set for every cevar. A clear bit means the name is not a cevar and the
+// Cvar_Find + lookup can be skipped, a set bit may be a collision and needs the real lookup.
+constexpr size_t CEVAR_NAME_FILTER_BITS = 8192;
+
+extern uint32_t g_cevarNameFilter[CEVAR_NAME_FILTER_BITS / 32];
+
+inline uint32_t Cevar_NameHash(const char* name) {
+    uint32_t hash = 2166136261u;
+    for (; *name; name++) {
+        char c = *name;
+        if (c >= 'A' && c <= 'Z')
+            c += 'a' - 'A';
+        hash = (hash ^ (uint8_t)c) * 16777619u;
     }
-    return nullptr;
+    return hash;
+}
+
+inline bool Cevar_MaybeName(const char* name) {
+    uint32_t bit = Cevar_NameHash(name) % CEVAR_NAME_FILTER_BITS;
+    return (g_cevarNameFilter[bit / 32] >> (bit % 32)) & 1;
 }
 
 inline cevar_t* Cevar_FromCvar(const char* cvar_name) {
@@ -133,6 +182,12 @@ inline bool Cevar_GetIntLimits(cvar_t* cvar, int* min, int* max) {
     return false;
 }
 
+// atof/atoi compatible parsing and the same output as sprintf "%f"/"%d", without locale or allocation
+float Cevar_ParseFloat(const char* value);
+int Cevar_ParseInt(const char* value);
+const char* Cevar_FormatFloat(char (&buffer)[32], float value);
+const char* Cevar_FormatInt(char (&buffer)[32], int value);
+
 bool Cevar_Set(cevar_t* cevar, const char* value);
 
 // Set from float (applies limits if they exist)
@@ -155,4 +210,48 @@ inline bool Cevar_SetFloat(cvar_t* cvar, float value) {
 inline bool Cevar_SetInt(cvar_t* cvar, int value) {
     cevar_t* cevar = Cevar_FromCvar(cvar);
     return cevar ? Cevar_Set(cevar, value) : false;
-}
\ No newline at end of file
+}
+
+// ============================================================================
+// QOL CVAR REGISTRY - Every cvar the plugin registers, in registration order
+// ============================================================================
+struct qol_cvar_info {
+    std::string name;       // copied once, names compare case-insensitively like the engine's
+    cvar_t* cvar;
+    int flags;              // as registered, the engine may add more
+    cevar_t* cevar;         // limits and callback, nullptr for plain cvars
+};
+
+// Adds the cvar, or updates it when the name is already registered. O(1), open-addressed on Cevar_NameHash.
+void QOL_RegisterCvar(const char* name, cvar_t* cvar, int flags);
+
+void QOL_RegisterCevar(cevar_t* cevar);
+
+const qol_cvar_info* QOL_FindRegisteredCvar(const char* name);
+
+const std::vector<qol_cvar_info>& QOL_GetRegisteredCvars();
+
+// ============================================================================
+// CEVAR VIEWS - Typed copies of cvar values for per-frame hooks
+// ============================================================================
+// A view holds one cvar's value as a plain member and is refreshed whenever that cvar is set, so hot code reads
+// 'view' (or 'view.value') without following cevar->base and without null checks. Until the cvar exists the view
+// holds its fallback. Views read by the same hooks are meant to be grouped in one alignas(64) struct.
+template <typename T>
+struct cevar_view {
+    static_assert(std::is_same_v<T, float> || std::is_same_v<T, int>, "cevar_view holds a cvar's value or integer");
+
+    T value;
+
+    operator T() const { return value; }
+};
+
+// 'cvar' is the global the cvar pointer is (or will be) stored in, it is read again on every refresh
+void Cevar_BindView(cevar_view<float>& view, cvar_t* const& cvar, float fallback);
+void Cevar_BindView(cevar_view<int>& view, cvar_t* const& cvar, int fallback);
+void Cevar_BindView(cevar_view<float>& view, cevar_t* const& cevar, float fallback);
+void Cevar_BindView(cevar_view<int>& view, cevar_t* const& cevar, int fallback);
+
+// Refreshes the views bound to 'cvar', or all of them for nullptr. Called by the Cvar_Set and Cvar_Get detours;
+// call it without arguments after storing newly created cvars in globals that have views bound.
+void Cevar_RefreshViews(const cvar_t* cvar = nullptr);
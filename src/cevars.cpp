@@ -4,6 +4,8 @@
 #include "cevar.h"
 #include "safetyhook.hpp"
 
+#include <charconv>
+
 
 // ============================================================================
 // CEVAR - EXTENDED CVAR SYSTEM WITH OVERLOADED CREATION
@@ -15,7 +17,10 @@ extern SafetyHookInline Cvar_Set_og;
 
 
 
-std::unordered_map<cvar_t*, cevar_t*> g_cevars;
+cevar_t g_cevarSlots[CEVAR_SLOT_COUNT];
+uintptr_t g_cevarSlotOrigin = 0;
+std::unordered_map<cvar_t*, cevar_t> g_cevarsOutside;
+uint32_t g_cevarNameFilter[CEVAR_NAME_FILTER_BITS / 32];
 // ============================================================================
 // INTERNAL HELPER - Creates cevar structure
 // ============================================================================
@@ -26,22 +31,223 @@ cevar_t* Cevar_Internal_Create(const char* var_name, const char* var_value, int
     cvar_t* base = Cvar_Get(var_name, var_value, flags);
     if (!base) return nullptr;
 
-    auto it = g_cevars.find(base);  // Use pointer directly
-    if (it != g_cevars.end()) {
-        if (callback) it->second->callback = callback;
-        it->second->limits = limits;
-        return it->second;
+    if (!g_cevarSlotOrigin)
+        g_cevarSlotOrigin = (uintptr_t)base;
+
+    cevar_t* cevar = Cevar_FromCvar(base);
+    if (cevar) {
+        if (callback) cevar->callback = callback;
+        cevar->limits = limits;
+        return cevar;
+    }
+
+    size_t slot = Cevar_Slot(base);
+    if (slot >= CEVAR_SLOT_COUNT || ((uintptr_t)base - g_cevarSlotOrigin + CEVAR_MAX_CVARS * sizeof(cvar_t)) % sizeof(cvar_t) != 0) {
+        // not part of the engine's cvar array, kept by pointer so Cvar_Set still finds it to clamp
+        printf("cevar '%s' at %p is outside the cvar array\n", var_name, base);
+        cevar = &g_cevarsOutside[base];
+    }
+    else {
+        cevar = &g_cevarSlots[slot];
     }
 
-    cevar_t* cevar = new cevar_t();
     cevar->base = base;
     cevar->callback = callback;
     cevar->limits = limits;
+    QOL_RegisterCevar(cevar);
 
-    g_cevars[base] = cevar;  // Use pointer as key
+    uint32_t bit = Cevar_NameHash(var_name) % CEVAR_NAME_FILTER_BITS;
+    g_cevarNameFilter[bit / 32] |= 1u << (bit % 32);
     return cevar;
 }
 
+// ============================================================================
+// QOL CVAR REGISTRY
+// ============================================================================
+
+static std::vector<qol_cvar_info> g_qolCvars;
+
+// index + 1 into g_qolCvars, 0 is empty. Linear probing, the size is a power of two.
+static std::vector<uint32_t> g_qolCvarTable;
+
+static uint32_t* QOL_FindSlot(const char* name) {
+    if (g_qolCvarTable.empty())
+        return nullptr;
+
+    const size_t mask = g_qolCvarTable.size() - 1;
+    for (size_t i = Cevar_NameHash(name) & mask;; i = (i + 1) & mask) {
+        uint32_t& slot = g_qolCvarTable[i];
+        if (!slot || _stricmp(g_qolCvars[slot - 1].name.c_str(), name) == 0)
+            return &slot;
+    }
+}
+
+static void QOL_GrowTable() {
+    std::vector<uint32_t> table(g_qolCvarTable.empty() ? 256 : g_qolCvarTable.size() * 2, 0);
+    const size_t mask = table.size() - 1;
+
+    for (uint32_t index = 0; index < g_qolCvars.size(); index++) {
+        size_t i = Cevar_NameHash(g_qolCvars[index].name.c_str()) & mask;
+        while (table[i])
+            i = (i + 1) & mask;
+        table[i] = index + 1;
+    }
+
+    g_qolCvarTable = std::move(table);
+}
+
+void QOL_RegisterCvar(const char* name, cvar_t* cvar, int flags) {
+    if (!name)
+        return;
+
+    // keep the load factor under 3/4 so probes stay short and there is always an empty slot
+    if ((g_qolCvars.size() + 1) * 4 > g_qolCvarTable.size() * 3)
+        QOL_GrowTable();
+
+    uint32_t* slot = QOL_FindSlot(name);
+    if (*slot) {
+        auto& info = g_qolCvars[*slot - 1];
+        if (cvar)
+            info.cvar = cvar;
+        info.flags |= flags;
+        return;
+    }
+
+    g_qolCvars.push_back({ name, cvar, flags, nullptr });
+    *slot = (uint32_t)g_qolCvars.size();
+}
+
+void QOL_RegisterCevar(cevar_t* cevar) {
+    if (!cevar || !cevar->base || !cevar->base->name)
+        return;
+
+    uint32_t* slot = QOL_FindSlot(cevar->base->name);
+    if (slot && *slot)
+        g_qolCvars[*slot - 1].cevar = cevar;
+}
+
+const qol_cvar_info* QOL_FindRegisteredCvar(const char* name) {
+    uint32_t* slot = name ? QOL_FindSlot(name) : nullptr;
+    return slot && *slot ? &g_qolCvars[*slot - 1] : nullptr;
+}
+
+const std::vector<qol_cvar_info>& QOL_GetRegisteredCvars() {
+    return g_qolCvars;
+}
+
+// ============================================================================
+// CEVAR VIEWS
+// ============================================================================
+
+struct cevar_view_binding {
+    void* view;
+    const void* holder;     // cvar_t* const* or cevar_t* const*
+    bool holds_cevar;
+    bool is_float;
+    float fallback_float;
+    int fallback_int;
+};
+
+static std::vector<cevar_view_binding> g_cevarViews;
+
+static const cvar_t* Cevar_ViewCvar(const cevar_view_binding& binding) {
+    if (binding.holds_cevar) {
+        const cevar_t* cevar = *(cevar_t* const*)binding.holder;
+        return cevar ? cevar->base : nullptr;
+    }
+
+    return *(cvar_t* const*)binding.holder;
+}
+
+static void Cevar_UpdateView(const cevar_view_binding& binding, const cvar_t* cvar) {
+    if (binding.is_float)
+        ((cevar_view<float>*)binding.view)->value = cvar ? cvar->value : binding.fallback_float;
+    else
+        ((cevar_view<int>*)binding.view)->value = cvar ? cvar->integer : binding.fallback_int;
+}
+
+static void Cevar_AddView(const cevar_view_binding& binding) {
+    g_cevarViews.push_back(binding);
+    Cevar_UpdateView(binding, Cevar_ViewCvar(binding));
+}
+
+void Cevar_BindView(cevar_view<float>& view, cvar_t* const& cvar, float fallback) {
+    Cevar_AddView({ &view, &cvar, false, true, fallback, 0 });
+}
+
+void Cevar_BindView(cevar_view<int>& view, cvar_t* const& cvar, int fallback) {
+    Cevar_AddView({ &view, &cvar, false, false, 0.f, fallback });
+}
+
+void Cevar_BindView(cevar_view<float>& view, cevar_t* const& cevar, float fallback) {
+    Cevar_AddView({ &view, &cevar, true, true, fallback, 0 });
+}
+
+void Cevar_BindView(cevar_view<int>& view, cevar_t* const& cevar, int fallback) {
+    Cevar_AddView({ &view, &cevar, true, false, 0.f, fallback });
+}
+
+void Cevar_RefreshViews(const cvar_t* cvar) {
+    for (const auto& binding : g_cevarViews) {
+        const cvar_t* bound = Cevar_ViewCvar(binding);
+        if (!cvar || bound == cvar)
+            Cevar_UpdateView(binding, bound);
+    }
+}
+
+// ============================================================================
+// VALUE PARSING / FORMATTING
+// ============================================================================
+
+// from_chars doesn't take the leading whitespace and '+' atof/atoi accept
+static const char* Cevar_SkipNumberPrefix(const char* value) {
+    while (*value == ' ' || (*value >= '\t' && *value <= '\r'))
+        value++;
+    if (*value == '+' && value[1] != '-')
+        value++;
+    return value;
+}
+
+float Cevar_ParseFloat(const char* value) {
+    value = Cevar_SkipNumberPrefix(value);
+
+    float result = 0.f;
+    auto [ptr, ec] = std::from_chars(value, value + strlen(value), result);
+
+    // hex floats and overflow are rare enough to leave to atof
+    if (ec == std::errc::result_out_of_range || (ec == std::errc() && (*ptr == 'x' || *ptr == 'X')))
+        return (float)atof(value);
+
+    return ec == std::errc() ? result : 0.f;
+}
+
+int Cevar_ParseInt(const char* value) {
+    value = Cevar_SkipNumberPrefix(value);
+
+    int result = 0;
+    auto [ptr, ec] = std::from_chars(value, value + strlen(value), result);
+    if (ec == std::errc::result_out_of_range)
+        return *value == '-' ? INT_MIN : INT_MAX;
+
+    return ec == std::errc() ? result : 0;
+}
+
+const char* Cevar_FormatFloat(char (&buffer)[32], float value) {
+    auto [ptr, ec] = std::to_chars(buffer, buffer + sizeof(buffer) - 1, value, std::chars_format::fixed, 6);
+    if (ec != std::errc()) {
+        // huge values don't fit "%f" in 32 chars (sprintf used to overrun the buffer), use the shortest exact form
+        ptr = std::to_chars(buffer, buffer + sizeof(buffer) - 1, value).ptr;
+    }
+
+    *ptr = '\0';
+    return buffer;
+}
+
+const char* Cevar_FormatInt(char (&buffer)[32], int value) {
+    *std::to_chars(buffer, buffer + sizeof(buffer) - 1, value).ptr = '\0';
+    return buffer;
+}
+
 // ============================================================================
 // STRING OVERLOADS
 // ============================================================================
@@ -148,6 +354,8 @@ bool Cevar_Set(cevar_t* cevar, const char* value) {
         Cvar_Set_og.ccall<cvar_s*>(cevar->base->name, value, true);
     }
 
+    Cevar_RefreshViews(cevar->base);
+
     // Trigger callback if value changed
     if (cevar->callback && strcmp(oldValue, cevar->base->string) != 0) {
         cevar->callback(cevar->base, oldValue);
@@ -171,6 +379,8 @@ bool Cevar_Set(cevar_t* cevar, float value) {
     sprintf(buffer, "%f", value);
     Cvar_Set_og.ccall<cvar_s*>(cevar->base->name, buffer, true);
 
+    Cevar_RefreshViews(cevar->base);
+
     // Trigger callback if value changed
     if (cevar->callback && strcmp(oldValue, cevar->base->string) != 0) {
         cevar->callback(cevar->base, oldValue);
@@ -194,6 +404,8 @@ bool Cevar_Set(cevar_t* cevar, int value) {
     sprintf(buffer, "%d", value);
     Cvar_Set_og.ccall<cvar_s*>(cevar->base->name, buffer, true);
 
+    Cevar_RefreshViews(cevar->base);
+
     // Trigger callback if value changed
     if (cevar->callback && strcmp(oldValue, cevar->base->string) != 0) {
         cevar->callback(cevar->base, oldValue);
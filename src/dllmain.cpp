@@ -10,7 +10,11 @@ import game;
 #include "utils/common.h"
 #include "cexception.hpp"
 #include "utils/hooking.h"
+#include "utils/hookstats.h"
+#include "widescreen_layout.h"
+#include "menuwide.h"
 #include <direct.h>
+#include <chrono>
 //#include "MinHook.h"
 
 
@@ -30,17 +34,15 @@ static char charbuffer[2048]{};
 
 
 
-std::vector<const char*> QOL_registered_cvars;
 typedef cvar_t* (__cdecl* Cvar_GetT)(const char* var_name, const char* var_value, int flags);
 Cvar_GetT Cvar_GetPtr = (Cvar_GetT)NULL;
 
 cvar_t* __cdecl Cvar_Get(const char* var_name, const char* var_value, int flag) {
 
-    if (!(std::find(QOL_registered_cvars.begin(), QOL_registered_cvars.end(), var_name) != QOL_registered_cvars.end())) {
-        QOL_registered_cvars.push_back(var_name);
-    }
+    auto cvar = Cvar_GetPtr(var_name, var_value, flag);
+    QOL_RegisterCvar(var_name, cvar, flag);
 
-    return Cvar_GetPtr(var_name, var_value, flag);
+    return cvar;
 }
 
 // SP Only
@@ -76,6 +78,15 @@ cvar_t* hook_version;
 
 cevar_t* r_qol_texture_filter_anisotropic;
 
+// read by the widescreen/HUD layout hooks every frame, bound in Cvar_Init_hook
+struct alignas(64) layout_cvar_views {
+    cevar_view<int> fixedAspect;
+    cevar_view<float> safeAreaHorizontal;
+    cevar_view<float> safeAreaVertical;
+    cevar_view<int> hudelemAlignhack;
+};
+layout_cvar_views g_layoutViews;
+
 void codDLLhooks(HMODULE handle);
 
 void ui_hooks(HMODULE handle);
@@ -314,6 +325,7 @@ double ApplyFOVScale(double fov, double fovScale, bool useFixedAspect, bool dofo
 }
 
 double CG_GetViewFov_hook() {
+    HOOK_STATS("CG_GetViewFov_hook");
     double fov = CG_GetViewFov_og_S->call<double>();
 
     // Apply minimum FOV constraint
@@ -414,71 +426,63 @@ int __stdcall glviewport_47BD978 (DWORD xo, DWORD yo , DWORD x, DWORD y) {
 }
 
 
-LPVOID GetModuleEndAddress(HMODULE hModule) {
-    if (hModule == NULL) {
-        return NULL;
-    }
-
-
-    PIMAGE_DOS_HEADER pDosHeader = (PIMAGE_DOS_HEADER)hModule;
-
-
-    if (pDosHeader->e_magic != IMAGE_DOS_SIGNATURE) {
-        return NULL;
-    }
-
-
-    PIMAGE_NT_HEADERS pNtHeaders = (PIMAGE_NT_HEADERS)((BYTE*)hModule + pDosHeader->e_lfanew);
-
-
-    if (pNtHeaders->Signature != IMAGE_NT_SIGNATURE) {
-        return NULL;
-    }
-
-
-    DWORD imageSize = pNtHeaders->OptionalHeader.SizeOfImage;
+// Layout offsets only change with the resolution or the layout cvars, every hook below reads them from here
+widescreen_layout_cache g_layoutCache;
 
-
-    return (LPVOID)((BYTE*)hModule + imageSize);
+const widescreen_layout& GetWidescreenLayout() {
+    const int* res = (int*)LoadedGame->X_res_Addr;
+    return g_layoutCache.get({ res[0], res[1], g_layoutViews.fixedAspect, g_layoutViews.safeAreaHorizontal, g_layoutViews.safeAreaVertical });
 }
 
 // For glOrtho - adjusts screen-space ortho projection
 double process_widths(double width = 0) {
-    if (cg_fixedAspect && !cg_fixedAspect->base->integer) {
+    if (!g_layoutViews.fixedAspect) {
         return 0.f;
     }
-    float x = (float)*(int*)LoadedGame->X_res_Addr;
-    float y = (float)*(int*)(LoadedGame->X_res_Addr + 0x4);
-
-    // orthoWidth = (x / y)  (3/4)  y = (x  3) / (4y)
-    float orthoWidth = (x * x * 3.0f) / (4.0f * y);
-
-    width += (orthoWidth - x) / 2.0f;
 
-    return width;
+    return width + GetWidescreenLayout().orthoOffset;
 }
 
 // For game functions - adjusts game's internal 480-based coordinate system
 double process_width(double width = 0) {
-
-    if (cg_fixedAspect && !cg_fixedAspect->base->integer) {
+    if (!g_layoutViews.fixedAspect) {
         return 0.f;
     }
 
-    float x = (float)*(int*)LoadedGame->X_res_Addr;
-    float y = (float)*(int*)(LoadedGame->X_res_Addr + 0x4);
-
-    // Same formula but scaled to 480-height coordinate space
-    float aspect = x / y;
-    width += 480.0f * aspect - 640.0f;
-
-    return width;
+    return width + GetWidescreenLayout().virtualWidthOffset;
 }
 
 int process_width(int width) {
     return (int)process_width((double)0.f);
 }
 
+// signature hint cache next to our own module, see hook::load_hint_cache
+std::wstring GetSignatureHintsPath() {
+    std::wstring path = GetCurrentModuleName();
+    path.resize(path.find_last_of(L"/\\") + 1);
+    return path + TEXT(MOD_NAME) L".hints";
+}
+
+// menu/HUD alignment configs live next to the game executable
+std::filesystem::path GetMenuwideDir() {
+    char modulePath[MAX_PATH];
+    GetModuleFileNameA(NULL, modulePath, MAX_PATH);
+
+    return std::filesystem::path(modulePath).parent_path() / "menuwide";
+}
+
+// parsed menuwide configs, rebuilt whenever a file in menuwide/ changes
+std::wstring GetMenuwideCachePath() {
+    std::wstring path = GetCurrentModuleName();
+    path.resize(path.find_last_of(L"/\\") + 1);
+    return path + TEXT(MOD_NAME) L".menuwide.cache";
+}
+
+void SaveSignatureHints() {
+    if (!hook::save_hint_cache(GetSignatureHintsPath().c_str()))
+        printf("Failed to save signature hints\n");
+}
+
 SafetyHookInline LoadLibraryD;
 void game_hooks(HMODULE handle);
 HMODULE __stdcall LoadLibraryHook(const char* filename) {
@@ -502,6 +506,8 @@ HMODULE __stdcall LoadLibraryHook(const char* filename) {
         component_loader::on_ogl_load(hModule);
     }
 
+    SaveSignatureHints();
+
     return hModule;
 
 }
@@ -511,6 +517,10 @@ SafetyHookInline FreeLibraryD;
 
 bool is_shutdown = false;
 
+void InvalidateMenuCaches();
+void OpenGL_OnModuleUnload(HMODULE module);
+void OpenGL_FlushProgramCache();
+
 bool isShuttingDown() {
     return is_shutdown;
 }
@@ -522,103 +532,37 @@ BOOL __stdcall FreeLibraryHook(HMODULE hLibModule) {
 
         if (LoadedGame && LoadedGame->cgamename && (strstr(LibraryName, LoadedGame->cgamename) != 0)) {
             cg_game_offset = 0;
+            InvalidateMenuCaches();
         } else if (LoadedGame && LoadedGame->cgamename && (strstr(LibraryName, "uo_gamex86.dll") != 0)) {
             game_offset = 0;
         }
         else if (LoadedGame && LoadedGame->cgamename && (strstr(LibraryName, LoadedGame->uixname) != 0)) {
             ui_offset = 0;
+            InvalidateMenuCaches();
         }
 
-        uintptr_t moduleStart = (uintptr_t)hLibModule;
-        uintptr_t moduleEnd = (uintptr_t)GetModuleEndAddress(hLibModule);
-
-        if (moduleEnd != 0) {
-            // Check inline hooks
-            for (auto& hookPtr : g_inlineHooks) {
-                if (hookPtr) {
-                    uintptr_t targetAddr = (uintptr_t)hookPtr->target_address();
-                    if (targetAddr >= moduleStart && targetAddr < moduleEnd) {
-                        hookPtr->reset();
-                    }
-                }
-            }
-
-            // Check mid hooks
-            for (auto& hookPtr : g_midHooks) {
-                if (hookPtr) {
-                    uintptr_t targetAddr = (uintptr_t)hookPtr->target_address();
-                    if (targetAddr >= moduleStart && targetAddr < moduleEnd) {
-                        hookPtr->reset();
-                    }
-                }
-            }
-
-            // Clear out any reset hooks
-            g_inlineHooks.erase(
-                std::remove_if(g_inlineHooks.begin(), g_inlineHooks.end(),
-                    [](const std::unique_ptr<SafetyHookInline>& h) { return !h || !(*h); }),
-                g_inlineHooks.end()
-            );
-
-            g_midHooks.erase(
-                std::remove_if(g_midHooks.begin(), g_midHooks.end(),
-                    [](const std::unique_ptr<SafetyHookMid>& h) { return !h || !(*h); }),
-                g_midHooks.end()
-            );
-
-        }
+        OpenGL_OnModuleUnload(hLibModule);
+        UnloadModuleHooks(hLibModule);
     }
     auto hModule = FreeLibraryD.unsafe_stdcall<BOOL>(hLibModule);
     return hModule;
 }
 
 void ShutdownAllHooks() {
-    for (auto& hookPtr : g_inlineHooks) {
-        if (hookPtr) {
-            hookPtr->reset();
-        }
-    }
-
-    for (auto& hookPtr : g_midHooks) {
-        if (hookPtr) {
-            hookPtr->reset();
-        }
-    }
-
-
-    g_inlineHooks.clear();
-    g_midHooks.clear();
+    ResetAllHooks();
 
     cg_game_offset = 0;
     game_offset = 0;
     ui_offset = 0;
+    InvalidateMenuCaches();
 }
 
 float get_safeArea_horizontal() {
-    if (cg_fixedAspect && !cg_fixedAspect->base->integer) {
-        return 1.f;
-    }
-    float printing = safeArea_horizontal != 0 ? safeArea_horizontal->value : 1.f;
-
-    //printf("SafeArea cvar ptr %p %f\n", safeArea_horizontal, printing);
-
-    if (!safeArea_horizontal)
-        return 1.f;
-    return std::clamp(safeArea_horizontal->value, 0.f, 1.f);
+    return GetWidescreenLayout().safeAreaHorizontal;
 }
 
-
-
 float get_safeArea_vertical_hack() {
-    if (cg_fixedAspect && !cg_fixedAspect->base->integer) {
-        return 0.f;
-    }
-    if (!safeArea_vertical)
-        return 0.f;
-
-    // Clamp first, then invert
-    float clamped = std::clamp(safeArea_vertical->value, 0.f, 1.f);
-    return 1.f - clamped;
+    return GetWidescreenLayout().safeAreaVerticalHack;
 }
 
 int resolution_modded[2];
@@ -653,9 +597,7 @@ void Resolution_Static_mod_cb(cvar_s* cvar, const char* old_value = "") {
 }
 
 float process_height_hack_safe() {
-
-    return 240.f * get_safeArea_vertical_hack();
-
+    return GetWidescreenLayout().heightHackSafe;
 }
 
 //
@@ -699,16 +641,116 @@ uintptr_t InsideWinMain;
 
 uintptr_t cvar_init_og;
 
+cvar_t* qol_showallcvars_filter;
+cevar_t* qol_showallcvars_sort;
+
+// qol_showallcvars_filter narrows the list to names containing it, qol_showallcvars_sort picks
+// 0 registration order, 1 name, 2 cevars with limits first
 void PrintRegisteredCvars() {
-    Com_Printf("Registered QOL cvars (%d total):\n", QOL_registered_cvars.size());
-    for (const char* cvar : QOL_registered_cvars) {
-        Com_Printf("  %s\n", cvar);
+    const auto& registered = QOL_GetRegisteredCvars();
+    const char* filter = qol_showallcvars_filter && qol_showallcvars_filter->string ? qol_showallcvars_filter->string : "";
+    int sort = qol_showallcvars_sort ? qol_showallcvars_sort->base->integer : 0;
+
+    std::string lowerFilter = filter;
+    std::transform(lowerFilter.begin(), lowerFilter.end(), lowerFilter.begin(), [](unsigned char c) { return (char)tolower(c); });
+
+    std::vector<const qol_cvar_info*> shown;
+    for (const auto& info : registered) {
+        if (!lowerFilter.empty()) {
+            std::string lowerName = info.name;
+            std::transform(lowerName.begin(), lowerName.end(), lowerName.begin(), [](unsigned char c) { return (char)tolower(c); });
+            if (lowerName.find(lowerFilter) == std::string::npos)
+                continue;
+        }
+        shown.push_back(&info);
+    }
+
+    if (sort == 1) {
+        std::stable_sort(shown.begin(), shown.end(), [](const qol_cvar_info* a, const qol_cvar_info* b) {
+            return _stricmp(a->name.c_str(), b->name.c_str()) < 0;
+        });
+    }
+    else if (sort == 2) {
+        std::stable_sort(shown.begin(), shown.end(), [](const qol_cvar_info* a, const qol_cvar_info* b) {
+            return (a->cevar && a->cevar->limits.has_limits) > (b->cevar && b->cevar->limits.has_limits);
+        });
+    }
+
+    Com_Printf("Registered QOL cvars (%d total, %d shown):\n", (int)registered.size(), (int)shown.size());
+    for (const auto* info : shown) {
+        char limits[64] = "";
+        if (info->cevar && info->cevar->limits.has_limits) {
+            if (info->cevar->limits.is_float)
+                sprintf(limits, " ^3[%g, %g]", info->cevar->limits.f.min, info->cevar->limits.f.max);
+            else
+                sprintf(limits, " ^3[%d, %d]", info->cevar->limits.i.min, info->cevar->limits.i.max);
+        }
+
+        Com_Printf("  ^7%s = ^2%s^7%s%s%s%s\n", info->name.c_str(), info->cvar && info->cvar->string ? info->cvar->string : "",
+            info->cevar ? " ^2CEVAR" : "", info->flags & CVAR_LATCH ? " ^5Latch" : "", info->flags & CVAR_CHEAT ? " ^5Cheat" : "", limits);
+    }
+}
+
+void PrintHookModules() {
+    Com_Printf("%-24s %6s %6s %6s %10s %10s\n", "module", "loads", "inline", "mid", "install", "teardown");
+    for (const auto& stats : GetHookModuleStats()) {
+        Com_Printf("%-24s %6u %6u %6u %8.2fms %8.2fms%s\n", stats.name, stats.loads, (unsigned)stats.inlineHooks, (unsigned)stats.midHooks,
+            stats.installMs, stats.teardownMs, stats.end == stats.begin && stats.begin ? " (unloaded)" : "");
+    }
+
+    Com_Printf("\n%-24s %7s %6s %6s %6s %10s\n", "batch", "commits", "hooks", "writes", "pages", "commit");
+    for (const auto& stats : GetHookBatchStats()) {
+        Com_Printf("%-24s %7u %6u %6u %6u %8.2fms\n", stats.name, stats.commits, (unsigned)stats.hooks, (unsigned)stats.writes,
+            (unsigned)stats.pages, stats.commitMs);
+    }
+}
+
+// Chrome trace of the component phase dispatches, see component_loader::write_trace
+std::wstring GetComponentTracePath() {
+    std::wstring path = GetCurrentModuleName();
+    path.resize(path.find_last_of(L"/\\") + 1);
+    return path + L"yap_startup_trace.json";
+}
+
+void PrintComponentTimings() {
+    for (const auto& timing : component_loader::get_phase_timings()) {
+        Com_Printf("%s: %.2f ms (last of %u)\n", timing.phase, timing.total_ms, timing.dispatches);
+        for (const auto& [name, ms] : timing.components) {
+            if (ms >= 0.01)
+                Com_Printf("  %-40s %8.2f ms\n", name.c_str(), ms);
+        }
+    }
+
+    if (component_loader::write_trace(GetComponentTracePath()))
+        Com_Printf("wrote %ls\n", GetComponentTracePath().c_str());
+}
+
+#ifdef YAP_HOOKSTATS
+void BenchMenuConfigLookup();
+void BenchCvarSet();
+#endif
+
+void ReloadMenuwide() {
+    // directory_iterator throws for an unreadable directory, same as in the watcher
+    try {
+        Menuwide_Load(GetMenuwideDir(), GetMenuwideCachePath());
+    }
+    catch (const std::exception& e) {
+        Com_Printf("menuwide: reload failed: %s\n", e.what());
     }
 }
 
 int Cvar_Init_hook() {
 
+    // cg_fixedAspect missing counts as enabled, the safe areas as 1
+    Cevar_BindView(g_layoutViews.fixedAspect, cg_fixedAspect, 1);
+    Cevar_BindView(g_layoutViews.safeAreaHorizontal, safeArea_horizontal, 1.f);
+    Cevar_BindView(g_layoutViews.safeAreaVertical, safeArea_vertical, 1.f);
+    Cevar_BindView(g_layoutViews.hudelemAlignhack, cg_hudelem_alignhack, 0);
+
     component_loader::post_unpack();
+    SaveSignatureHints();
+    component_loader::write_trace(GetComponentTracePath());
 
     int* size_cvars = (int*)0x4805EC0;
     r_qol_texture_filter_anisotropic = Cevar_Get("r_qol_texture_filter_anisotropic", 16, CVAR_ARCHIVE | CVAR_LATCH, 1, 16);
@@ -744,12 +786,32 @@ int Cvar_Init_hook() {
 
     cg_hudelem_printnames = Cevar_Get("cg_hudelem_printnames", 0, CVAR_CHEAT,0,1);
 
+    // reloads menuwide/*.json while the game runs, for editing layouts
+    Cevar_Get("yap_menuwide_watch", 0, CVAR_ARCHIVE, 0, 1, [](cvar_t* cvar, const char*) {
+        if (cvar->integer)
+            Menuwide_StartWatcher(GetMenuwideDir(), GetMenuwideCachePath());
+        else
+            Menuwide_StopWatcher();
+        });
+    game::Cmd_AddCommand("yap_menuwide_reload", ReloadMenuwide);
+
+    qol_showallcvars_filter = Cvar_Get("qol_showallcvars_filter", "", 0);
+    qol_showallcvars_sort = Cevar_Get("qol_showallcvars_sort", 0, 0, 0, 2);
     game::Cmd_AddCommand("qol_showallcvars", PrintRegisteredCvars);
+    game::Cmd_AddCommand("yap_hookmodules", PrintHookModules);
+    game::Cmd_AddCommand("yap_componenttimes", PrintComponentTimings);
+#ifdef YAP_HOOKSTATS
+    game::Cmd_AddCommand("yap_hookstats", HookStats_Dump);
+    game::Cmd_AddCommand("yap_benchcvarset", BenchCvarSet);
+    game::Cmd_AddCommand("yap_benchmenus", BenchMenuConfigLookup);
+#endif
+
+    // the globals the views are bound to were only assigned above
+    Cevar_RefreshViews();
 
     return result;
 }
 
-void LoadMenuConfigs();
 
 
 
@@ -913,18 +975,6 @@ SafetyHookInline* Item_Paint_cg{};
 
 SafetyHookInline* Item_Paint_ui{};
 
-#define ALIGN_LEFT_BOTTOM   "[LB]"
-#define ALIGN_LEFT_TOP      "[LT]"
-#define ALIGN_RIGHT_BOTTOM  "[RB]"
-#define ALIGN_RIGHT_TOP     "[RT]"
-#define ALIGN_CENTER        "[CENTER]"
-#define ALIGN_LEFT          "[LEFT]"
-#define ALIGN_RIGHT         "[RIGHT]"
-#define ALIGN_TOP           "[TOP]"
-#define ALIGN_BOTTOM        "[BOTTOM]"
-#define ALIGN_STRETCH       "[STRETCH]"
-#define ALIGN_BLACKSCREEN   "[BLACKSCREEN]"
-
 // ============================================================================
 // ALIGNMENT PROCESSING FUNCTION
 // ============================================================================
@@ -934,220 +984,153 @@ struct AlignmentState {
     bool wasModified;
 };
 
-bool ProcessItemAlignment(itemDef_t* item, char* textBuffer, size_t bufferSize, AlignmentState* state) {
-    if (!item->text) return false;
-
-    const char* text = item->text;
-    state->originalText = text;
-    state->originalRect = item->window.rect;
-    state->wasModified = false;
-
-    float halfWidth = process_width() * 0.5f;
-    float safeX = get_safeArea_horizontal();
-
-    // Helper macro to check and process alignment
-#define CHECK_ALIGNMENT(marker, xOffset) \
-        if (strncmp(text, marker, strlen(marker)) == 0) { \
-            const char* remainingText = text + strlen(marker); \
-            if (remainingText[0] != '\0') { \
-                strcpy_s(textBuffer, bufferSize, remainingText); \
-                item->text = textBuffer; \
-            } else { \
-                item->text = nullptr; \
-            } \
-            item->window.rect.x += (xOffset); \
-            state->wasModified = true; \
-            return true; \
-        }
-
-    // Check each alignment marker
-    CHECK_ALIGNMENT(ALIGN_LEFT_BOTTOM, (-halfWidth) * safeX)
-        CHECK_ALIGNMENT(ALIGN_LEFT_TOP, (-halfWidth) * safeX)
-        CHECK_ALIGNMENT(ALIGN_RIGHT_BOTTOM, (halfWidth)*safeX)
-        CHECK_ALIGNMENT(ALIGN_RIGHT_TOP, (halfWidth)*safeX)
-        CHECK_ALIGNMENT(ALIGN_LEFT, (-halfWidth) * safeX)
-        CHECK_ALIGNMENT(ALIGN_RIGHT, (halfWidth)*safeX)
-        CHECK_ALIGNMENT(ALIGN_CENTER, 0.0f)
-        CHECK_ALIGNMENT(ALIGN_TOP, 0.0f)
-        CHECK_ALIGNMENT(ALIGN_BOTTOM, 0.0f)
-
-#undef CHECK_ALIGNMENT
-
-        return state->wasModified;
-}
-
-void RestoreItemState(itemDef_t* item, const AlignmentState* state) {
-    if (state->wasModified) {
-        item->text = state->originalText;
-        item->window.rect = state->originalRect;
-    }
-}
-
-
-// ============================================================================
-// JSON CONFIGURATION STRUCTURE
-// ============================================================================
-struct Alignment {
-    uint32_t h_left : 1;
-    uint32_t h_right : 1;
-    uint32_t h_center : 1;
-    uint32_t v_top : 1;
-    uint32_t v_bottom : 1;
-    uint32_t v_center : 1;
-    uint32_t stretch : 1;   // For stretch behavior
-    uint32_t black_screen : 1;
-    uint32_t _unused : 24;  // Padding to 32 bits
+// Text markers an item can start with, the marker is cut off before painting and moves the item horizontally
+enum class ItemTextMarker : uint8_t {
+    None,
+    LeftBottom,
+    LeftTop,
+    RightBottom,
+    RightTop,
+    Left,
+    Right,
+    Center,
+    Top,
+    Bottom,
 };
 
-struct MenuConfig {
-    std::string menuName;
-    Alignment alignment;
+struct ItemTextMarkerInfo {
+    const char* marker;
+    uint8_t length;
+    int8_t side;        // -1 left, 1 right, 0 no x offset
 };
 
-// Global storage for all menu configs
-std::vector<MenuConfig> g_menuConfigs;
-
-// ============================================================================
-// JSON PARSING - SUPPORTS MULTIPLE MENUS PER FILE
-// ============================================================================
+static constexpr ItemTextMarkerInfo g_itemTextMarkers[] = {
+    { "", 0, 0 },
+    { ALIGN_LEFT_BOTTOM, sizeof(ALIGN_LEFT_BOTTOM) - 1, -1 },
+    { ALIGN_LEFT_TOP, sizeof(ALIGN_LEFT_TOP) - 1, -1 },
+    { ALIGN_RIGHT_BOTTOM, sizeof(ALIGN_RIGHT_BOTTOM) - 1, 1 },
+    { ALIGN_RIGHT_TOP, sizeof(ALIGN_RIGHT_TOP) - 1, 1 },
+    { ALIGN_LEFT, sizeof(ALIGN_LEFT) - 1, -1 },
+    { ALIGN_RIGHT, sizeof(ALIGN_RIGHT) - 1, 1 },
+    { ALIGN_CENTER, sizeof(ALIGN_CENTER) - 1, 0 },
+    { ALIGN_TOP, sizeof(ALIGN_TOP) - 1, 0 },
+    { ALIGN_BOTTOM, sizeof(ALIGN_BOTTOM) - 1, 0 },
+};
 
-Alignment ParseAlignment(const std::string& alignStr) {
-    Alignment align = { 0 };
+ItemTextMarker ParseItemTextMarker(const char* text) {
+    if (text[0] != '[')
+        return ItemTextMarker::None;
 
-    if (alignStr == ALIGN_LEFT) {
-        align.h_left = 1;
-    }
-    else if (alignStr == ALIGN_RIGHT) {
-        align.h_right = 1;
-    }
-    else if (alignStr == ALIGN_CENTER) {
-        align.h_center = 1;
-        align.v_center = 1;
-    }
-    else if (alignStr == ALIGN_LEFT_BOTTOM) {
-        align.h_left = 1;
-        align.v_bottom = 1;
-    }
-    else if (alignStr == ALIGN_LEFT_TOP) {
-        align.h_left = 1;
-        align.v_top = 1;
-    }
-    else if (alignStr == ALIGN_RIGHT_BOTTOM) {
-        align.h_right = 1;
-        align.v_bottom = 1;
-    }
-    else if (alignStr == ALIGN_RIGHT_TOP) {
-        align.h_right = 1;
-        align.v_top = 1;
-    }
-    else if (alignStr == ALIGN_TOP) {
-        align.v_top = 1;
-    }
-    else if (alignStr == ALIGN_BOTTOM) {
-        align.v_bottom = 1;
-    }
-    else if (alignStr == ALIGN_STRETCH) {
-        align.stretch = 1;
-    }
-    else if (alignStr == ALIGN_BLACKSCREEN) {
-        align.black_screen = 1;
+    for (size_t i = 1; i < std::size(g_itemTextMarkers); i++) {
+        const auto& info = g_itemTextMarkers[i];
+        if (strncmp(text, info.marker, info.length) == 0)
+            return (ItemTextMarker)i;
     }
 
-    return align;
+    return ItemTextMarker::None;
 }
 
-static std::unordered_map<std::string, const MenuConfig*> g_menuConfigLookup;
-void LoadMenuConfigs() {
-    char modulePath[MAX_PATH];
-    GetModuleFileNameA(NULL, modulePath, MAX_PATH);
+// Marker per itemDef_t, parsed again when the item's text pointer changes. Dropped together with the menu config
+// cache.
+struct ItemTextMarkerCacheEntry {
+    const char* text;
+    ItemTextMarker marker;
+};
 
-    std::filesystem::path exePath(modulePath);
-    std::filesystem::path menuwideDir = exePath.parent_path() / "menuwide";
+static std::unordered_map<const itemDef_t*, ItemTextMarkerCacheEntry> g_itemTextMarkerCache;
 
-    if (!std::filesystem::exists(menuwideDir)) {
-        printf("menuwide directory not found: %s\n", menuwideDir.string().c_str());
-        return;
+ItemTextMarker GetItemTextMarker(const itemDef_t* item) {
+    auto& entry = g_itemTextMarkerCache[item];
+    if (entry.text != item->text) {
+        entry.text = item->text;
+        entry.marker = ParseItemTextMarker(item->text);
     }
 
-    printf("Loading menu configs from: %s\n", menuwideDir.string().c_str());
+    return entry.marker;
+}
 
-    for (const auto& entry : std::filesystem::directory_iterator(menuwideDir)) {
-        if (entry.path().extension() != ".json") continue;
+bool ProcessItemAlignment(itemDef_t* item, AlignmentState* state) {
+    if (!item->text) return false;
 
-        if (entry.path().filename() == "_hudelem_shaders.json") {
-            printf("Skipping _hudelem_shaders.json (handled separately)\n");
-            continue;
-        }
+    const char* text = item->text;
+    state->originalText = text;
+    state->originalRect = item->window.rect;
+    state->wasModified = false;
 
-        try {
-            std::ifstream file(entry.path());
-            nlohmann::json j = nlohmann::json::parse(file);
+    ItemTextMarker marker = GetItemTextMarker(item);
+    if (marker == ItemTextMarker::None)
+        return false;
 
-            if (j.is_array()) {
-                for (const auto& menuJson : j) {
-                    MenuConfig config;
-                    config.menuName = menuJson["menuName"].get<std::string>();
-                    config.alignment = ParseAlignment(menuJson["alignment"].get<std::string>());
+    const auto& info = g_itemTextMarkers[(size_t)marker];
 
-                    g_menuConfigs.push_back(config);
-                    printf("Loaded config for menu '%s'\n", config.menuName.c_str());
-                }
-            }
-            else {
-                MenuConfig config;
-                config.menuName = j["menuName"].get<std::string>();
-                config.alignment = ParseAlignment(j["alignment"].get<std::string>());
+    // the rest of the original string is painted, RestoreItemState puts the full text back afterwards
+    const char* remainingText = text + info.length;
+    item->text = remainingText[0] != '\0' ? remainingText : nullptr;
 
-                g_menuConfigs.push_back(config);
-                printf("Loaded config for menu '%s'\n", config.menuName.c_str());
-            }
-        }
-        catch (const std::exception& e) {
-            printf("Failed to parse %s: %s\n",
-                entry.path().string().c_str(), e.what());
-        }
+    if (info.side) {
+        float halfWidth = process_width() * 0.5f;
+        item->window.rect.x += (info.side * halfWidth) * get_safeArea_horizontal();
     }
 
-    g_menuConfigLookup.clear();
-    g_menuConfigLookup.reserve(g_menuConfigs.size());
+    state->wasModified = true;
+    return true;
+}
 
-    for (const auto& config : g_menuConfigs) {
-        std::string lowerName = config.menuName;
-        for (char& c : lowerName) {
-            c = std::tolower(static_cast<unsigned char>(c));
-        }
-        g_menuConfigLookup[lowerName] = &config;
+void RestoreItemState(itemDef_t* item, const AlignmentState* state) {
+    if (state->wasModified) {
+        item->text = state->originalText;
+        item->window.rect = state->originalRect;
     }
+}
+
+
+// Resolved config per menuDef_t, Item_Paint_Hook asks for every item of every painted menu each frame. The name
+// pointer is kept to catch a menuDef_t slot being reused for another menu; the whole cache is dropped when the
+// ui/cgame module goes away, on vid_restart and when the configs are reloaded.
+struct MenuConfigCacheEntry {
+    const char* name;
+    const MenuConfig* config;
+};
 
+static std::unordered_map<const menuDef_t*, MenuConfigCacheEntry> g_menuConfigCache;
+static unsigned g_menuConfigCacheGeneration = 0;
+
+void InvalidateMenuCaches() {
+    g_menuConfigCache.clear();
+    g_itemTextMarkerCache.clear();
 }
 
 // ============================================================================
 // LOOKUP FUNCTIONS
 // ============================================================================
-const MenuConfig* FindMenuConfig(const char* menuName) {
-    if (!menuName) return nullptr;
+const MenuConfig* FindMenuConfig(const menuDef_t* menu) {
+    if (!menu || !menu->window.name) return nullptr;
 
-    std::string lowerName = menuName;
-    for (char& c : lowerName) {
-        c = std::tolower(static_cast<unsigned char>(c));
+    // the configs were reloaded, the cached pointers belong to the previous tables
+    unsigned generation = Menuwide_GetGeneration();
+    if (generation != g_menuConfigCacheGeneration) {
+        g_menuConfigCache.clear();
+        g_menuConfigCacheGeneration = generation;
     }
 
-    auto it = g_menuConfigLookup.find(lowerName);
-    return (it != g_menuConfigLookup.end()) ? it->second : nullptr;
+    auto it = g_menuConfigCache.find(menu);
+    if (it != g_menuConfigCache.end() && it->second.name == menu->window.name)
+        return it->second.config;
+
+    const MenuConfig* config = FindMenuConfig(menu->window.name);
+    g_menuConfigCache[menu] = { menu->window.name, config };
+    return config;
 }
 
 // ============================================================================
 // ALIGNMENT PROCESSING - JSON VERSION
 // ============================================================================
-bool ProcessItemAlignment_FromJSON(itemDef_t* item, const char* menuName,
+bool ProcessItemAlignment_FromJSON(itemDef_t* item, const MenuConfig* config,
     AlignmentState* state) {
-    if (!menuName) return false;
-
     state->originalText = item->text;
     state->originalRect = item->window.rect;
     state->wasModified = false;
 
-    const MenuConfig* config = FindMenuConfig(menuName);
     if (!config) return false;
 
     float halfWidth = process_width() * 0.5f;
@@ -1186,33 +1169,20 @@ bool ProcessItemAlignment_FromJSON(itemDef_t* item, const char* menuName,
 
 
 void __fastcall Item_Paint_Hook(itemDef_t* item, SafetyHookInline* hook, bool ui = false) {
-    char textBuffer[1024];
     AlignmentState state = { 0 };
 
-    const char* menuName = nullptr;
-    menuDef_t* menu = nullptr;
-    // Get menu name
-    auto parent_ptr = sp_mp((uintptr_t)item->parent, item->textSavegameInfo);
-    if (parent_ptr) {
-        menu = (menuDef_t*)parent_ptr;
-        if (menu && menu->window.name) {
-            menuName = menu->window.name;
-            //printf("menuName %s\n", menuName);
-        }
-    }
+    menuDef_t* menu = (menuDef_t*)sp_mp((uintptr_t)item->parent, item->textSavegameInfo);
+    const MenuConfig* config = FindMenuConfig(menu);
 
     // Try JSON-based alignment first (applies to entire menu)
-    bool processedFromJSON = ProcessItemAlignment_FromJSON(item, menuName, &state);
+    bool processedFromJSON = ProcessItemAlignment_FromJSON(item, config, &state);
 
     // If not found in JSON, fall back to text marker processing (per-item)
     if (!processedFromJSON) {
-        ProcessItemAlignment(item, textBuffer, sizeof(textBuffer), &state);
+        ProcessItemAlignment(item, &state);
     }
 
 
-    auto config = FindMenuConfig(menuName);
-
-
     if (item && item->window.name) {
         //printf("item %s\n", item->window.name);
     }
@@ -1233,13 +1203,84 @@ void __fastcall Item_Paint_Hook(itemDef_t* item, SafetyHookInline* hook, bool ui
 }
 
 void __fastcall Item_Paint_cg_f(itemDef_t* item) {
+    HOOK_STATS("Item_Paint_Hook (cgame)");
     Item_Paint_Hook(item, Item_Paint_cg,false);
 }
 
 void __fastcall Item_Paint_ui_f(itemDef_t* item) {
+    HOOK_STATS("Item_Paint_Hook (ui)");
     Item_Paint_Hook(item, Item_Paint_ui,true);
 }
 
+#ifdef YAP_HOOKSTATS
+// Paints nothing, resolves the config the way Item_Paint_Hook does for one menu per loaded config plus as many
+// unconfigured ones, each with MAX_MENUITEMS items: twice per item through a lowercased std::string copy of the name
+// and a std::string keyed map (the old path), by name without allocating, and through the per-menuDef cache.
+void BenchMenuConfigLookup() {
+    constexpr int frames = 100;
+
+    std::vector<std::string> names;
+    for (const auto& config : Menuwide_GetTables().menus) {
+        names.push_back(config.menuName);
+        names.push_back(config.menuName + "_unconfigured");
+    }
+
+    if (names.empty()) {
+        Com_Printf("no menu configs loaded\n");
+        return;
+    }
+
+    auto menus = std::make_unique<menuDef_t[]>(names.size());
+    for (size_t i = 0; i < names.size(); i++)
+        menus[i].window.name = names[i].c_str();
+
+    const MenuConfig* sink = nullptr;
+    auto time = [&](auto&& lookup) {
+        auto start = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < frames; frame++) {
+            for (size_t i = 0; i < names.size(); i++) {
+                for (int item = 0; item < MAX_MENUITEMS; item++)
+                    sink = lookup(&menus[i]);
+            }
+        }
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+    };
+
+    // the lookup table the old path used, rebuilt from the active tables
+    std::unordered_map<std::string, const MenuConfig*> oldLookup;
+    for (const auto& config : Menuwide_GetTables().menus) {
+        std::string lowerName = config.menuName;
+        for (char& c : lowerName)
+            c = std::tolower(static_cast<unsigned char>(c));
+        oldLookup[lowerName] = &config;
+    }
+
+    auto findOld = [&](const char* menuName) -> const MenuConfig* {
+        if (!menuName) return nullptr;
+
+        std::string lowerName = menuName;
+        for (char& c : lowerName)
+            c = std::tolower(static_cast<unsigned char>(c));
+
+        auto it = oldLookup.find(lowerName);
+        return (it != oldLookup.end()) ? it->second : nullptr;
+    };
+
+    double allocating = time([&](const menuDef_t* menu) {
+        findOld(menu->window.name);
+        return findOld(menu->window.name);
+    });
+    double byName = time([](const menuDef_t* menu) { return FindMenuConfig(menu->window.name); });
+    double cached = time([](const menuDef_t* menu) { return FindMenuConfig(menu); });
+
+    // the fake menus must not stay in the cache
+    InvalidateMenuCaches();
+
+    Com_Printf("%zu menus x %d items per frame: old (std::string, twice) %.3f ms, by name %.3f ms, cached %.3f ms (%p)\n",
+        names.size(), MAX_MENUITEMS, allocating, byName, cached, sink);
+}
+#endif
+
 uintptr_t DrawSingleHudElem2dog = 0;
 
 struct HudAlignmentState {
@@ -1251,7 +1292,7 @@ struct HudAlignmentState {
 };
 
 void ProcessHudElemAlignment(hudelem_s* hud, HudAlignmentState* state) {
-    if (!hud || !cg_hudelem_alignhack || !cg_hudelem_alignhack->base || !cg_hudelem_alignhack->base->integer) return;
+    if (!hud || !g_layoutViews.hudelemAlignhack) return;
 
     // Save original state
     state->originalAlignX = hud->alignx;
@@ -1317,6 +1358,7 @@ void RestoreHudElemState(hudelem_s* hud, const HudAlignmentState* state) {
 // ============================================================================
 
 int __fastcall DrawSingleHudElem2dHook(hudelem_s* thisa) {
+    HOOK_STATS("DrawSingleHudElem2dHook");
     HudAlignmentState state = { };
 
     if (thisa) {
@@ -1335,73 +1377,6 @@ int __fastcall DrawSingleHudElem2dHook(hudelem_s* thisa) {
     return result;
 }
 
-struct HudShaderConfig {
-    std::string shaderName;
-    Alignment alignment;
-};
-
-// Global storage for shader configs
-std::vector<HudShaderConfig> g_hudShaderConfigs;
-static std::unordered_map<std::string, const HudShaderConfig*> g_hudShaderLookup;
-void LoadHudShaderConfigs() {
-    char modulePath[MAX_PATH];
-    GetModuleFileNameA(NULL, modulePath, MAX_PATH);
-
-    std::filesystem::path exePath(modulePath);
-    std::filesystem::path configPath = exePath.parent_path() / "menuwide" / "_hudelem_shaders.json";
-
-    if (!std::filesystem::exists(configPath)) {
-        printf("_hudelem_shaders.json not found: %s\n", configPath.string().c_str());
-        return;
-    }
-
-    printf("Loading HUD shader configs from: %s\n", configPath.string().c_str());
-
-    try {
-        std::ifstream file(configPath);
-        nlohmann::json j = nlohmann::json::parse(file);
-
-        if (j.is_array()) {
-            for (const auto& shaderJson : j) {
-                HudShaderConfig config;
-                config.shaderName = shaderJson["shaderName"].get<std::string>();
-                config.alignment = ParseAlignment(shaderJson["alignment"].get<std::string>());
-
-                g_hudShaderConfigs.push_back(config);
-                printf("Loaded shader config for '%s' (stretch: %d)\n",
-                    config.shaderName.c_str(), config.alignment.stretch);
-            }
-        }
-    }
-    catch (const std::exception& e) {
-        printf("Failed to parse _hudelem_shaders.json: %s\n", e.what());
-    }
-
-    g_hudShaderLookup.clear();
-    g_hudShaderLookup.reserve(g_hudShaderConfigs.size());
-
-    for (const auto& config : g_hudShaderConfigs) {
-        std::string lowerName = config.shaderName;
-        for (char& c : lowerName) {
-            c = std::tolower(static_cast<unsigned char>(c));
-        }
-        g_hudShaderLookup[lowerName] = &config;
-    }
-
-}
-
-
-const HudShaderConfig* FindHudShaderConfig(const char* shaderName) {
-    if (!shaderName) return nullptr;
-
-    std::string lowerName = shaderName;
-    for (char& c : lowerName) {
-        c = std::tolower(static_cast<unsigned char>(c));
-    }
-
-    auto it = g_hudShaderLookup.find(lowerName);
-    return (it != g_hudShaderLookup.end()) ? it->second : nullptr;
-}
 SafetyHookMid* DrawObjectives;
 
 SafetyHookMid* DrawMissionObjectives;
@@ -1721,7 +1696,7 @@ void game_hooks(HMODULE handle) {
 
 
     if (player_sprintmult) {
-        auto pattern = hook::pattern(handle, "? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? DF E0 F6 C4 ? 7A ? 8B 41 ? 83 E0 ? C7 44 81");
+        auto pattern = hook::pattern(handle, "? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? DF E0 F6 C4 ? 7A ? 8B 41 ? 83 E0 ? C7 44 81"_sig);
         if (!pattern.empty())
             Memory::VP::Patch<float*>(pattern.get_first(2), &player_sprintmult->value);
 
@@ -1842,8 +1817,11 @@ void codDLLhooks(HMODULE handle) {
     uintptr_t OFFSET = (uintptr_t)handle;
     cg_game_offset = OFFSET;
     StaticInstructionPatches();
-    Memory::VP::InterceptCall(OFFSET + LoadedGame->CG_DrawFlashImage_Draw, DrawStretch_og, DrawStretch_300135B0);
-    Memory::VP::InterceptCall(cg(0x3001221A, 0x3001A8CF), DrawStretch_og, DrawStretch_300135B0);
+
+    // everything below is installed in one go when this returns
+    HookBatch batch("cgame");
+    batch.InterceptCall(OFFSET + LoadedGame->CG_DrawFlashImage_Draw, DrawStretch_og, DrawStretch_300135B0);
+    batch.InterceptCall(cg(0x3001221A, 0x3001A8CF), DrawStretch_og, DrawStretch_300135B0);
 
     //SprintT4_lol(handle);
 
@@ -1851,7 +1829,7 @@ void codDLLhooks(HMODULE handle) {
 
     x_modded = res[0] + (res[0] - (res[1] * GetAspectRatio()));
 
-    auto pat = hook::pattern(handle, "83 EC ? 8B 44 24 ? ? ? ? ? ? ? ? ? ? ? 8B 4C 24 ? 6A 00");
+    auto pat = hook::pattern(handle, "83 EC ? 8B 44 24 ? ? ? ? ? ? ? ? ? ? ? 8B 4C 24 ? 6A 00"_sig);
 
     if (!pat.empty()) {
         //SCR_DrawString_hook_possible1_detour = CreateInlineHook(pat.get_first(), SCR_DrawString_hook_possible1_detour);
@@ -1861,7 +1839,7 @@ void codDLLhooks(HMODULE handle) {
 
     }
 
-    pat = hook::pattern(handle, "? ? ? ? ? ? ? ? ? ? ? ? A1 ? ? ? ? ? ? ? ? ? ? 83 C8");
+    pat = hook::pattern(handle, "? ? ? ? ? ? ? ? ? ? ? ? A1 ? ? ? ? ? ? ? ? ? ? 83 C8"_sig);
 
     if (!pat.empty()) {
         fov_world = *pat.get_first<vector2*>(2);
@@ -1879,27 +1857,27 @@ void codDLLhooks(HMODULE handle) {
 
     Memory::VP::Read(x_scale_ptr, cg_screenXScale);
 
-    Memory::VP::Patch<void*>(y_scale_ptr, &DEFAULT_1_0);
-    Memory::VP::Patch<void*>(x_scale_ptr, &DEFAULT_1_0);
+    batch.Patch<void*>(y_scale_ptr, &DEFAULT_1_0);
+    batch.Patch<void*>(x_scale_ptr, &DEFAULT_1_0);
 
     printf("DEFAULT_1_0 %p\n", &DEFAULT_1_0);
 
-    Memory::VP::Patch<void*>(cg(0x30011F51 + 2,0x3001A484 + 2), &DEFUALT_SCREEN_WIDTH);
-    Memory::VP::Patch<void*>(cg(0x30011F03 + 2,0x3001A436 + 2), &DEFUALT_SCREEN_HEIGHT);
+    batch.Patch<void*>(cg(0x30011F51 + 2,0x3001A484 + 2), &DEFUALT_SCREEN_WIDTH);
+    batch.Patch<void*>(cg(0x30011F03 + 2,0x3001A436 + 2), &DEFUALT_SCREEN_HEIGHT);
 
 
-    Memory::VP::InterceptCall(cg(0x30011F68, 0x3001A49B), crosshair_render_func, crosshair_render_hook);
+    batch.InterceptCall(cg(0x30011F68, 0x3001A49B), crosshair_render_func, crosshair_render_hook);
 
-    auto pattern = hook::pattern(handle, "? ? ? ? ? ? 8B 41 ? 83 F8 ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? 75");
-    auto pattern2 = hook::pattern(handle, "? ? ? ? ? ? ? ? ? ? 8B 82 ? ? ? ? 50");
+    auto pattern = hook::pattern(handle, "? ? ? ? ? ? 8B 41 ? 83 F8 ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? 75"_sig);
+    auto pattern2 = hook::pattern(handle, "? ? ? ? ? ? ? ? ? ? 8B 82 ? ? ? ? 50"_sig);
     if (!pattern.empty() && !pattern2.empty()) {
-        Memory::VP::Patch<void*>(pattern.get_first(2), &DEFAULT_1_0);
-        Memory::VP::Patch<void*>(pattern.get_first(22), &DEFAULT_1_0);
+        batch.Patch<void*>(pattern.get_first(2), &DEFAULT_1_0);
+        batch.Patch<void*>(pattern.get_first(22), &DEFAULT_1_0);
 
-        Memory::VP::Patch<void*>(pattern2.get_first(2), &DEFUALT_SCREEN_HEIGHT);
-        Memory::VP::Patch<void*>(pattern2.get_first(60 + 2), &DEFUALT_SCREEN_WIDTH);
+        batch.Patch<void*>(pattern2.get_first(2), &DEFUALT_SCREEN_HEIGHT);
+        batch.Patch<void*>(pattern2.get_first(60 + 2), &DEFUALT_SCREEN_WIDTH);
 
-        Memory::VP::InjectHook(pattern2.get_first(89), trap_R_DrawStretchPic_center_cross);
+        batch.InjectHook(pattern2.get_first(89), trap_R_DrawStretchPic_center_cross);
     }
 
     static cevar_s* cg_drawCrosshair_friendly_green;
@@ -1908,7 +1886,7 @@ void codDLLhooks(HMODULE handle) {
         cg_drawCrosshair_friendly_green = Cevar_Get("cg_drawCrosshair_friendly_green",1,CVAR_ARCHIVE,0,1);
 
     if (sp_mp(1)) {
-        CreateMidHook(cg(0x30011916), [](SafetyHookContext& ctx) {
+        batch.Mid(cg(0x30011916), [](SafetyHookContext& ctx) {
             uint32_t* some_player_flags = (uint32_t*)cg(0x3026D9F0);
             if (is_enemy_crosshair) {
                 ctx.eip = cg(0x30011922);
@@ -1925,29 +1903,29 @@ void codDLLhooks(HMODULE handle) {
             });
     }
 
-    Memory::VP::InterceptCall(cg(0x30011222, 0x30019752), trap_R_DrawStretchPic, R_DrawStretchPic_leftsniper);
+    batch.InterceptCall(cg(0x30011222, 0x30019752), trap_R_DrawStretchPic, R_DrawStretchPic_leftsniper);
 
-    Memory::VP::InterceptCall(cg(0x30011270, 0x300197A0), trap_R_DrawStretchPic, R_DrawStretchPic_rightsniper);
+    batch.InterceptCall(cg(0x30011270, 0x300197A0), trap_R_DrawStretchPic, R_DrawStretchPic_rightsniper);
 
-    Memory::VP::Nop(cg(0x30011205, 0x30019735), 2);
+    batch.Nop(cg(0x30011205, 0x30019735), 2);
 
-    Memory::VP::Nop(cg(0x30011247, 0x30019777), 2);
+    batch.Nop(cg(0x30011247, 0x30019777), 2);
 
     CG_DrawPicAddr = cg(0x30013B70, 0x3001CAA0);
 
 
     if (sp_mp(0, 1)) {
-        Memory::VP::Nop(cg(0, 0x3004000A), 8);
+        batch.Nop(cg(0, 0x3004000A), 8);
     }
 
-    CG_GetViewFov_og_S = CreateInlineHook(OFFSET + LoadedGame->DLL_CG_GetViewFov_offset, &CG_GetViewFov_hook);
+    CG_GetViewFov_og_S = batch.Inline(OFFSET + LoadedGame->DLL_CG_GetViewFov_offset, &CG_GetViewFov_hook);
     //if (MH_CreateHook((void**)OFFSET + 0x2CC20, &CG_GetViewFov_hook, (void**)&CG_GetViewFov_og) != MH_OK) {
     //    MessageBoxW(NULL, L"FAILED TO HOOK", L"Error", MB_OK | MB_ICONERROR);
     //    return;
     //}
 
 // CG_DrawWeaponSelect
-    CreateMidHook(cg(0x30033A41, 0x30046C5B), [](SafetyHookContext& ctx) {
+    batch.Mid(cg(0x30033A41, 0x30046C5B), [](SafetyHookContext& ctx) {
         auto config = FindMenuConfig("weaponinfo");
         if (config && config->alignment.h_right) {
             *(float*)(ctx.esp + 0x10) += ((process_width() * 0.5f) * get_safeArea_horizontal());
@@ -1955,11 +1933,11 @@ void codDLLhooks(HMODULE handle) {
 
         });
 
-    Item_Paint_cg = CreateInlineHook(OFFSET + LoadedGame->Item_Paint, Item_Paint_cg_f);
+    Item_Paint_cg = batch.Inline(OFFSET + LoadedGame->Item_Paint, Item_Paint_cg_f);
 
-    pat = hook::pattern(handle, "50 51 6A ? FF 15 ? ? ? ? 83 C4 ? 83 C4 ? C3 ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? 83 EC");
+    pat = hook::pattern(handle, "50 51 6A ? FF 15 ? ? ? ? 83 C4 ? 83 C4 ? C3 ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? 83 EC"_sig);
     if (!pat.empty()) {
-        DrawObjectives = CreateMidHook(pat.get_first(), [](SafetyHookContext& ctx) {
+        DrawObjectives = batch.Mid(pat.get_first(), [](SafetyHookContext& ctx) {
             auto menuConfig = FindMenuConfig("Compass");
             if (menuConfig) {
                 if (menuConfig->alignment.h_left) {
@@ -1980,10 +1958,11 @@ void codDLLhooks(HMODULE handle) {
 
     auto SingleHudElem_ptr = cg(0x3001FB14, 0x3002A4C4);
     if (SingleHudElem_ptr) {
-        Memory::VP::InterceptCall(SingleHudElem_ptr, DrawSingleHudElem2dog, DrawSingleHudElem2dHook);
+        batch.InterceptCall(SingleHudElem_ptr, DrawSingleHudElem2dog, DrawSingleHudElem2dHook);
     }
     static auto mapname = Cvar_Find("mapname");
-    DrawHudElemMaterial_mid = CreateMidHook(cg(0x3001F8D4, 0x3002A26C), [](SafetyHookContext& ctx) {
+    DrawHudElemMaterial_mid = batch.Mid(cg(0x3001F8D4, 0x3002A26C), [](SafetyHookContext& ctx) {
+        HOOK_STATS("DrawHudElemMaterial_mid");
         const char* hud_elem_shader_name = (const char*)(ctx.esp + 0x1C);
         hudelem_s* elem = (hudelem_s*)ctx.edi;
         // Check if shader has a config
@@ -2068,14 +2047,14 @@ void codDLLhooks(HMODULE handle) {
 
         });
 
-    CreateMidHook(cg(0x3001F7DF), [](SafetyHookContext& ctx) {
+    batch.Mid(cg(0x3001F7DF), [](SafetyHookContext& ctx) {
 
         float& clock_x = *(float*)ctx.esi;
         clock_x -= (process_width() * 0.5f) * get_safeArea_horizontal();
 
         });
 
-    CreateMidHook(cg(0x3001F64B, 0x30029FEB), [](SafetyHookContext& ctx) {
+    batch.Mid(cg(0x3001F64B, 0x30029FEB), [](SafetyHookContext& ctx) {
 
         float* text_x = (float*)&ctx.ecx;
         AutoAnchor(text_x);
@@ -2086,12 +2065,12 @@ void codDLLhooks(HMODULE handle) {
 
     if (sp_mp(0, 1)) {
         // make CG_FOV archive in MP
-        Memory::VP::Patch<int>(cg(0, 0x3008523C), CVAR_ARCHIVE);
+        batch.Patch<int>(cg(0, 0x3008523C), CVAR_ARCHIVE);
     }
 
     if (cg(0x3002CDCD)) {
-        Memory::VP::Nop(cg(0x3002CDCD), 6);
-        CreateMidHook(cg(0x3002CDCD), [](SafetyHookContext& ctx) {
+        batch.Nop(cg(0x3002CDCD), 6);
+        batch.Mid(cg(0x3002CDCD), [](SafetyHookContext& ctx) {
 
             float current_weapon_ads = *(float*)(ctx.eax + 0x274);
 
@@ -2103,7 +2082,7 @@ void codDLLhooks(HMODULE handle) {
             });
     }
     else if (cg(0, 0x30040167)) {
-        CreateMidHook(cg(0,0x30040167), [](SafetyHookContext& ctx) {
+        batch.Mid(cg(0,0x30040167), [](SafetyHookContext& ctx) {
 
 
             HandleWeaponADS_hack((float*)&ctx.eax);
@@ -2113,8 +2092,8 @@ void codDLLhooks(HMODULE handle) {
 
     auto FOV_ads_2 = cg(0x3002CE48, 0x300401E5);
     if (FOV_ads_2) {
-        Memory::VP::Nop(FOV_ads_2, 6);
-        CreateMidHook(FOV_ads_2, [](SafetyHookContext& ctx) {
+        batch.Nop(FOV_ads_2, 6);
+        batch.Mid(FOV_ads_2, [](SafetyHookContext& ctx) {
             bool isSP = sp_mp(1);
 
             auto ptr = isSP ? ctx.edx : ctx.ecx;
@@ -2145,47 +2124,70 @@ void codDLLhooks(HMODULE handle) {
 
 
 SafetyHookInline Cvar_Set_og;
+
+// views and hardcoded callbacks for cvars that are not (only) cevars
+static void Cvar_Set_NotifyChanged(cvar_s* cvar) {
+    if (!cvar)
+        return;
+
+    Cevar_RefreshViews(cvar);
+
+    if (cvar == safeArea_horizontal) {
+        StaticInstructionPatches(NULL, false);
+        if (cg_fixedAspect)
+            set_cg_drawupperright_x_wide(cg_fixedAspect->base->integer);
+    } else if (cg_fixedAspect && cg_fixedAspect->base == cvar)
+        set_cg_drawupperright_x_wide(cvar->integer != 0);
+}
+
 cvar_s* __cdecl Cvar_Set(const char* cvar_name, const char* value, BOOL force) {
+    HOOK_STATS("Cvar_Set");
 
-    if (_stricmp(cvar_name, "cg_fov") == 0) {
+#ifdef YAP_TRACE_CG_FOV
+    if (cvar_name && _stricmp(cvar_name, "cg_fov") == 0) {
         printf("CG_FOV from %p %s\n", _ReturnAddress(), value);
     }
+#endif
 
     if (!cvar_name || !value) {
         return Cvar_Set_og.ccall<cvar_s*>(cvar_name, value, force);
     }
 
+    // the engine sets plenty of cvars every frame and almost none of them are cevars, skip the lookup for those
+    if (!Cevar_MaybeName(cvar_name)) {
+        auto cvar = Cvar_Set_og.ccall<cvar_s*>(cvar_name, value, force);
+        Cvar_Set_NotifyChanged(cvar);
+        return cvar;
+    }
+
     // Try to find existing cvar to get cevar
     cvar_t* existing_cvar = Cvar_Find(cvar_name);
     cevar_t* cevar = existing_cvar ? Cevar_FromCvar(existing_cvar) : nullptr;
 
-    std::string clamped_value = value;
+    char buffer[32];
+    const char* clamped_value = value;
     const char* oldValue = existing_cvar ? existing_cvar->string : nullptr;
 
     // Apply limits if cevar exists and has limits
     if (cevar && cevar->limits.has_limits) {
         if (cevar->limits.is_float) {
-            float val = (float)atof(value);
+            float val = Cevar_ParseFloat(value);
             float clamped = std::clamp(val, cevar->limits.f.min, cevar->limits.f.max);
 
             // Only clamp if different
             if (val != clamped) {
-                char buffer[32];
-                sprintf(buffer, "%f", clamped);
-                clamped_value = buffer;
+                clamped_value = Cevar_FormatFloat(buffer, clamped);
                 Com_Printf("^3[CEVAR]^7 '%s' clamped to %.2f (valid range: %.2f - %.2f)\n",
                     cvar_name, clamped, cevar->limits.f.min, cevar->limits.f.max);
             }
         }
         else {
-            int val = atoi(value);
+            int val = Cevar_ParseInt(value);
             int clamped = std::clamp(val, cevar->limits.i.min, cevar->limits.i.max);
 
             // Only clamp if different
             if (val != clamped) {
-                char buffer[32];
-                sprintf(buffer, "%d", clamped);
-                clamped_value = buffer;
+                clamped_value = Cevar_FormatInt(buffer, clamped);
                 Com_Printf("^3[CEVAR]^7 '%s' clamped to %d (valid range: %d - %d)\n",
                     cvar_name, clamped, cevar->limits.i.min, cevar->limits.i.max);
             }
@@ -2193,7 +2195,7 @@ cvar_s* __cdecl Cvar_Set(const char* cvar_name, const char* value, BOOL force) {
     }
 
 
-    auto cvar = Cvar_Set_og.ccall<cvar_s*>(cvar_name, clamped_value.c_str(), force);
+    auto cvar = Cvar_Set_og.ccall<cvar_s*>(cvar_name, clamped_value, force);
 
     // Check if value actually changed
     bool value_changed = false;
@@ -2217,17 +2219,153 @@ cvar_s* __cdecl Cvar_Set(const char* cvar_name, const char* value, BOOL force) {
         cevar->callback(cvar, oldValue);
     }
 
-    // Special hardcoded callbacks
-    if (cvar == safeArea_horizontal) {
-        StaticInstructionPatches(NULL, false);
-        if (cg_fixedAspect)
-            set_cg_drawupperright_x_wide(cg_fixedAspect->base->integer);
-    } else if (cg_fixedAspect && cg_fixedAspect->base == cvar)
-        set_cg_drawupperright_x_wide(cvar->integer != 0);
+    Cvar_Set_NotifyChanged(cvar);
 
     return cvar;
 }
 
+#ifdef YAP_HOOKSTATS
+// Sets nothing, times what the detour does before calling the original: the old path as it was before the name
+// filter (the cg_fov check, Cvar_Find and a cvar -> cevar map for every name, the value copied into a std::string,
+// atof/atoi and a sprintf rebuild of clamped values) against the current one. Runs over every registered cevar with
+// its current value and, for the limited ones, a value above the range, and over the plain cvars this plugin registers
+// plus some engine ones. The clamp message is left out of both paths.
+void BenchCvarSet() {
+    constexpr int rounds = 10000;
+
+    struct bench_set {
+        const char* name;
+        const char* value;
+    };
+
+    const auto& registered = QOL_GetRegisteredCvars();
+
+    // the lookup the old path used, rebuilt from the registered cevars
+    std::unordered_map<cvar_t*, cevar_t*> oldCevars;
+    for (const auto& info : registered) {
+        if (info.cevar)
+            oldCevars[info.cevar->base] = info.cevar;
+    }
+
+    std::vector<bench_set> cevarSets;
+    std::vector<bench_set> clampedSets;
+    std::vector<bench_set> plainSets;
+    std::vector<std::string> outOfRange;
+    outOfRange.reserve(registered.size()); // never reallocates, clampedSets points into it
+
+    for (const auto& info : registered) {
+        if (!info.cvar || !info.cvar->string)
+            continue;
+
+        // the old path printed every cg_fov set
+        if (_stricmp(info.name.c_str(), "cg_fov") == 0)
+            continue;
+
+        if (!info.cevar) {
+            plainSets.push_back({ info.name.c_str(), info.cvar->string });
+            continue;
+        }
+
+        cevarSets.push_back({ info.name.c_str(), info.cvar->string });
+
+        const cevar_limits& limits = info.cevar->limits;
+        if (limits.has_limits && (limits.is_float || limits.i.max < INT_MAX)) {
+            char buffer[32];
+            outOfRange.push_back(limits.is_float ? Cevar_FormatFloat(buffer, limits.f.max + 1.f) : Cevar_FormatInt(buffer, limits.i.max + 1));
+            clampedSets.push_back({ info.name.c_str(), outOfRange.back().c_str() });
+        }
+    }
+
+    static const char* engineNames[] = { "cl_paused", "sv_paused", "cl_running", "sv_running", "timescale", "r_gamma",
+        "sensitivity", "name", "com_maxfps" };
+    for (const char* name : engineNames) {
+        if (!Cevar_FromCvar(name))
+            plainSets.push_back({ name, "1" });
+    }
+
+    float sink = 0.f;
+    auto time = [&](const std::vector<bench_set>& sets, auto&& set) {
+        if (sets.empty())
+            return 0.0;
+
+        auto start = std::chrono::steady_clock::now();
+        for (int round = 0; round < rounds; round++) {
+            for (const auto& entry : sets)
+                set(entry.name, entry.value);
+        }
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / ((double)rounds * sets.size());
+    };
+
+    auto oldPath = [&](const char* cvar_name, const char* value) {
+        if (_stricmp(cvar_name, "cg_fov") == 0) {
+            printf("CG_FOV from %p %s\n", _ReturnAddress(), value);
+        }
+
+        cvar_t* existing_cvar = Cvar_Find(cvar_name);
+        auto it = existing_cvar ? oldCevars.find(existing_cvar) : oldCevars.end();
+        cevar_t* cevar = it != oldCevars.end() ? it->second : nullptr;
+
+        std::string clamped_value = value;
+        if (cevar && cevar->limits.has_limits) {
+            if (cevar->limits.is_float) {
+                float val = (float)atof(value);
+                float clamped = std::clamp(val, cevar->limits.f.min, cevar->limits.f.max);
+                if (val != clamped) {
+                    char buffer[32];
+                    sprintf(buffer, "%f", clamped);
+                    clamped_value = buffer;
+                }
+            }
+            else {
+                int val = atoi(value);
+                int clamped = std::clamp(val, cevar->limits.i.min, cevar->limits.i.max);
+                if (val != clamped) {
+                    char buffer[32];
+                    sprintf(buffer, "%d", clamped);
+                    clamped_value = buffer;
+                }
+            }
+        }
+        sink += clamped_value.size();
+    };
+
+    auto newPath = [&](const char* cvar_name, const char* value) {
+        if (!Cevar_MaybeName(cvar_name)) {
+            sink += 1.f;
+            return;
+        }
+
+        cvar_t* existing_cvar = Cvar_Find(cvar_name);
+        cevar_t* cevar = existing_cvar ? Cevar_FromCvar(existing_cvar) : nullptr;
+
+        char buffer[32];
+        const char* clamped_value = value;
+        if (cevar && cevar->limits.has_limits) {
+            if (cevar->limits.is_float) {
+                float val = Cevar_ParseFloat(value);
+                float clamped = std::clamp(val, cevar->limits.f.min, cevar->limits.f.max);
+                if (val != clamped)
+                    clamped_value = Cevar_FormatFloat(buffer, clamped);
+            }
+            else {
+                int val = Cevar_ParseInt(value);
+                int clamped = std::clamp(val, cevar->limits.i.min, cevar->limits.i.max);
+                if (val != clamped)
+                    clamped_value = Cevar_FormatInt(buffer, clamped);
+            }
+        }
+        sink += clamped_value[0];
+    };
+
+    Com_Printf("%zu cevars: old path %.1f ns, new path %.1f ns per set\n",
+        cevarSets.size(), time(cevarSets, oldPath), time(cevarSets, newPath));
+    Com_Printf("%zu clamped cevar sets: old path %.1f ns, new path %.1f ns per set\n",
+        clampedSets.size(), time(clampedSets, oldPath), time(clampedSets, newPath));
+    Com_Printf("%zu plain cvars: old path %.1f ns, new path %.1f ns per set (%g)\n",
+        plainSets.size(), time(plainSets, oldPath), time(plainSets, newPath), sink);
+}
+#endif
+
 //SafetyHookInline SCR_AdjustFrom640_OG;
 bool ConsoleDrawing;
 void Con_DrawConsole() {
@@ -2292,7 +2430,7 @@ int __cdecl com_init_hook(void* unknown) {
 
         hook_version = Cvar_Get("hook_version", buffer, CVAR_ROM);
 
-        auto pattern = hook::pattern("8B 15 ? ? ? ? 8B 42 ? 83 C4 ? 8D 78");
+        auto pattern = hook::pattern("8B 15 ? ? ? ? 8B 42 ? 83 C4 ? 8D 78"_sig);
         if (!pattern.empty()) {
             Memory::VP::Patch<cvar_s**>(pattern.get_first(2), &hook_version);
         }
@@ -2317,7 +2455,10 @@ cvar_t* Cvar_get_Hook(const char* name, const char* value, int flags) {
     if (disable_cheats && disable_cheats->integer && flags & CVAR_CHEAT)
         flags &= ~CVAR_CHEAT;
 
-    return Cvar_getD.unsafe_ccall<cvar_s*>(name,value,flags);
+    // a latched value is applied here
+    auto cvar = Cvar_getD.unsafe_ccall<cvar_s*>(name,value,flags);
+    Cevar_RefreshViews(cvar);
+    return cvar;
 
 
 }
@@ -2454,6 +2595,9 @@ BOOL WritePrivateProfileStringW_UAL(LPCWSTR lpAppName, LPCWSTR lpKeyName, LPCWST
 }
 bool GameIsLargeAddressAware();
 void InitHook() {
+    auto init_start = std::chrono::steady_clock::now();
+    bool warm_hints = hook::load_hint_cache(GetSignatureHintsPath().c_str());
+
     CheckGame();
     if (!CheckGame()) {
         MessageBoxW(NULL, L"Unsupported game", TEXT(MOD_NAME), MB_OK | MB_ICONWARNING);
@@ -2530,7 +2674,7 @@ void InitHook() {
 
     com_initd = safetyhook::create_inline(exe(0x00431CA0, 0x0043BC10), com_init_hook);
 
-    auto pat = hook::pattern("FF 15 ? ? ? ? 8B 15 ? ? ? ? 52 E9");
+    auto pat = hook::pattern("FF 15 ? ? ? ? 8B 15 ? ? ? ? 52 E9"_sig);
 
     gexe::keyCatchers = (uint32_t*)exe(0x4842104);
 
@@ -2542,7 +2686,7 @@ void InitHook() {
 
         Memory::VP::Nop(call1, 6);
 
-        pat = hook::pattern("FF 15 ? ? ? ? 68 ? ? ? ? 68 ? ? ? ? 56");
+        pat = hook::pattern("FF 15 ? ? ? ? 68 ? ? ? ? 68 ? ? ? ? 56"_sig);
 
         if (!pat.empty()) {
             Memory::VP::Nop(pat.get_first(), 6);
@@ -2550,7 +2694,7 @@ void InitHook() {
             Memory::VP::InjectHook(call1, qglTexParameteri_aniso_hook1, Memory::VP::HookType::Call);
             Memory::VP::InjectHook(pat.get_first(), qglTexParameteri_aniso_hook2, Memory::VP::HookType::Call);
         }
-        pat = hook::pattern("FF 15 ? ? ? ? 83 C4 ? 5F 5E 5B 59 C3 68");
+        pat = hook::pattern("FF 15 ? ? ? ? 83 C4 ? 5F 5E 5B 59 C3 68"_sig);
         if (!pat.empty()) {
             static auto GL_EXT_texture_filter_anisotropic_check = safetyhook::create_mid(pat.get_first(-40), [](SafetyHookContext& ctx) {
                 GL_EXT_texture_filter_anisotropic_supported = ctx.eax != 0;
@@ -2566,7 +2710,7 @@ void InitHook() {
     }
     
 
-    pat = hook::pattern("E8 ? ? ? ? 8B 76 ? 83 C4 ? 85 F6 74");
+    pat = hook::pattern("E8 ? ? ? ? 8B 76 ? 83 C4 ? 85 F6 74"_sig);
 
     if (!pat.empty()) {
         Memory::VP::ReadCall(pat.get_first(), Com_Printf);
@@ -2655,11 +2799,11 @@ void InitHook() {
         Memory::VP::Patch((*(uintptr_t*)pat.get_first(-4)) +29, 0);
     }
 
-    pat = hook::pattern("53 8B 5C 24 ? 56 8B 74 24 ? 57 53");
+    pat = hook::pattern("53 8B 5C 24 ? 56 8B 74 24 ? 57 53"_sig);
         
         if(!pat.empty())
         Cvar_Set_og = safetyhook::create_inline(pat.get_first(), Cvar_Set);
-        pat = hook::pattern("E8 ? ? ? ? 83 C4 ? 8D 46 ? 5B 83 C4");
+        pat = hook::pattern("E8 ? ? ? ? 83 C4 ? 8D 46 ? 5B 83 C4"_sig);
         if(!pat.empty())
         static auto blur_test = safetyhook::create_mid(pat.get_first(), [](SafetyHookContext& ctx) {
 
@@ -2673,7 +2817,7 @@ void InitHook() {
 
             });
     
-        pat = hook::pattern("FF 15 ? ? ? ? 8B 44 24 ? 8B 4C 24 ? 2B 4C 24");
+        pat = hook::pattern("FF 15 ? ? ? ? 8B 44 24 ? 8B 4C 24 ? 2B 4C 24"_sig);
 
         if (!pat.empty()) {
             // Borderless
@@ -2691,7 +2835,7 @@ void InitHook() {
                 });
         }
 
-        pat = hook::pattern("8B 15 ? ? ? ? 8B 42 ? 5F");
+        pat = hook::pattern("8B 15 ? ? ? ? 8B 42 ? 5F"_sig);
 
         if (!pat.empty()) {
             static auto r_mode_auto_hook = safetyhook::create_mid(pat.get_first(), [](SafetyHookContext& ctx) {
@@ -2707,13 +2851,13 @@ void InitHook() {
                 });
         }
 
-        pat = hook::pattern("C7 44 24 ? ? ? ? ? C7 44 24 ? ? ? ? ? EB ? 57");
+        pat = hook::pattern("C7 44 24 ? ? ? ? ? C7 44 24 ? ? ? ? ? EB ? 57"_sig);
 
         if (!pat.empty()) {
             Memory::VP::Patch<uint32_t>(pat.get_first(4), WS_EX_LEFT);
         }
 
-    pat = hook::pattern("68 ? ? ? ? 56 FF 15 ? ? ? ? 83 C4 ? 5F");
+    pat = hook::pattern("68 ? ? ? ? 56 FF 15 ? ? ? ? 83 C4 ? 5F"_sig);
     if (!pat.empty()) {
         static auto R_init_end = safetyhook::create_mid(pat.get_first(), [](SafetyHookContext& ctx) {
             if(cg_fixedAspect)
@@ -2722,7 +2866,7 @@ void InitHook() {
             });
     }
 
-    pat = hook::pattern("? ? ? ? ? ? 6A 00 6A 00 51 ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? 50");
+    pat = hook::pattern("? ? ? ? ? ? 6A 00 6A 00 51 ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? 50"_sig);
     if (!pat.empty()) {
         Memory::VP::Patch<int*>(pat.get_first(2), resolution_modded);
     }
@@ -2734,27 +2878,26 @@ void InitHook() {
         Memory::VP::Patch<int*>(exe((0x0040A20E + 1),(0x0040B08B + 2)), resolution_modded);
     
 
-    pat = find_pattern("? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? E8 ? ? ? ? 83 F8 ? 89 44 24 ? 7D ? 89 6C 24","? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? E8 ? ? ? ? 83 F8 ? 89 44 24 ? 7D ? C7 44 24 ? 00 00 00 00");
+    pat = find_pattern("? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? E8 ? ? ? ? 83 F8 ? 89 44 24 ? 7D ? 89 6C 24"_sig,"? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? E8 ? ? ? ? 83 F8 ? 89 44 24 ? 7D ? C7 44 24 ? 00 00 00 00"_sig);
     if (!pat.empty()) {
         Memory::VP::Patch<int*>(pat.get_first(2), resolution_modded);
     }
-    pat = find_pattern("? ? ? ? ? ? 6A 00 6A 00 C7 44 24 ? ? ? ? ? ? ? ? ? ? ? C7 44 24","? ? ? ? ? ? C7 44 24 ? ? ? ? ? C7 44 24 ? ? ? ? ? C7 44 24 ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? 8B 44 24");
+    pat = find_pattern("? ? ? ? ? ? 6A 00 6A 00 C7 44 24 ? ? ? ? ? ? ? ? ? ? ? C7 44 24"_sig,"? ? ? ? ? ? C7 44 24 ? ? ? ? ? C7 44 24 ? ? ? ? ? C7 44 24 ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? 8B 44 24"_sig);
     if (!pat.empty()) {
         Memory::VP::Patch<int*>(pat.get_first(2), resolution_modded);
     }
-    pat = hook::pattern("? ? ? ? ? ? 33 FF 85 D2 0F 95 C2");
+    pat = hook::pattern("? ? ? ? ? ? 33 FF 85 D2 0F 95 C2"_sig);
     if (!pat.empty()) {
         Memory::VP::Patch<int*>(pat.get_first(2), resolution_modded);
     }
 
-    pat = hook::pattern("A1 ? ? ? ? 3D ? ? ? ? 56");
+    pat = hook::pattern("A1 ? ? ? ? 3D ? ? ? ? 56"_sig);
     if (!pat.empty()) {
         Memory::VP::Patch<int*>(pat.get_first(1), resolution_modded);
     }
 
     SetUpFunctions();
-    LoadMenuConfigs();
-    LoadHudShaderConfigs();
+    Menuwide_Load(GetMenuwideDir(), GetMenuwideCachePath());
 
     HHOOK windowsHook = SetWindowsHookExA(WH_CALLWNDPROC, [](int code, WPARAM w, LPARAM l) -> LRESULT {
     if (code < 0) return CallNextHookEx(NULL, code, w, l);
@@ -2906,17 +3049,19 @@ void InitHook() {
 
 
 
-    pat = hook::pattern("FF 15 ? ? ? ? 68 ? ? ? ? FF 15 ? ? ? ? FF 15 ? ? ? ? B8");
+    pat = hook::pattern("FF 15 ? ? ? ? 68 ? ? ? ? FF 15 ? ? ? ? FF 15 ? ? ? ? B8"_sig);
     if (!pat.empty()) {
         Memory::VP::Read(pat.get_first(2), glOrtho_ptr);
         Memory::VP::Nop(pat.get_first(0), 6);
         Memory::VP::InjectHook(pat.get_first(0), glOrtho_detour, Memory::VP::HookType::Call);
     }
 
-    pat = hook::pattern("85 C0 0F 85 ? ? ? ? A1 ? ? ? ? 85 C0 74 ? A1");
+    pat = hook::pattern("85 C0 0F 85 ? ? ? ? A1 ? ? ? ? 85 C0 74 ? A1"_sig);
     if (!pat.empty()) {
         static auto shutdown = safetyhook::create_mid(pat.get_first(-5), [](SafetyHookContext& ctx) {
             is_shutdown = true;
+            Menuwide_StopWatcher();
+            OpenGL_FlushProgramCache();
             component_loader::pre_destroy();
             // Required for steam exes otherwise crashes on unhooking
             ShutdownAllHooks();
@@ -2924,18 +3069,27 @@ void InitHook() {
             });
     }
 
-    pat = hook::pattern("A1 ? ? ? ? 8B 48 ? 53 33 DB 3B CB 74");
+    pat = hook::pattern("A1 ? ? ? ? 8B 48 ? 53 33 DB 3B CB 74"_sig);
 
     if (!pat.empty()) {
         static auto vid_restart = safetyhook::create_mid(pat.get_first(), [](SafetyHookContext& ctx) {
+            OpenGL_FlushProgramCache();
 
             cg_game_offset = 0;
             ui_offset = 0;
             game_offset = 0;
+            InvalidateMenuCaches();
 
             });
     }
 
+    SaveSignatureHints();
+
+    auto hint_stats = hook::get_hint_cache_stats();
+    printf("InitHook took %.2f ms (%s start, signature hints: %u hits, %u misses)\n",
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - init_start).count(),
+        warm_hints ? "warm" : "cold", hint_stats.hits, hint_stats.misses);
+
 }
 
 BOOL APIENTRY DllMain( HMODULE hModule,
@@ -35,6 +35,9 @@
 #include "nlohmann/json.hpp"
 #include <unordered_map>
 
+// "8B 15 ? ? ? ?"_sig compile-time pattern literals
+using namespace hook::literals;
+
 // cdecl
 template<typename Ret, typename... Args>
 inline Ret cdecl_call(uintptr_t addr, Args... args) {
@@ -64,17 +64,161 @@ namespace game {
 		cdecl_call<void>(SCR_DrawString_addr, x, y, fontID, scale, color, text, spaceBetweenChars, maxChars, arg9);
 	}
 
+	namespace details
+	{
+		static std::vector<symbolp_base*>& get_symbolps(game_module module)
+		{
+			static std::vector<symbolp_base*> symbolps[MAX_GAME_MODULE];
+			return symbolps[module];
+		}
+
+		static uintptr_t get_module_base(game_module module)
+		{
+			switch (module)
+			{
+			case CGAME:
+				return cg_game_offset;
+			case UI:
+				return ui_offset;
+			case GAME:
+				return game_offset;
+			default:
+				return (uintptr_t)GetModuleHandle(NULL);
+			}
+		}
+
+		// one pattern_batch pass per module load, each symbolp takes the first of its patterns that matched
+		static void resolve_symbolps(game_module module)
+		{
+			auto& symbolps = get_symbolps(module);
+
+			if (symbolps.empty())
+				return;
+
+			hook::pattern_batch batch((void*)get_module_base(module));
+			std::vector<size_t> first_index;
+			first_index.reserve(symbolps.size());
+
+			for (auto* symbol : symbolps)
+			{
+				first_index.push_back(batch.size());
+
+				for (const auto& pattern_str : symbol->get_patterns())
+					batch.add(pattern_str);
+			}
+
+			batch.scan();
+
+			for (size_t i = 0; i < symbolps.size(); ++i)
+			{
+				auto* symbol = symbolps[i];
+				const size_t count = symbol->get_patterns().size();
+				bool resolved = false;
+
+				for (size_t j = 0; j < count; ++j)
+				{
+					if (!batch.empty(first_index[i] + j))
+					{
+						symbol->resolve((uintptr_t)batch.get_first(first_index[i] + j));
+						resolved = true;
+						break;
+					}
+				}
+
+				if (!resolved)
+					symbol->fail();
+			}
+		}
+
+		class symbolp_resolver final : public component_interface
+		{
+		public:
+			void post_start() override
+			{
+				resolve_symbolps(EXE);
+			}
+
+			void post_cgame() override
+			{
+				resolve_symbolps(CGAME);
+			}
+
+			void post_ui() override
+			{
+				resolve_symbolps(UI);
+			}
+
+			void post_game_sp() override
+			{
+				resolve_symbolps(GAME);
+			}
+		};
+
+		void symbolp_base::register_symbolp(symbolp_base* symbol)
+		{
+			// registered with the first symbolp rather than through REGISTER_COMPONENT, so the resolver keeps
+			// running ahead of components from translation units that were initialized before this one
+			static bool resolver_registered = false;
+			if (!resolver_registered)
+			{
+				resolver_registered = true;
+				component_loader::register_component(std::make_unique<symbolp_resolver>());
+			}
+
+			get_symbolps(symbol->module).push_back(symbol);
+		}
+
+		void symbolp_base::resolve(uintptr_t match)
+		{
+			uintptr_t address = match + offset_val;
+
+			if (dereference)
+			{
+				assign(*reinterpret_cast<void**>(address));
+			}
+			else
+			{
+				assign(reinterpret_cast<void*>(address));
+			}
+		}
+
+		void symbolp_base::fail()
+		{
+			assign(nullptr);
+
+			std::string error_msg = "symbolp: All patterns failed to resolve!\nPatterns tried:\n";
+			for (size_t i = 0; i < patterns.size(); ++i)
+			{
+				error_msg += std::to_string(i + 1) + ": \"" + std::string(patterns[i]) + "\"\n";
+			}
+
+			MessageBoxA(NULL, error_msg.c_str(), MOD_NAME": Error", MB_ICONSTOP);
+		}
+	}
+
 	class component final : public component_interface
 	{
+		uintptr_t draw_string = 0;
+
 	public:
-		void post_unpack() override
+		bool is_scan_phase(component_phase phase) override
 		{
-			auto pattern = hook::pattern("8B 44 24 ? 8B 4C 24 ? 8B 54 24 ? 50 8B 44 24 ? 51 8B 4C 24 ? 52 8B 54 24 ? 6A 00");
+			return phase == component_phase::post_unpack;
+		}
+
+		void prepare(component_phase) override
+		{
+			auto pattern = hook::pattern("8B 44 24 ? 8B 4C 24 ? 8B 54 24 ? 50 8B 44 24 ? 51 8B 4C 24 ? 52 8B 54 24 ? 6A 00"_sig);
 			if (!pattern.empty()) {
-				SCR_DrawString_addr = (uintptr_t)pattern.get_first();
+				draw_string = (uintptr_t)pattern.get_first();
 			}
-			
+		}
 
+		void post_unpack() override
+		{
+			if (draw_string) {
+				SCR_DrawString_addr = draw_string;
+			}
 		}
 	};
 
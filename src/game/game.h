@@ -83,20 +83,60 @@ namespace game
 		MAX_GAME_MODULE,
 	};
 
+    namespace details
+    {
+        // Untyped part of symbolp. Every instance is queued per module and the whole queue is resolved with one
+        // hook::pattern_batch pass when that module (re)loads, see game.cpp.
+        class symbolp_base
+        {
+        public:
+            symbolp_base(std::initializer_list<std::string_view> patterns, const signed int offset_val, game_module module, bool dereference)
+                : patterns(patterns), offset_val(offset_val), module(module), dereference(dereference)
+            {
+                register_symbolp(this);
+            }
+
+            const std::vector<std::string_view>& get_patterns() const
+            {
+                return patterns;
+            }
+
+            game_module get_module() const
+            {
+                return module;
+            }
+
+            // address of the match for patterns[index], before offset_val is applied
+            void resolve(uintptr_t match);
+
+            // none of the patterns matched
+            void fail();
+
+        protected:
+            virtual void assign(void* object) = 0;
+
+        private:
+            static void register_symbolp(symbolp_base* symbol);
+
+            std::vector<std::string_view> patterns;
+            signed int offset_val;
+            game_module module;
+            bool dereference;
+        };
+    }
+
     template <typename T>
-    class symbolp
+    class symbolp : public details::symbolp_base
     {
     public:
         symbolp(std::initializer_list<std::string_view> patterns, const signed int offset_val = 0, game_module module = EXE, bool dereference = false)
-            : patterns(patterns), offset_val(offset_val), module(module), dereference(dereference), object(nullptr)
+            : symbolp_base(patterns, offset_val, module, dereference), object(nullptr)
         {
-            register_as_component();
         }
 
         symbolp(std::string_view pattern_str, const signed int offset_val = 0, game_module module = EXE, bool dereference = false)
-            : patterns({ pattern_str }), offset_val(offset_val), module(module), dereference(dereference), object(nullptr)
+            : symbolp_base({ pattern_str }, offset_val, module, dereference), object(nullptr)
         {
-            register_as_component();
         }
 
         T* get() const
@@ -119,100 +159,11 @@ namespace game
         //}
 
     private:
-        void register_as_component()
+        void assign(void* ptr) override
         {
-            class symbolp_resolver : public component_interface
-            {
-            public:
-                symbolp_resolver(symbolp* owner, game_module module) : owner(owner), module(module) {}
-
-                void post_start() override
-                {
-                    if (module == EXE) {
-                        owner->resolve();
-                    }
-                }
-
-                void post_cgame() override {
-                    if (module == CGAME)
-                        owner->resolve();
-                }
-
-                void post_ui() override {
-                    if (module == UI)
-                        owner->resolve();
-                }
-
-                void post_game_sp() override {
-                
-                    if (module == GAME)
-                        owner->resolve();
-
-                }
-
-            private:
-                symbolp* owner;
-                game_module module;
-            };
-
-            auto resolver = std::make_unique<symbolp_resolver>(this, module);
-            component_loader::register_component(std::move(resolver));
-        }
-
-        void resolve()
-        {
-            uintptr_t search_base = (uintptr_t)GetModuleHandle(NULL);
-
-            switch (module)
-            {
-            case CGAME:
-                search_base = cg_game_offset;
-                break;
-            case UI:
-                search_base = ui_offset;
-                break;
-            case GAME:
-                search_base = game_offset;
-                break;
-            }
-
-
-            for (const auto& pattern_str : patterns)
-            {
-                hook::pattern pattern((HMODULE)search_base, pattern_str);
-
-                if (!pattern.empty())
-                {
-                    uintptr_t address = reinterpret_cast<uintptr_t>(pattern.get_first()) + offset_val;
-
-                    if (dereference)
-                    {
-                        object = *reinterpret_cast<T**>(address);
-                    }
-                    else
-                    {
-                        object = reinterpret_cast<T*>(address);
-                    }
-                    return;
-                }
-            }
-
-            // All patterns failed - build error message
-            object = nullptr;
-
-            std::string error_msg = "symbolp: All patterns failed to resolve!\nPatterns tried:\n";
-            for (size_t i = 0; i < patterns.size(); ++i)
-            {
-                error_msg += std::to_string(i + 1) + ": \"" + std::string(patterns[i]) + "\"\n";
-            }
-
-            MessageBoxA(NULL, error_msg.c_str(), MOD_NAME": Error", MB_ICONSTOP);
+            object = reinterpret_cast<T*>(ptr);
         }
 
-        std::vector<std::string_view> patterns;
-        signed int offset_val;
-        game_module module;
-        bool dereference;
         mutable T* object;
     };
 
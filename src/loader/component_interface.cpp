@@ -1,9 +1,316 @@
 #include <helper.hpp>
 #include "component_loader.h"
 
+#include <algorithm>
+#include <exception>
+#include <map>
+
+namespace
+{
+	struct timing_event
+	{
+		const char* phase;
+		std::string name;
+		double start_us;
+		double duration_us;
+		DWORD thread_id;
+	};
+
+	struct phase_record
+	{
+		unsigned int dispatches = 0;
+		double total_ms = 0.0;
+		std::vector<std::pair<std::string, double>> components;
+	};
+
+	// a map load dispatches a few phases, keeps the trace bounded if the game runs for a long time
+	constexpr size_t max_timing_events = 16384;
+
+	struct timing_state
+	{
+		std::mutex mutex;
+		std::vector<timing_event> events;
+		std::map<std::string, phase_record> phases;
+		std::vector<const char*> phase_order;
+	};
+
+	timing_state& get_timing_state()
+	{
+		// leaked, pre_destroy can still be dispatched from the component container's destructor
+		static auto* state = new timing_state;
+		return *state;
+	}
+
+	double now_us()
+	{
+		// pinned by the first registered component, so trace timestamps start at DLL load
+		static const auto epoch = std::chrono::steady_clock::now();
+		return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - epoch).count();
+	}
+
+	std::string get_component_name(const component_interface& component_)
+	{
+		// MSVC names are "class weapon::component"
+		std::string name = typeid(component_).name();
+		for (const char* prefix : { "class ", "struct " })
+		{
+			if (name.rfind(prefix, 0) == 0)
+			{
+				name.erase(0, strlen(prefix));
+				break;
+			}
+		}
+
+		return name;
+	}
+
+	void record_dispatch(const char* phase, std::vector<timing_event>&& events, double start_us, double duration_us)
+	{
+		auto& state = get_timing_state();
+		std::lock_guard lock(state.mutex);
+
+		auto& record = state.phases[phase];
+		if (record.dispatches++ == 0)
+		{
+			state.phase_order.push_back(phase);
+		}
+
+		record.total_ms = duration_us / 1000.0;
+		record.components.clear();
+		for (const auto& event : events)
+		{
+			record.components.emplace_back(event.name, event.duration_us / 1000.0);
+		}
+
+		if (state.events.size() + events.size() + 1 > max_timing_events)
+		{
+			return;
+		}
+
+		state.events.push_back({ phase, phase, start_us, duration_us, GetCurrentThreadId() });
+		for (auto& event : events)
+		{
+			state.events.push_back(std::move(event));
+		}
+	}
+
+	void write_json_string(FILE* file, const std::string& value)
+	{
+		fputc('"', file);
+		for (const char ch : value)
+		{
+			if (ch == '"' || ch == '\\')
+			{
+				fputc('\\', file);
+			}
+
+			fputc(ch, file);
+		}
+		fputc('"', file);
+	}
+
+	const char* get_phase_name(const component_phase phase)
+	{
+		switch (phase)
+		{
+		case component_phase::post_start: return "post_start";
+		case component_phase::post_load: return "post_load";
+		case component_phase::post_unpack: return "post_unpack";
+		case component_phase::post_game_sp: return "post_game_sp";
+		case component_phase::post_cgame: return "post_cgame";
+		case component_phase::post_ui: return "post_ui";
+		case component_phase::on_ogl_load: return "on_ogl_load";
+		case component_phase::pre_destroy: return "pre_destroy";
+		}
+
+		return "unknown";
+	}
+
+	// rebuilt after a component is registered or removed, leaked for the same reason as the timing state
+	std::vector<component_interface*>* dispatch_order = nullptr;
+
+	// Registration order, except that a component comes after everything it lists in get_dependencies()
+	std::vector<component_interface*> build_dispatch_order(const std::vector<std::unique_ptr<component_interface>>& components)
+	{
+		const size_t count = components.size();
+
+		std::vector<std::string> names(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			names[i] = get_component_name(*components[i]);
+		}
+
+		std::vector<std::vector<size_t>> dependencies(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			for (const auto& dependency : components[i]->get_dependencies())
+			{
+				const auto found = std::find(names.begin(), names.end(), dependency);
+				if (found == names.end())
+				{
+					printf("component %s depends on %s, which is not registered\n", names[i].c_str(), dependency.c_str());
+					continue;
+				}
+
+				dependencies[i].push_back(size_t(found - names.begin()));
+			}
+		}
+
+		std::vector<component_interface*> order;
+		std::vector<bool> placed(count, false);
+		order.reserve(count);
+
+		while (order.size() < count)
+		{
+			size_t next = count;
+			for (size_t i = 0; i < count && next == count; i++)
+			{
+				if (placed[i])
+				{
+					continue;
+				}
+
+				if (std::all_of(dependencies[i].begin(), dependencies[i].end(), [&](size_t dependency) { return placed[dependency]; }))
+				{
+					next = i;
+				}
+			}
+
+			if (next == count)
+			{
+				// a cycle, the rest runs in registration order
+				for (size_t i = 0; i < count; i++)
+				{
+					if (!placed[i])
+					{
+						printf("component %s is part of a dependency cycle\n", names[i].c_str());
+						placed[i] = true;
+						order.push_back(components[i].get());
+					}
+				}
+
+				break;
+			}
+
+			placed[next] = true;
+			order.push_back(components[next].get());
+		}
+
+		return order;
+	}
+}
+
+namespace
+{
+	void prepare_scan_phase(const component_phase phase, const std::vector<component_interface*>& order, std::vector<timing_event>& events)
+	{
+		const char* phase_name = get_phase_name(phase);
+
+		// a component's prepare waits for the prepare of everything it depends on, each wave runs in parallel
+		std::vector<std::vector<component_interface*>> waves;
+		std::map<std::string, size_t> wave_of;
+
+		for (auto* component_ : order)
+		{
+			if (!component_->is_scan_phase(phase))
+			{
+				continue;
+			}
+
+			// still on the game thread, nothing runs on the workers yet
+			component_->gather(phase);
+
+			size_t wave = 0;
+			for (const auto& dependency : component_->get_dependencies())
+			{
+				const auto found = wave_of.find(dependency);
+				if (found != wave_of.end())
+				{
+					wave = std::max(wave, found->second + 1);
+				}
+			}
+
+			if (wave == waves.size())
+			{
+				waves.emplace_back();
+			}
+
+			waves[wave].push_back(component_);
+			wave_of[get_component_name(*component_)] = wave;
+		}
+
+		for (const auto& wave : waves)
+		{
+			std::vector<timing_event> wave_events(wave.size());
+			std::vector<std::exception_ptr> errors(wave.size());
+
+			hook::details::scan_parallel_for(wave.size(), [&](size_t index)
+			{
+				const double start = now_us();
+
+				try
+				{
+					wave[index]->prepare(phase);
+				}
+				catch (...)
+				{
+					errors[index] = std::current_exception();
+				}
+
+				wave_events[index] = { phase_name, get_component_name(*wave[index]) + " (prepare)", start, now_us() - start, GetCurrentThreadId() };
+			});
+
+			for (auto& event : wave_events)
+			{
+				events.push_back(std::move(event));
+			}
+
+			for (const auto& error : errors)
+			{
+				if (error)
+				{
+					std::rethrow_exception(error);
+				}
+			}
+		}
+	}
+}
+
+template <typename F>
+void component_loader::dispatch(const component_phase phase, F&& call)
+{
+	const char* phase_name = get_phase_name(phase);
+	if (!dispatch_order)
+	{
+		dispatch_order = new std::vector<component_interface*>(build_dispatch_order(get_components()));
+	}
+
+	const auto order = *dispatch_order;
+
+	std::vector<timing_event> events;
+	events.reserve(order.size());
+
+	const double phase_start = now_us();
+
+	prepare_scan_phase(phase, order, events);
+
+	for (auto* component_ : order)
+	{
+		const double start = now_us();
+		call(*component_);
+		events.push_back({ phase_name, get_component_name(*component_), start, now_us() - start, GetCurrentThreadId() });
+	}
+
+	record_dispatch(phase_name, std::move(events), phase_start, now_us() - phase_start);
+}
+
 void component_loader::register_component(std::unique_ptr<component_interface>&& component_)
 {
+	now_us();
 	get_components().push_back(std::move(component_));
+
+	delete dispatch_order;
+	dispatch_order = nullptr;
 }
 
 bool component_loader::post_start()
@@ -14,10 +321,7 @@ bool component_loader::post_start()
 
 	try
 	{
-		for (const auto& component_ : get_components())
-		{
-			component_->post_start();
-		}
+		dispatch(component_phase::post_start, [](component_interface& component_) { component_.post_start(); });
 	}
 	catch (premature_shutdown_trigger&)
 	{
@@ -37,10 +341,7 @@ bool component_loader::post_load()
 
 	try
 	{
-		for (const auto& component_ : get_components())
-		{
-			component_->post_load();
-		}
+		dispatch(component_phase::post_load, [](component_interface& component_) { component_.post_load(); });
 	}
 	catch (premature_shutdown_trigger&)
 	{
@@ -56,34 +357,27 @@ void component_loader::post_unpack()
 	if (handled) return;
 	handled = true;
 
-	for (const auto& component_ : get_components())
-	{
-		component_->post_unpack();
-	}
+	dispatch(component_phase::post_unpack, [](component_interface& component_) { component_.post_unpack(); });
 }
 
 void component_loader::post_cgame()
 {
-	for (const auto& component_ : get_components())
-		component_->post_cgame();
+	dispatch(component_phase::post_cgame, [](component_interface& component_) { component_.post_cgame(); });
 }
 
 void component_loader::on_ogl_load(HMODULE tOHGL)
 {
-	for (const auto& component_ : get_components())
-		component_->on_ogl_load(tOHGL);
+	dispatch(component_phase::on_ogl_load, [tOHGL](component_interface& component_) { component_.on_ogl_load(tOHGL); });
 }
 
 void component_loader::post_game_sp()
 {
-	for (const auto& component_ : get_components())
-		component_->post_game_sp();
+	dispatch(component_phase::post_game_sp, [](component_interface& component_) { component_.post_game_sp(); });
 }
 
 void component_loader::post_ui()
 {
-	for (const auto& component_ : get_components())
-		component_->post_ui();
+	dispatch(component_phase::post_ui, [](component_interface& component_) { component_.post_ui(); });
 }
 
 void component_loader::pre_destroy()
@@ -92,10 +386,7 @@ void component_loader::pre_destroy()
 	if (handled) return;
 	handled = true;
 
-	for (const auto& component_ : get_components())
-	{
-		component_->pre_destroy();
-	}
+	dispatch(component_phase::pre_destroy, [](component_interface& component_) { component_.pre_destroy(); });
 }
 
 void component_loader::clean()
@@ -113,6 +404,9 @@ void component_loader::clean()
 			++i;
 		}
 	}
+
+	delete dispatch_order;
+	dispatch_order = nullptr;
 }
 
 void* component_loader::load_import(const std::string& library, const std::string& function)
@@ -136,6 +430,51 @@ void component_loader::trigger_premature_shutdown()
 	throw premature_shutdown_trigger();
 }
 
+std::vector<component_loader::phase_timing> component_loader::get_phase_timings()
+{
+	auto& state = get_timing_state();
+	std::lock_guard lock(state.mutex);
+
+	std::vector<phase_timing> timings;
+	for (const char* phase : state.phase_order)
+	{
+		const auto& record = state.phases[phase];
+		timings.push_back({ phase, record.dispatches, record.total_ms, record.components });
+	}
+
+	return timings;
+}
+
+bool component_loader::write_trace(const std::wstring& path)
+{
+	auto& state = get_timing_state();
+	std::lock_guard lock(state.mutex);
+
+	FILE* file = _wfopen(path.c_str(), L"w");
+	if (!file)
+	{
+		return false;
+	}
+
+	fprintf(file, "{\"traceEvents\":[\n");
+
+	const DWORD process_id = GetCurrentProcessId();
+	for (size_t i = 0; i < state.events.size(); i++)
+	{
+		const auto& event = state.events[i];
+
+		fprintf(file, "{\"name\":");
+		write_json_string(file, event.name);
+		fprintf(file, ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%lu,\"tid\":%lu}%s\n",
+			event.phase, event.start_us, event.duration_us, process_id, event.thread_id, i + 1 < state.events.size() ? "," : "");
+	}
+
+	fprintf(file, "],\"displayTimeUnit\":\"ms\"}\n");
+	fclose(file);
+
+	return true;
+}
+
 std::vector<std::unique_ptr<component_interface>>& component_loader::get_components()
 {
 	using component_vector = std::vector<std::unique_ptr<component_interface>>;
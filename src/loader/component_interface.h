@@ -1,5 +1,18 @@
 #pragma once
 #include <string>
+#include <vector>
+
+enum class component_phase
+{
+	post_start,
+	post_load,
+	post_unpack,
+	post_game_sp,
+	post_cgame,
+	post_ui,
+	on_ogl_load,
+	pre_destroy,
+};
 
 class component_interface
 {
@@ -48,4 +61,29 @@ public:
 	{
 		return true;
 	}
+
+	// Components whose phases run before this one's, by the name yap_componenttimes prints ("game::component")
+	virtual std::vector<std::string> get_dependencies()
+	{
+		return {};
+	}
+
+	// Phases with a scan-only part. prepare() runs ahead of the phase on the scan workers, in parallel with the
+	// prepare() of other components, while the game thread waits. It may scan and read game memory and parse files,
+	// but must not patch, hook, register cvars or commands or print to the console: keep the results in the component
+	// and apply them in the phase itself. Symbolps of a module that is being loaded are not resolved yet.
+	virtual bool is_scan_phase([[maybe_unused]] component_phase phase)
+	{
+		return false;
+	}
+
+	virtual void prepare([[maybe_unused]] component_phase phase)
+	{
+	}
+
+	// Runs on the game thread before any prepare() of the phase. Reads what prepare() needs from engine state that
+	// isn't safe to touch off the game thread, such as cvars, into the component.
+	virtual void gather([[maybe_unused]] component_phase phase)
+	{
+	}
 };
\ No newline at end of file
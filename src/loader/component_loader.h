@@ -38,6 +38,15 @@ public:
 		return nullptr;
 	}
 
+	// wall time of the most recent dispatch of a phase, per component in dispatch order
+	struct phase_timing
+	{
+		const char* phase;
+		unsigned int dispatches;
+		double total_ms;
+		std::vector<std::pair<std::string, double>> components;
+	};
+
 	static void register_component(std::unique_ptr<component_interface>&& component);
 
 	static bool post_start();
@@ -54,8 +63,16 @@ public:
 
 	static void trigger_premature_shutdown();
 
+	static std::vector<phase_timing> get_phase_timings();
+
+	// every dispatch recorded so far as Chrome trace events, open in chrome://tracing or ui.perfetto.dev
+	static bool write_trace(const std::wstring& path);
+
 private:
 	static std::vector<std::unique_ptr<component_interface>>& get_components();
+
+	template <typename F>
+	static void dispatch(component_phase phase, F&& call);
 };
 
 #define REGISTER_COMPONENT(name) \
@@ -0,0 +1,458 @@
+#include "menuwide.h"
+#include "utils/configcache.h"
+
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <thread>
+#include "nlohmann/json.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// ============================================================================
+// JSON PARSING - SUPPORTS MULTIPLE MENUS PER FILE
+// ============================================================================
+
+Alignment ParseAlignment(const std::string& alignStr) {
+    Alignment align = { 0 };
+
+    if (alignStr == ALIGN_LEFT) {
+        align.h_left = 1;
+    }
+    else if (alignStr == ALIGN_RIGHT) {
+        align.h_right = 1;
+    }
+    else if (alignStr == ALIGN_CENTER) {
+        align.h_center = 1;
+        align.v_center = 1;
+    }
+    else if (alignStr == ALIGN_LEFT_BOTTOM) {
+        align.h_left = 1;
+        align.v_bottom = 1;
+    }
+    else if (alignStr == ALIGN_LEFT_TOP) {
+        align.h_left = 1;
+        align.v_top = 1;
+    }
+    else if (alignStr == ALIGN_RIGHT_BOTTOM) {
+        align.h_right = 1;
+        align.v_bottom = 1;
+    }
+    else if (alignStr == ALIGN_RIGHT_TOP) {
+        align.h_right = 1;
+        align.v_top = 1;
+    }
+    else if (alignStr == ALIGN_TOP) {
+        align.v_top = 1;
+    }
+    else if (alignStr == ALIGN_BOTTOM) {
+        align.v_bottom = 1;
+    }
+    else if (alignStr == ALIGN_STRETCH) {
+        align.stretch = 1;
+    }
+    else if (alignStr == ALIGN_BLACKSCREEN) {
+        align.black_screen = 1;
+    }
+
+    return align;
+}
+
+static std::string Menuwide_Lower(std::string name) {
+    for (char& c : name) {
+        c = std::tolower(static_cast<unsigned char>(c));
+    }
+    return name;
+}
+
+// false if a file failed to parse, such a result is not cached so the error shows up again next time
+static bool Menuwide_ParseMenus(const std::filesystem::path& dir, menuwide_tables& tables) {
+    bool complete = true;
+
+    for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+        if (entry.path().extension() != ".json") continue;
+
+        if (entry.path().filename() == "_hudelem_shaders.json") {
+            printf("Skipping _hudelem_shaders.json (handled separately)\n");
+            continue;
+        }
+
+        try {
+            std::ifstream file(entry.path());
+            nlohmann::json j = nlohmann::json::parse(file);
+
+            if (j.is_array()) {
+                for (const auto& menuJson : j) {
+                    MenuConfig config;
+                    config.menuName = menuJson["menuName"].get<std::string>();
+                    config.alignment = ParseAlignment(menuJson["alignment"].get<std::string>());
+
+                    tables.menus.push_back(config);
+                    printf("Loaded config for menu '%s'\n", config.menuName.c_str());
+                }
+            }
+            else {
+                MenuConfig config;
+                config.menuName = j["menuName"].get<std::string>();
+                config.alignment = ParseAlignment(j["alignment"].get<std::string>());
+
+                tables.menus.push_back(config);
+                printf("Loaded config for menu '%s'\n", config.menuName.c_str());
+            }
+        }
+        catch (const std::exception& e) {
+            printf("Failed to parse %s: %s\n",
+                entry.path().string().c_str(), e.what());
+            complete = false;
+        }
+    }
+
+    return complete;
+}
+
+static bool Menuwide_ParseHudShaders(const std::filesystem::path& dir, menuwide_tables& tables) {
+    std::filesystem::path configPath = dir / "_hudelem_shaders.json";
+
+    if (!std::filesystem::exists(configPath)) {
+        printf("_hudelem_shaders.json not found: %s\n", configPath.string().c_str());
+        return true;
+    }
+
+    printf("Loading HUD shader configs from: %s\n", configPath.string().c_str());
+
+    try {
+        std::ifstream file(configPath);
+        nlohmann::json j = nlohmann::json::parse(file);
+
+        if (j.is_array()) {
+            for (const auto& shaderJson : j) {
+                HudShaderConfig config;
+                config.shaderName = shaderJson["shaderName"].get<std::string>();
+                config.alignment = ParseAlignment(shaderJson["alignment"].get<std::string>());
+
+                tables.shaders.push_back(config);
+                printf("Loaded shader config for '%s' (stretch: %d)\n",
+                    config.shaderName.c_str(), config.alignment.stretch);
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        printf("Failed to parse _hudelem_shaders.json: %s\n", e.what());
+        return false;
+    }
+
+    return true;
+}
+
+static void Menuwide_BuildLookups(menuwide_tables& tables) {
+    tables.menuLookup.reserve(tables.menus.size());
+    for (const auto& config : tables.menus) {
+        tables.menuLookup[Menuwide_Lower(config.menuName)] = &config;
+    }
+
+    tables.shaderLookup.reserve(tables.shaders.size());
+    for (const auto& config : tables.shaders) {
+        tables.shaderLookup[Menuwide_Lower(config.shaderName)] = &config;
+    }
+}
+
+static bool Menuwide_ReadCache(const std::filesystem::path& cachePath, const std::vector<config_cache_source>& sources,
+    menuwide_tables& tables) {
+    config_cache_reader cache;
+    std::string error;
+    if (!cache.open(cachePath, config_cache_kind::menuwide, sizeof(menuwide_cache_record), sources, error)) {
+        printf("menuwide cache not used: %s\n", error.c_str());
+        return false;
+    }
+
+    for (size_t i = 0; i < cache.header().recordCount; i++) {
+        const auto& record = cache.record<menuwide_cache_record>(i);
+
+        Alignment alignment;
+        memcpy(&alignment, &record.alignment, sizeof(alignment));
+
+        if (record.isHudShader)
+            tables.shaders.push_back({ std::string(cache.string(record.name)), alignment });
+        else
+            tables.menus.push_back({ std::string(cache.string(record.name)), alignment });
+    }
+
+    return true;
+}
+
+static void Menuwide_WriteCache(const std::filesystem::path& cachePath, std::vector<config_cache_source>&& sources,
+    const menuwide_tables& tables) {
+    config_cache_writer cache(config_cache_kind::menuwide, sizeof(menuwide_cache_record));
+
+    auto add = [&](uint32_t isHudShader, const std::string& name, const Alignment& alignment) {
+        menuwide_cache_record record{};
+        record.isHudShader = isHudShader;
+        record.name = cache.add_string(name);
+        memcpy(&record.alignment, &alignment, sizeof(alignment));
+        cache.add_record(&record);
+    };
+
+    for (const auto& config : tables.menus)
+        add(0, config.menuName, config.alignment);
+    for (const auto& config : tables.shaders)
+        add(1, config.shaderName, config.alignment);
+
+    if (!cache.write(cachePath, std::move(sources)))
+        printf("Failed to write menuwide cache %s\n", cachePath.string().c_str());
+}
+
+menuwide_tables Menuwide_Parse(const std::filesystem::path& dir, const std::filesystem::path& cachePath) {
+    menuwide_tables tables;
+
+    if (!std::filesystem::exists(dir)) {
+        printf("menuwide directory not found: %s\n", dir.string().c_str());
+        return tables;
+    }
+
+    // stat-only snapshot taken before parsing, the writer refuses to cache files that change while we parse
+    std::vector<config_cache_source> sources;
+    if (!cachePath.empty()) {
+        sources = ConfigCache_Snapshot({ dir });
+
+        if (Menuwide_ReadCache(cachePath, sources, tables)) {
+            printf("Loaded %zu menu and %zu HUD shader configs from %s\n",
+                tables.menus.size(), tables.shaders.size(), cachePath.string().c_str());
+            Menuwide_BuildLookups(tables);
+            return tables;
+        }
+    }
+
+    printf("Loading menu configs from: %s\n", dir.string().c_str());
+
+    bool complete = Menuwide_ParseMenus(dir, tables);
+    complete &= Menuwide_ParseHudShaders(dir, tables);
+
+    if (!cachePath.empty() && complete)
+        Menuwide_WriteCache(cachePath, std::move(sources), tables);
+
+    Menuwide_BuildLookups(tables);
+    return tables;
+}
+
+// ============================================================================
+// ACTIVE TABLES
+// ============================================================================
+
+// written by Menuwide_Publish from any thread, taken by the main thread
+static std::atomic<menuwide_tables*> g_publishedTables{ nullptr };
+
+// main thread only, the retired tables stay alive for one more swap
+static std::unique_ptr<menuwide_tables> g_activeTables;
+static std::unique_ptr<menuwide_tables> g_retiredTables;
+static unsigned g_tablesGeneration = 0;
+
+void Menuwide_Publish(menuwide_tables&& tables) {
+    delete g_publishedTables.exchange(new menuwide_tables(std::move(tables)), std::memory_order_acq_rel);
+}
+
+const menuwide_tables& Menuwide_GetTables() {
+    if (g_publishedTables.load(std::memory_order_relaxed)) {
+        if (menuwide_tables* tables = g_publishedTables.exchange(nullptr, std::memory_order_acq_rel)) {
+            g_retiredTables = std::move(g_activeTables);
+            g_activeTables.reset(tables);
+            g_tablesGeneration++;
+        }
+    }
+
+    static const menuwide_tables empty;
+    return g_activeTables ? *g_activeTables : empty;
+}
+
+unsigned Menuwide_GetGeneration() {
+    Menuwide_GetTables();
+    return g_tablesGeneration;
+}
+
+void Menuwide_Load(const std::filesystem::path& dir, const std::filesystem::path& cachePath) {
+    Menuwide_Publish(Menuwide_Parse(dir, cachePath));
+    Menuwide_GetTables();
+}
+
+// ============================================================================
+// LOOKUP FUNCTIONS
+// ============================================================================
+
+template <typename T>
+static const T* Menuwide_Find(const menuwide_lookup<T>& lookup, const char* name) {
+    if (!name) return nullptr;
+
+    char lowerName[260];
+    size_t length = 0;
+    for (; name[length]; length++) {
+        // no config name is this long
+        if (length == sizeof(lowerName))
+            return nullptr;
+        lowerName[length] = (char)std::tolower(static_cast<unsigned char>(name[length]));
+    }
+
+    auto it = lookup.find(std::string_view(lowerName, length));
+    return (it != lookup.end()) ? it->second : nullptr;
+}
+
+const MenuConfig* FindMenuConfig(const char* menuName) {
+    return Menuwide_Find(Menuwide_GetTables().menuLookup, menuName);
+}
+
+const HudShaderConfig* FindHudShaderConfig(const char* shaderName) {
+    return Menuwide_Find(Menuwide_GetTables().shaderLookup, shaderName);
+}
+
+// ============================================================================
+// WATCHER
+// ============================================================================
+
+namespace {
+    // change notifications for one directory, wait() returns true once something in it changed
+    class directory_watch {
+    public:
+        explicit directory_watch(const std::filesystem::path& dir) {
+#ifdef _WIN32
+            m_directory = CreateFileW(dir.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+            m_overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+#else
+            m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            if (m_fd >= 0 && inotify_add_watch(m_fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE) < 0) {
+                close(m_fd);
+                m_fd = -1;
+            }
+#endif
+        }
+
+        ~directory_watch() {
+#ifdef _WIN32
+            if (m_reading) {
+                DWORD bytes;
+                CancelIoEx(m_directory, &m_overlapped);
+                GetOverlappedResult(m_directory, &m_overlapped, &bytes, TRUE);
+            }
+            if (m_overlapped.hEvent)
+                CloseHandle(m_overlapped.hEvent);
+            if (m_directory != INVALID_HANDLE_VALUE)
+                CloseHandle(m_directory);
+#else
+            if (m_fd >= 0)
+                close(m_fd);
+#endif
+        }
+
+        directory_watch(const directory_watch&) = delete;
+        directory_watch& operator=(const directory_watch&) = delete;
+
+        bool is_open() const {
+#ifdef _WIN32
+            return m_directory != INVALID_HANDLE_VALUE && m_overlapped.hEvent;
+#else
+            return m_fd >= 0;
+#endif
+        }
+
+        bool wait(int timeoutMs) {
+#ifdef _WIN32
+            if (!m_reading) {
+                ResetEvent(m_overlapped.hEvent);
+                if (!ReadDirectoryChangesW(m_directory, m_buffer, sizeof(m_buffer), FALSE,
+                    FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE, nullptr, &m_overlapped, nullptr)) {
+                    Sleep(timeoutMs);
+                    return false;
+                }
+                m_reading = true;
+            }
+
+            if (WaitForSingleObject(m_overlapped.hEvent, timeoutMs) != WAIT_OBJECT_0)
+                return false;
+
+            // the notifications themselves don't matter, any change re-parses the whole directory
+            DWORD bytes;
+            GetOverlappedResult(m_directory, &m_overlapped, &bytes, FALSE);
+            m_reading = false;
+            return true;
+#else
+            pollfd fd{ m_fd, POLLIN, 0 };
+            if (poll(&fd, 1, timeoutMs) <= 0)
+                return false;
+
+            alignas(inotify_event) char buffer[4096];
+            while (read(m_fd, buffer, sizeof(buffer)) > 0) {}
+            return true;
+#endif
+        }
+
+    private:
+#ifdef _WIN32
+        HANDLE m_directory = INVALID_HANDLE_VALUE;
+        OVERLAPPED m_overlapped{};
+        alignas(DWORD) uint8_t m_buffer[4096];
+        bool m_reading = false;
+#else
+        int m_fd = -1;
+#endif
+    };
+
+    // leaked, a joinable std::thread destroyed at exit would terminate the process
+    std::thread* g_watcherThread = nullptr;
+    std::atomic<bool> g_watcherStop{ false };
+
+    void WatcherMain(std::filesystem::path dir, std::filesystem::path cachePath) {
+        directory_watch watch(dir);
+        if (!watch.is_open()) {
+            printf("menuwide: can't watch %s\n", dir.string().c_str());
+            return;
+        }
+
+        printf("menuwide: watching %s\n", dir.string().c_str());
+
+        while (!g_watcherStop.load(std::memory_order_relaxed)) {
+            if (!watch.wait(250))
+                continue;
+
+            // editors save in several steps, wait for the directory to settle
+            while (!g_watcherStop.load(std::memory_order_relaxed) && watch.wait(200)) {}
+
+            if (g_watcherStop.load(std::memory_order_relaxed))
+                break;
+
+            printf("menuwide: change detected, reloading\n");
+
+            try {
+                Menuwide_Publish(Menuwide_Parse(dir, cachePath));
+            }
+            catch (const std::exception& e) {
+                printf("menuwide: reload failed: %s\n", e.what());
+            }
+        }
+    }
+}
+
+void Menuwide_StartWatcher(const std::filesystem::path& dir, const std::filesystem::path& cachePath) {
+    if (g_watcherThread)
+        return;
+
+    g_watcherStop = false;
+    g_watcherThread = new std::thread(WatcherMain, dir, cachePath);
+}
+
+void Menuwide_StopWatcher() {
+    if (!g_watcherThread)
+        return;
+
+    g_watcherStop = true;
+    g_watcherThread->join();
+
+    delete g_watcherThread;
+    g_watcherThread = nullptr;
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// ============================================================================
+// MENUWIDE - Per-menu and per-HUD-shader alignment from gameroot/menuwide/*.json
+// ============================================================================
+// The configs are parsed into one menuwide_tables object. A reload (yap_menuwide_watch) parses a new one on the
+// watcher thread and hands it over, the main thread swaps it in on its next lookup. The table it replaces is kept
+// alive until the swap after that, so a config pointer looked up during the current frame stays valid.
+
+#define ALIGN_LEFT_BOTTOM   "[LB]"
+#define ALIGN_LEFT_TOP      "[LT]"
+#define ALIGN_RIGHT_BOTTOM  "[RB]"
+#define ALIGN_RIGHT_TOP     "[RT]"
+#define ALIGN_CENTER        "[CENTER]"
+#define ALIGN_LEFT          "[LEFT]"
+#define ALIGN_RIGHT         "[RIGHT]"
+#define ALIGN_TOP           "[TOP]"
+#define ALIGN_BOTTOM        "[BOTTOM]"
+#define ALIGN_STRETCH       "[STRETCH]"
+#define ALIGN_BLACKSCREEN   "[BLACKSCREEN]"
+
+struct Alignment {
+    uint32_t h_left : 1;
+    uint32_t h_right : 1;
+    uint32_t h_center : 1;
+    uint32_t v_top : 1;
+    uint32_t v_bottom : 1;
+    uint32_t v_center : 1;
+    uint32_t stretch : 1;   // For stretch behavior
+    uint32_t black_screen : 1;
+    uint32_t _unused : 24;  // Padding to 32 bits
+};
+
+struct MenuConfig {
+    std::string menuName;
+    Alignment alignment;
+};
+
+struct HudShaderConfig {
+    std::string shaderName;
+    Alignment alignment;
+};
+
+// keyed by lowercase name, looked up with a string_view so the Find functions don't allocate
+struct MenuwideNameHash {
+    using is_transparent = void;
+
+    size_t operator()(std::string_view name) const {
+        return std::hash<std::string_view>{}(name);
+    }
+};
+
+template <typename T>
+using menuwide_lookup = std::unordered_map<std::string, const T*, MenuwideNameHash, std::equal_to<>>;
+
+struct menuwide_tables {
+    std::vector<MenuConfig> menus;
+    std::vector<HudShaderConfig> shaders;
+
+    // point into the vectors above, which are not touched after parsing
+    menuwide_lookup<MenuConfig> menuLookup;
+    menuwide_lookup<HudShaderConfig> shaderLookup;
+};
+
+Alignment ParseAlignment(const std::string& alignStr);
+
+// Parses every *.json in 'dir' as menu configs, _hudelem_shaders.json as HUD shader configs. Doesn't touch the
+// active tables, can run on any thread. With a 'cachePath' the binary cache there is used while it matches the
+// files (see utils/configcache.h) and rewritten after a full parse.
+menuwide_tables Menuwide_Parse(const std::filesystem::path& dir, const std::filesystem::path& cachePath = {});
+
+// Parses 'dir' and makes it the active tables right away, main thread only
+void Menuwide_Load(const std::filesystem::path& dir, const std::filesystem::path& cachePath = {});
+
+// Hands tables over to the main thread, which swaps them in on its next lookup. Any thread.
+void Menuwide_Publish(menuwide_tables&& tables);
+
+// Active tables, swaps in published ones first. Main thread only.
+const menuwide_tables& Menuwide_GetTables();
+
+// Bumped on every swap, caches of config pointers compare it to know when to drop them
+unsigned Menuwide_GetGeneration();
+
+const MenuConfig* FindMenuConfig(const char* menuName);
+const HudShaderConfig* FindHudShaderConfig(const char* shaderName);
+
+// Watches 'dir' on a background thread (ReadDirectoryChangesW, inotify elsewhere) and publishes re-parsed tables
+// after changes. Stopping joins the thread.
+void Menuwide_StartWatcher(const std::filesystem::path& dir, const std::filesystem::path& cachePath = {});
+void Menuwide_StopWatcher();
@@ -7,12 +7,18 @@
 #include <fstream>
 #include "nlohmann/json.hpp"
 #include <optional>
+#include <unordered_map>
+#include <array>
 #include "GMath.h"
 #include <buildnumber.h>
 #include "framework.h"
 #include "utils/common.h"
 #include "GL\glew.h"
 #include "utils/hooking.h"
+#include "utils/programcache.h"
+#include "utils/hash.h"
+#include "ati_ir.h"
+#include <chrono>
 
 SafetyHookInline* wglGetProcAddressD;
 
@@ -23,6 +29,15 @@ cevar_s* r_arb_fragment_fresnel_bias;
 cevar_s* r_arb_fragment_disable_fog;
 cevar_s* r_arb_fragment_shader_debug_print;
 cevar_s* r_fog_drawsun_workaround;
+cevar_s* r_arb_fragment_program_cache;
+
+// read on every program bind, picks the variant and the uniform values
+struct alignas(64) ati_uniform_views {
+    cevar_view<int> debugMode;
+    cevar_view<float> fresnelPower;
+    cevar_view<float> fresnelBias;
+    cevar_view<int> disableFog;
+} g_atiUniformViews;
 
 
 // Debug print macro for non-looping code (channel 0)
@@ -48,46 +63,57 @@ cevar_s* r_fog_drawsun_workaround;
         } \
     } while(0)
 
-enum ATIOpType { COLOR_OP, ALPHA_OP };
+// Locations of the uniforms glBindFragmentShaderATI_hook updates, -1 when the variant doesn't use one.
+// Resolved once after linking.
+struct ATIUniformLocations {
+    GLint fogDensity = -1;
+    GLint fogStart = -1;
+    GLint fogEnd = -1;
+    GLint fogColor = -1;
+    GLint fresnelPower = -1;
+    GLint fresnelBias = -1;
+};
 
-struct ATISource {
-    GLuint index;
-    GLuint rep;
-    GLuint mod;
+// What was last uploaded to the program, uniforms keep their value while the program isn't bound
+struct ATIUniformValues {
+    GLfloat fogDensity;
+    GLfloat fogStart;
+    GLfloat fogEnd;
+    GLfloat fogColor[4];
+    GLfloat fresnelPower;
+    GLfloat fresnelBias;
 };
 
-struct ATIInstruction {
-    ATIOpType type;
-    GLenum op;
-    GLuint dst;
-    GLuint dstMask;
-    GLuint dstMod;
-    int argCount;
-    ATISource args[3];
+// One debug view/fog mode combination of an ATIProgram, linked the first time a bind needs it
+struct ATIProgramVariant {
+    GLuint glsl_program = 0;
+    bool built = false;             // also set when compiling failed, so it isn't retried on every bind
+
+    ATIUniformLocations uniforms;
+    ATIUniformValues uploaded;
+    bool uploadedValid = false;     // 'uploaded' is meaningless until the first bind after linking
 };
 
-struct ATISetupInst {
-    bool isPassTexCoord;
-    GLuint dst;
-    GLuint src;
-    GLenum swizzle;
+// The translated form of one ATI instruction stream, shared by every ATI shader that records the same stream
+struct ATIProgram {
+    std::vector<GLuint> key;        // SerializeATIInstructions, compared on hash hits
+    uint32_t refs = 0;
+
+    ATIIRProgram ir;                // built and constant folded once, each variant runs the remaining passes
+    std::array<ATIProgramVariant, ATI_VARIANT_COUNT> variants;
+    bool prewarmPending = false;    // bound under a debug view it has no variants for, see OpenGL_OnEndFrame
 };
 
 struct ATIShader {
     std::vector<ATISetupInst> setup;
     std::vector<ATIInstruction> instructions;
 
-    struct AnyInstruction {
-        bool isSetup;
-        union {
-            ATISetupInst setup;
-            ATIInstruction arith;
-        };
-    };
+    using AnyInstruction = ATIAnyInstruction;
     std::vector<AnyInstruction> orderedInstructions;
 
     float constants[8][4];
-    GLuint glsl_program;
+    uint8_t constantsSet = 0;       // bits of the constants set while recording, folded into the program
+    ATIProgram* program = nullptr;  // holds a reference while set
     bool compiled;
 
     //struct FogState {
@@ -100,13 +126,17 @@ struct ATIShader {
     //} fogState;
 };
 
+// CPU side copy of the context's fog state, kept up to date by the opengl32 glFog*/glEnable/glDisable hooks so
+// program binds don't have to query the driver. Only authoritative while 'tracking' is set, that is while the hooks
+// are installed and the copy was seeded from the current context. The color isn't part of it, binds read it from the
+// game's own fog color like they always did.
 struct CachedFogState {
+    bool tracking = false;
     GLboolean enabled = GL_FALSE;
-    GLint mode = GL_LINEAR;
-    GLfloat density = 0.0f;
+    GLint mode = GL_EXP;
+    GLfloat density = 1.0f;
     GLfloat start = 0.0f;
-    GLfloat end = 1000.0f;
-    GLfloat color[4] = { 0, 0, 0, 0 };
+    GLfloat end = 1.0f;
 } g_cached_fog;
 
 PFNGLGETUNIFORMLOCATIONPROC fglGetUniformLocation = nullptr;
@@ -120,6 +150,12 @@ GLuint g_current_shader = 0;
 bool g_building = false;
 GLuint g_next_shader_id = 1;
 
+// Programs by hash of their instruction stream. Unreferenced ones are kept, so a renderer restart that records the
+// same shaders again doesn't compile and link them again. The whole cache goes with the GL context.
+std::unordered_multimap<uint64_t, ATIProgram> g_ati_programs;
+HGLRC g_ati_programs_context = nullptr;
+std::vector<ATIProgram*> g_ati_prewarm_pending;
+
 
 
 PFNGLCREATESHADERPROC fglCreateShader = nullptr;
@@ -136,298 +172,13 @@ PFNGLGETSHADERINFOLOGPROC fglGetShaderInfoLog = nullptr;
 PFNGLGETPROGRAMIVPROC fglGetProgramiv = nullptr;
 PFNGLGETPROGRAMINFOLOGPROC fglGetProgramInfoLog = nullptr;
 
+// GL_ARB_get_program_binary, null without it
+PFNGLPROGRAMPARAMETERIPROC fglProgramParameteri = nullptr;
+PFNGLGETPROGRAMBINARYPROC fglGetProgramBinary = nullptr;
+PFNGLPROGRAMBINARYPROC fglProgramBinary = nullptr;
 
-HMODULE opengl_addr;
-
-// Helper: Convert GL enum to register string
-std::string RegToString(GLuint reg) {
-    if (reg >= GL_REG_0_ATI && reg <= GL_REG_5_ATI) {
-        return "r" + std::to_string(reg - GL_REG_0_ATI);
-    }
-    if (reg >= GL_CON_0_ATI && reg <= GL_CON_7_ATI) {
-        return "atiConst[" + std::to_string(reg - GL_CON_0_ATI) + "]";
-    }
-    if (reg == GL_PRIMARY_COLOR_ARB) {
-        return "gl_Color";
-    }
-    if (reg == GL_SECONDARY_INTERPOLATOR_ATI) {
-        return "gl_SecondaryColor";
-    }
-    if (reg == GL_ZERO) return "vec4(0.0)";
-    if (reg == GL_ONE) return "vec4(1.0)";
-
-    return "r0"; // fallback
-}
-
-// Helper: Translate source argument with modifiers
-std::string TranslateArg(const ATISource& arg) {
-    std::string base = RegToString(arg.index);
-
-    // Apply swizzle/rep
-    switch (arg.rep) {
-    case GL_RED:   base += ".r"; break;
-    case GL_GREEN: base += ".g"; break;
-    case GL_BLUE:  base += ".b"; break;
-    case GL_ALPHA: base += ".a"; break;
-    case GL_NONE:  break; // use all components
-    default: break;
-    }
-
-    // Apply modifiers
-    std::string result = base;
-
-    if (arg.mod & GL_COMP_BIT_ATI) {
-        result = "(1.0 - " + result + ")";
-    }
-    if (arg.mod & GL_NEGATE_BIT_ATI) {
-        result = "-(" + result + ")";
-    }
-    if (arg.mod & GL_BIAS_BIT_ATI) {
-        result = "(" + result + " - 0.5)";
-    }
-    if (arg.mod & GL_2X_BIT_ATI) {
-        result = "(" + result + " * 2.0)";
-    }
-
-    return result;
-}
-
-// Helper: Translate a single instruction
-std::string TranslateInstruction(const ATIInstruction& inst) {
-    std::stringstream ss;
-    std::string dst = RegToString(inst.dst);
-
-    // Get source operands
-    std::string arg1 = TranslateArg(inst.args[0]);
-    std::string arg2 = inst.argCount > 1 ? TranslateArg(inst.args[1]) : "";
-    std::string arg3 = inst.argCount > 2 ? TranslateArg(inst.args[2]) : "";
-
-    // Write mask for color ops
-    std::string mask = "";
-    if (inst.type == COLOR_OP && inst.dstMask != GL_NONE && inst.dstMask != 0) {
-        mask = ".";
-        if (inst.dstMask & GL_RED_BIT_ATI) mask += "r";
-        if (inst.dstMask & GL_GREEN_BIT_ATI) mask += "g";
-        if (inst.dstMask & GL_BLUE_BIT_ATI) mask += "b";
-    }
-    else if (inst.type == ALPHA_OP) {
-        mask = ".a";
-    }
-
-    ss << "    " << dst << mask << " = ";
-
-    // Translate operation
-    std::string expr;
-    switch (inst.op) {
-    case GL_MOV_ATI:
-        expr = arg1;
-        break;
-    case GL_ADD_ATI:
-        expr = arg1 + " + " + arg2;
-        break;
-    case GL_MUL_ATI:
-        expr = arg1 + " * " + arg2;
-        break;
-    case GL_SUB_ATI:
-        expr = arg1 + " - " + arg2;
-        break;
-    case GL_DOT3_ATI:
-        expr = "vec4(dot(" + arg1 + ".xyz, " + arg2 + ".xyz))";
-        break;
-    case GL_DOT4_ATI:
-        expr = "vec4(dot(" + arg1 + ", " + arg2 + "))";
-        break;
-    case GL_MAD_ATI:
-        expr = arg1 + " * " + arg2 + " + " + arg3;
-        break;
-    case GL_LERP_ATI:
-        expr = "mix(" + arg2 + ", " + arg3 + ", " + arg1 + ")";
-        break;
-    case GL_CND_ATI:
-        expr = "((" + arg1 + " > 0.5) ? " + arg2 + " : " + arg3 + ")";
-        break;
-    case GL_CND0_ATI:
-        expr = "((" + arg1 + " >= 0.0) ? " + arg2 + " : " + arg3 + ")";
-        break;
-    case GL_DOT2_ADD_ATI:
-        expr = "vec4(dot(" + arg1 + ".xy, " + arg2 + ".xy) + " + arg3 + ".z)";
-        break;
-    default:
-        expr = "vec4(1.0, 0.0, 1.0, 1.0)"; // magenta = error
-        ATI_DEBUG_PRINT_CHANNEL(0,"WARNING: Unknown opcode 0x%X\n", inst.op);
-        break;
-    }
-
-    // Apply destination modifiers
-    if (inst.dstMod & GL_2X_BIT_ATI) expr = "(" + expr + " * 2.0)";
-    if (inst.dstMod & GL_4X_BIT_ATI) expr = "(" + expr + " * 4.0)";
-    if (inst.dstMod & GL_8X_BIT_ATI) expr = "(" + expr + " * 8.0)";
-    if (inst.dstMod & GL_HALF_BIT_ATI) expr = "(" + expr + " * 0.5)";
-    if (inst.dstMod & GL_QUARTER_BIT_ATI) expr = "(" + expr + " * 0.25)";
-    if (inst.dstMod & GL_EIGHTH_BIT_ATI) expr = "(" + expr + " * 0.125)";
-
-    if (inst.dstMod & GL_SATURATE_BIT_ATI) {
-        expr = "clamp(" + expr + ", 0.0, 1.0)";
-    }
-
-    ss << expr << ";\n";
-    return ss.str();
-}
-
-// Helper: Translate setup instructions (PassTexCoord/SampleMap)
-std::string TranslateSetup(const ATISetupInst& setup) {
-    std::stringstream ss;
-    std::string dst = RegToString(setup.dst);
-
-    if (setup.isPassTexCoord) {
-        // PassTexCoord - just pass texture coordinates
-        if (setup.src >= GL_TEXTURE0_ARB && setup.src <= GL_TEXTURE7_ARB) {
-            int unit = setup.src - GL_TEXTURE0_ARB;
-            ss << "    " << dst << " = gl_TexCoord[" << unit << "];\n";
-        }
-        else if (setup.src >= GL_REG_0_ATI && setup.src <= GL_REG_5_ATI) {
-            ss << "    " << dst << " = " << RegToString(setup.src) << ";\n";
-        }
-    }
-    else {
-        // SampleMap - sample a texture
-        int texUnit = setup.dst - GL_REG_0_ATI;
-        ss << "    " << dst << " = ";
-
-        // Get coordinate source
-        std::string coord;
-        if (setup.src >= GL_TEXTURE0_ARB && setup.src <= GL_TEXTURE7_ARB) {
-            int unit = setup.src - GL_TEXTURE0_ARB;
-            coord = "gl_TexCoord[" + std::to_string(unit) + "]";
-        }
-        else if (setup.src >= GL_REG_0_ATI && setup.src <= GL_REG_5_ATI) {
-            // Just use the register as-is - it's already been set
-            coord = RegToString(setup.src);
-        }
-        else {
-            coord = RegToString(setup.src);
-        }
-
-        // Apply swizzle and choose texture function
-        if (texUnit == 0) {
-            // tex0 is 2D texture - needs .xy coordinates
-            ss << "texture2D(tex0, " << coord << ".xy);\n";
-        }
-        else {
-            // Other textures are cube maps - need .xyz
-            if (setup.swizzle == GL_SWIZZLE_STR_ATI) {
-                ss << "textureCube(tex" << texUnit << ", " << coord << ".xyz);\n";
-            }
-            else if (setup.swizzle == GL_SWIZZLE_STQ_ATI) {
-                ss << "textureCube(tex" << texUnit << ", " << coord << ".xyw);\n";
-            }
-            else {
-                ss << "textureCube(tex" << texUnit << ", " << coord << ".xyz);\n";
-            }
-        }
-    }
-
-    return ss.str();
-}
 
-// Main translator
-std::string TranslateToGLSL(const ATIShader& shader) {
-    std::stringstream ss;
-
-    ss << "uniform sampler2D tex0;\n";
-    ss << "uniform samplerCube tex1, tex2, tex3, tex4, tex5;\n";
-    ss << "uniform vec4 atiConst[8];\n";
-    ss << "\n";
-    ss << "// Custom fog uniforms\n";
-    ss << "uniform int fogEnabled;\n";
-    ss << "uniform int fogMode;\n";
-    ss << "uniform float fogDensity;\n";
-    ss << "uniform float fogStart;\n";
-    ss << "uniform float fogEnd;\n";
-    ss << "uniform vec4 fogColor;\n";
-    ss << "uniform int debugMode;\n";
-    ss << "uniform float fresnelPower;\n";
-    ss << "uniform float fresnelBias;\n";
-    ss << "uniform int disableFog;\n";
-
-    ss << "\n";
-
-    ss << "void main() {\n";
-
-    ss << "    vec4 r0 = vec4(0.0);\n";
-    ss << "    vec4 r1 = vec4(0.0);\n";
-    ss << "    vec4 r2 = vec4(0.0);\n";
-    ss << "    vec4 r3 = vec4(0.0);\n";
-    ss << "    vec4 r4 = vec4(0.0);\n";
-    ss << "    vec4 r5 = vec4(0.0);\n\n";
-
-    // Process in recorded order
-    for (const auto& any : shader.orderedInstructions) {
-        if (any.isSetup) {
-            ss << TranslateSetup(any.setup);
-        }
-        else {
-            ss << TranslateInstruction(any.arith);
-        }
-    }
-
-    ss << "\n    // Use simplified Fresnel (avoid discontinuities)\n";
-    ss << "    vec3 normalVec = normalize((r0 * 2.0 - 1.0).xyz);\n";
-    ss << "    \n";
-    ss << "    // Use Z component of normal as approximation for view angle\n";
-    ss << "    float fresnel = fresnelBias + (1.0 - fresnelBias) * pow(clamp(1.0 - abs(normalVec.z), 0.0, 1.0), fresnelPower);\n";
-    ss << "    fresnel = clamp(fresnel, 0.0, 1.0);\n";
-    ss << "    \n";
-    ss << "\n    // Debug visualization and Fresnel blending\n";
-    ss << "    if (debugMode == 0) {\n";
-    ss << "        // Correct blend method\n";
-    ss << "        r0 = mix(r3, r2, fresnel);\n";
-    ss << "        r0 = r0 * gl_Color;\n";
-    ss << "        r0.a = gl_Color.a;\n";
-    ss << "    } else if (debugMode == -1) {\n";
-    ss << "        // (incorrect) blend method\n";
-    ss << "        r0 = mix(r2, r3, fresnel);\n";
-    ss << "        r0 = r0 * gl_Color;\n";
-    ss << "        r0.a = gl_Color.a;\n";
-    ss << "    } else if (debugMode == 1) {\n";
-    ss << "        gl_FragColor = vec4(r3.a, r3.a, r3.a, 1.0);  // Fresnel alpha\n";
-    ss << "        return;\n";
-    ss << "    } else if (debugMode == 2) {\n";
-    ss << "        gl_FragColor = vec4(r3.rgb, 1.0);  // Specular RGB\n";
-    ss << "        return;\n";
-    ss << "    } else if (debugMode == 3) {\n";
-    ss << "        gl_FragColor = vec4(r2.rgb, 1.0);  // Diffuse RGB\n";
-    ss << "        return;\n";
-    ss << "    } else if (debugMode == 4) {\n";
-    ss << "        gl_FragColor = vec4(r3.xyz * 0.5 + 0.5, 1.0);  // Reflection vector\n";
-    ss << "        return;\n";
-    ss << "    } else if (debugMode == 5) {\n";
-    ss << "        gl_FragColor = vec4(r2.xyz * 0.5 + 0.5, 1.0);  // Normal vector\n";
-    ss << "        return;\n";
-    ss << "    }\n";
-
-    // Apply fog
-    ss << "\n    // Apply fog\n";
-    ss << "    if (fogEnabled != 0 && disableFog != 1) {\n";
-    ss << "        float fogFactor = 1.0;\n";
-    ss << "        const float LOG2 = 1.442695;\n";
-    ss << "        \n";
-    ss << "        if (fogMode == 0x0800) {\n";
-    ss << "            fogFactor = exp2(-fogDensity * gl_FogFragCoord * LOG2);\n";
-    ss << "        } else if (fogMode == 0x0801) {\n";
-    ss << "            fogFactor = exp2(-fogDensity * fogDensity * gl_FogFragCoord * gl_FogFragCoord * LOG2);\n";
-    ss << "        } else {\n";
-    ss << "            fogFactor = (fogEnd - gl_FogFragCoord) / (fogEnd - fogStart);\n";
-    ss << "        }\n";
-    ss << "        \n";
-    ss << "        fogFactor = clamp(fogFactor, 0.0, 1.0);\n";
-    ss << "        r0.rgb = mix(fogColor.rgb, r0.rgb, fogFactor);\n";
-    ss << "    }\n";
-    ss << "\n    gl_FragColor = r0;\n";
-    ss << "}\n";
-
-    return ss.str();
-}
+HMODULE opengl_addr;
 
 // Compile GLSL shader
 GLuint CompileGLSL(const std::string& fragSrc) {
@@ -471,6 +222,8 @@ GLuint CompileGLSL(const std::string& fragSrc) {
     GLuint program = fglCreateProgram();
     fglAttachShader(program, vs);
     fglAttachShader(program, fs);
+    if (fglProgramParameteri)
+        fglProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     fglLinkProgram(program);
 
     // Check link status
@@ -517,77 +270,549 @@ PFNGLISENABLEDPROC fglIsEnabled = nullptr;
 PFNGLENABLEPROC fglEnable;
 PFNGLENABLEPROC fglDisable;
 
+typedef HGLRC(WINAPI* PFNWGLGETCURRENTCONTEXTPROC)();
+PFNWGLGETCURRENTCONTEXTPROC fwglGetCurrentContext = nullptr;
+
+SafetyHookInline* glEnableD;
+SafetyHookInline* glDisableD;
+SafetyHookInline* glFogfD;
+SafetyHookInline* glFogfvD;
+SafetyHookInline* glFogiD;
+SafetyHookInline* glFogivD;
+bool g_fogHooksInstalled = false;
+
+static void FogShadow_SetParam(GLenum pname, GLfloat value) {
+    switch (pname) {
+    case GL_FOG_MODE:
+        g_cached_fog.mode = (GLint)value;
+        break;
+    case GL_FOG_DENSITY:
+        g_cached_fog.density = value;
+        break;
+    case GL_FOG_START:
+        g_cached_fog.start = value;
+        break;
+    case GL_FOG_END:
+        g_cached_fog.end = value;
+        break;
+    }
+}
 
-void WINAPI glBindFragmentShaderATI_hook(GLuint id) {
-    ATI_DEBUG_PRINT_CHANNEL(1,"glBindFragmentShaderATI(% d)\n", id);
-    g_current_shader = id;
+void WINAPI glEnable_hook(GLenum cap) {
+    if (cap == GL_FOG)
+        g_cached_fog.enabled = GL_TRUE;
+    glEnableD->unsafe_stdcall<void>(cap);
+}
 
-    if (id == 0) {
-        if (fglUseProgram) {
-            fglUseProgram(0);
+void WINAPI glDisable_hook(GLenum cap) {
+    if (cap == GL_FOG)
+        g_cached_fog.enabled = GL_FALSE;
+    glDisableD->unsafe_stdcall<void>(cap);
+}
+
+void WINAPI glFogf_hook(GLenum pname, GLfloat param) {
+    FogShadow_SetParam(pname, param);
+    glFogfD->unsafe_stdcall<void>(pname, param);
+}
+
+void WINAPI glFogi_hook(GLenum pname, GLint param) {
+    FogShadow_SetParam(pname, (GLfloat)param);
+    glFogiD->unsafe_stdcall<void>(pname, param);
+}
+
+void WINAPI glFogfv_hook(GLenum pname, const GLfloat* params) {
+    if (params && pname != GL_FOG_COLOR)
+        FogShadow_SetParam(pname, params[0]);
+    glFogfvD->unsafe_stdcall<void>(pname, params);
+}
+
+void WINAPI glFogiv_hook(GLenum pname, const GLint* params) {
+    if (params && pname != GL_FOG_COLOR)
+        FogShadow_SetParam(pname, (GLfloat)params[0]);
+    glFogivD->unsafe_stdcall<void>(pname, params);
+}
+
+// Hooks go into opengl32's bucket, so they are dropped whenever the game frees it and installed again on the next load
+static void FogShadow_InstallHooks(HMODULE tOHGL) {
+    if (g_fogHooksInstalled)
+        return;
+
+    glEnableD = CreateInlineHook((void*)GetProcAddress(tOHGL, "glEnable"), glEnable_hook);
+    glDisableD = CreateInlineHook((void*)GetProcAddress(tOHGL, "glDisable"), glDisable_hook);
+    glFogfD = CreateInlineHook((void*)GetProcAddress(tOHGL, "glFogf"), glFogf_hook);
+    glFogfvD = CreateInlineHook((void*)GetProcAddress(tOHGL, "glFogfv"), glFogfv_hook);
+    glFogiD = CreateInlineHook((void*)GetProcAddress(tOHGL, "glFogi"), glFogi_hook);
+    glFogivD = CreateInlineHook((void*)GetProcAddress(tOHGL, "glFogiv"), glFogiv_hook);
+
+    g_fogHooksInstalled = glEnableD && glDisableD && glFogfD && glFogfvD && glFogiD && glFogivD;
+    g_cached_fog.tracking = false;
+}
+
+// Reads the fog state of the current context once, needs a current context. Every change after that goes through the hooks.
+static void FogShadow_Seed() {
+    g_cached_fog.tracking = false;
+    if (!g_fogHooksInstalled || !fglIsEnabled || !fglGetIntegerv || !fglGetFloatv)
+        return;
+
+    g_cached_fog.enabled = fglIsEnabled(GL_FOG);
+    fglGetIntegerv(GL_FOG_MODE, &g_cached_fog.mode);
+    fglGetFloatv(GL_FOG_DENSITY, &g_cached_fog.density);
+    fglGetFloatv(GL_FOG_START, &g_cached_fog.start);
+    fglGetFloatv(GL_FOG_END, &g_cached_fog.end);
+    g_cached_fog.tracking = true;
+}
+
+
+program_cache g_programCache;
+
+std::filesystem::path GetProgramCachePath() {
+    std::wstring path = GetCurrentModuleName();
+    path.resize(path.find_last_of(L"/\\") + 1);
+    return path + TEXT(MOD_NAME) L".glprograms.cache";
+}
+
+static double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Writes what was stored since the last flush: after registration (the first frame ending after it), on vid_restart
+// and at shutdown, never per stored program
+void OpenGL_FlushProgramCache() {
+    if (g_programCache.is_dirty() && !g_programCache.flush())
+        ATI_DEBUG_PRINT_CHANNEL(0, "Failed to write %ls\n", GetProgramCachePath().c_str());
+}
+
+// Opens the binary cache for the driver of the current context, called on every renderer init
+static void ProgramCache_Open() {
+    OpenGL_FlushProgramCache();
+    g_programCache.close();
+
+    if (!r_arb_fragment_program_cache || !r_arb_fragment_program_cache->base->integer)
+        return;
+
+    if (!fglProgramParameteri || !fglGetProgramBinary || !fglProgramBinary || !fGlGetString || !fglGetIntegerv)
+        return;
+
+    GLint formats = 0;
+    fglGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    if (formats <= 0) {
+        ATI_DEBUG_PRINT_CHANNEL(0, "GL program cache not used: the driver has no program binary formats\n");
+        return;
+    }
+
+    auto glString = [](GLenum name) {
+        const char* str = fGlGetString(name);
+        return std::string(str ? str : "");
+    };
+
+    // the build decides the GLSL a key translates to, so binaries of other builds don't apply either
+    std::string driver = glString(GL_VENDOR) + "\n" + glString(GL_RENDERER) + "\n" + glString(GL_VERSION) +
+        "\n" MOD_NAME " r" BUILD_NUMBER_STR " " COMMIT_HASH;
+    std::string error;
+
+    if (g_programCache.open(GetProgramCachePath(), driver, error))
+        ATI_DEBUG_PRINT_CHANNEL(0, "GL program cache: %d programs\n", (int)g_programCache.size());
+    else
+        ATI_DEBUG_PRINT_CHANNEL(0, "GL program cache not used: %s\n", error.c_str());
+}
+
+// Links the cached binary for 'hash', 0 without one or when the driver refuses it. 'source' gets the cached GLSL
+// whenever there is an entry, so a refused binary doesn't have to be translated again.
+static GLuint ProgramCache_Load(uint64_t hash, std::string_view key, std::string* source) {
+    if (!g_programCache.is_open())
+        return 0;
+
+    const program_cache_entry* entry = g_programCache.find(hash, key);
+    if (!entry) {
+        g_programCache.record_miss();
+        return 0;
+    }
+
+    if (source)
+        *source = entry->fragmentSource;
+
+    auto start = std::chrono::steady_clock::now();
+    GLuint program = fglCreateProgram();
+    fglProgramBinary(program, entry->binaryFormat, entry->binary.data(), (GLsizei)entry->binary.size());
+
+    GLint success = 0;
+    fglGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        fglDeleteProgram(program);
+        g_programCache.record_reject();
+        ATI_DEBUG_PRINT_CHANNEL(0, "Cached binary %016llX refused by the driver, compiling it\n", (unsigned long long)hash);
+        return 0;
+    }
+
+    g_programCache.record_hit(*entry, MillisecondsSince(start));
+    ATI_DEBUG_PRINT_CHANNEL(0, "Loaded program %d from cached binary %016llX\n", program, (unsigned long long)hash);
+    return program;
+}
+
+// Saves the binary of a program just linked from 'source'
+static void ProgramCache_Store(uint64_t hash, std::string_view key, const std::string& source, GLuint program, double linkMs) {
+    if (!g_programCache.is_open() || program == 0)
+        return;
+
+    GLint success = 0, length = 0;
+    fglGetProgramiv(program, GL_LINK_STATUS, &success);
+    fglGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (!success || length <= 0)
+        return;
+
+    program_cache_entry entry;
+    entry.key = key;
+    entry.fragmentSource = source;
+    entry.linkMs = (float)linkMs;
+    entry.binary.resize(length);
+
+    GLsizei written = 0;
+    GLenum format = 0;
+    fglGetProgramBinary(program, length, &written, &format, entry.binary.data());
+    if (written <= 0)
+        return;
+
+    entry.binary.resize(written);
+    entry.binaryFormat = format;
+
+    g_programCache.store(hash, std::move(entry));
+}
+
+void PrintProgramCacheStats() {
+    const program_cache_stats& stats = g_programCache.stats();
+
+    Com_Printf("GL program cache: %s, %d programs\n", g_programCache.is_open() ? "on" : "off", (int)g_programCache.size());
+    Com_Printf("  %u hits, %u misses, %u refused by the driver, %u stored\n", stats.hits, stats.misses, stats.rejected, stats.stored);
+    Com_Printf("  %.2f ms loading binaries, %.2f ms of compiling and linking saved\n", stats.loadMs, stats.savedMs);
+}
+
+// Uploads skip values the bound program already holds, 'force' after (re)linking
+static void SetUniform1f(GLint loc, GLfloat& uploaded, GLfloat value, bool force) {
+    if (loc < 0 || (!force && uploaded == value))
+        return;
+    uploaded = value;
+    fglUniform1f(loc, value);
+}
+
+static void SetUniform4f(GLint loc, GLfloat (&uploaded)[4], const GLfloat* value, bool force) {
+    if (loc < 0 || (!force && memcmp(uploaded, value, sizeof(uploaded)) == 0))
+        return;
+    memcpy(uploaded, value, sizeof(uploaded));
+    fglUniform4f(loc, value[0], value[1], value[2], value[3]);
+}
+
+static void ResolveUniformLocations(ATIProgramVariant& variant) {
+    variant.uniforms = ATIUniformLocations();
+    variant.uploadedValid = false;
+
+    if (!fglGetUniformLocation || variant.glsl_program == 0)
+        return;
+
+    GLuint program = variant.glsl_program;
+    ATIUniformLocations& loc = variant.uniforms;
+    loc.fogDensity = fglGetUniformLocation(program, "fogDensity");
+    loc.fogStart = fglGetUniformLocation(program, "fogStart");
+    loc.fogEnd = fglGetUniformLocation(program, "fogEnd");
+    loc.fogColor = fglGetUniformLocation(program, "fogColor");
+    loc.fresnelPower = fglGetUniformLocation(program, "fresnelPower");
+    loc.fresnelBias = fglGetUniformLocation(program, "fresnelBias");
+}
+
+// Everything ATIIR_Build reads from a shader, flattened
+static std::vector<GLuint> SerializeATIInstructions(const ATIShader& shader) {
+    std::vector<GLuint> key;
+    key.reserve(shader.orderedInstructions.size() * 16);
+
+    for (const auto& any : shader.orderedInstructions) {
+        if (any.isSetup) {
+            const ATISetupInst& inst = any.setup;
+            key.insert(key.end(), { 1u, inst.isPassTexCoord ? 1u : 0u, inst.dst, inst.src, (GLuint)inst.swizzle });
+        }
+        else {
+            const ATIInstruction& inst = any.arith;
+            key.insert(key.end(), { 2u, (GLuint)inst.type, (GLuint)inst.op, inst.dst, inst.dstMask, inst.dstMod, (GLuint)inst.argCount });
+            for (int i = 0; i < inst.argCount && i < 3; i++) {
+                key.insert(key.end(), { inst.args[i].index, inst.args[i].rep, inst.args[i].mod });
+            }
         }
-        ATI_DEBUG_PRINT_CHANNEL(1, "Disabled shaders (fixed function)\n");
     }
-    else if (g_ati_shaders.count(id) > 0 && g_ati_shaders[id].compiled && g_ati_shaders[id].glsl_program != 0) {
-        GLuint program = g_ati_shaders[id].glsl_program;
 
-        if (fglUseProgram) {
-            fglUseProgram(program);
+    // folded in, so part of the program
+    for (int i = 0; i < ATI_IR_CONSTANTS; i++) {
+        if (shader.constantsSet & (1 << i)) {
+            GLuint bits[4];
+            memcpy(bits, shader.constants[i], sizeof(bits));
+            key.insert(key.end(), { 3u, (GLuint)i, bits[0], bits[1], bits[2], bits[3] });
         }
+    }
 
-        if (fglGetUniformLocation && fglUniform1i && fglUniform1f && fglUniform4f) {
-            GLint loc;
+    return key;
+}
 
-            // Capture current fog state
-            GLboolean fogEnabled = fglIsEnabled(GL_FOG);
-            GLint fogMode = 0;
-            GLfloat fogDensity = 0, fogStart = 0, fogEnd = 0;
-            GLfloat* fogColor = (GLfloat*)exe(0x47BDF80,0x4899F20);
+// Forgets every cached program and the shaders' references to them. Only called once their context is gone, which
+// took the GL objects along, so nothing is deleted.
+static void ATIProgramCache_Drop() {
+    for (auto& [id, shader] : g_ati_shaders) {
+        shader.program = nullptr;
+        shader.compiled = false;
+    }
 
-            fglGetIntegerv(GL_FOG_MODE, &fogMode);
-            fglGetFloatv(GL_FOG_DENSITY, &fogDensity);
-            fglGetFloatv(GL_FOG_START, &fogStart);
-            fglGetFloatv(GL_FOG_END, &fogEnd);
-            //fglGetFloatv(GL_FOG_COLOR, fogColor);
+    ATI_DEBUG_PRINT_CHANNEL(0, "Dropped %d cached GLSL programs\n", (int)g_ati_programs.size());
+    g_ati_programs.clear();
+    g_ati_prewarm_pending.clear();
+}
 
-            ATI_DEBUG_PRINT_CHANNEL(1, "[FOG DEBUG] Enabled=%d, Mode=0x%X, Start=%.2f, End=%.2f, Density=%.4f, Color=(%.2f,%.2f,%.2f,%.2f)\n",
-                fogEnabled, fogMode, fogStart, fogEnd, fogDensity,
-                fogColor[0], fogColor[1], fogColor[2], fogColor[3]);
+static void ATIProgramCache_CheckContext() {
+    HGLRC context = fwglGetCurrentContext ? fwglGetCurrentContext() : nullptr;
+    if (context == g_ati_programs_context)
+        return;
+
+    ATIProgramCache_Drop();
+    g_ati_programs_context = context;
+}
+
+// Returns the program for the shader's instruction stream with a reference taken, building the IR only when no other
+// shader recorded the same stream before. Nothing is linked here, see GetATIProgramVariant.
+static ATIProgram* AcquireATIProgram(const ATIShader& shader) {
+    ATIProgramCache_CheckContext();
+
+    std::vector<GLuint> key = SerializeATIInstructions(shader);
+    std::string_view keyBytes(reinterpret_cast<const char*>(key.data()), key.size() * sizeof(GLuint));
+    uint64_t hash = Hash_FNV1a64(keyBytes.data(), keyBytes.size());
+
+    auto range = g_ati_programs.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second.key == key) {
+            it->second.refs++;
+            return &it->second;
+        }
+    }
+
+    ATIProgram& linked = g_ati_programs.emplace(hash, ATIProgram())->second;
+    linked.key = std::move(key);
+    linked.refs = 1;
+    linked.ir = ATIIR_Build(shader.orderedInstructions, shader.constants, shader.constantsSet);
+
+    for (GLenum op : linked.ir.unknownOps) {
+        ATI_DEBUG_PRINT_CHANNEL(0, "WARNING: Unknown opcode 0x%X\n", op);
+    }
+
+    ATIIR_FoldConstants(linked.ir);
+    return &linked;
+}
+
+// Links variant 'index' of a program unless it already was. Only called when a shader is recorded and at the end of
+// a frame, the bind path never compiles or links. Binary cache entries are keyed by the instruction stream and the
+// variant.
+static ATIProgramVariant& GetATIProgramVariant(ATIProgram& linked, int index) {
+    ATIProgramVariant& variant = linked.variants[index];
+    if (variant.built)
+        return variant;
+    variant.built = true;
+
+    std::string key(reinterpret_cast<const char*>(linked.key.data()), linked.key.size() * sizeof(GLuint));
+    key += "\nvariant " + std::to_string(index);
+    uint64_t hash = Hash_FNV1a64(key.data(), key.size());
+
+    std::string glslSource;
+    GLuint program = ProgramCache_Load(hash, key, &glslSource);
+
+    if (!program) {
+        // Translate to GLSL
+        if (glslSource.empty())
+            glslSource = ATIIR_TranslateToGLSL(linked.ir, index);
+        auto logfile = Cvar_Find("logfile");
+
+        if (logfile && logfile->integer) {
+            ATI_DEBUG_PRINT_CHANNEL(0, "[ATI->GLSL] Generated shader : \n % s\n", glslSource.c_str());
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        program = CompileGLSL(glslSource);
+        ProgramCache_Store(hash, key, glslSource, program, MillisecondsSince(start));
+    }
+
+    variant.glsl_program = program;
+    ResolveUniformLocations(variant);
+
+    // Samplers never change, set once
+    if (program != 0 && fglUseProgram && fglGetUniformLocation && fglUniform1i) {
+        fglUseProgram(program);
+        for (int unit = 0; unit < ATI_IR_REGISTERS; unit++) {
+            std::string name = "tex" + std::to_string(unit);
+            GLint loc = fglGetUniformLocation(program, name.c_str());
+            if (loc >= 0) fglUniform1i(loc, unit);
+        }
+
+        ATI_DEBUG_PRINT_CHANNEL(0, "Linked variant %d (debug view %d, fog %d) as program %d\n",
+            index, ATIVariant_DebugMode(index), ATIVariant_Fog(index), program);
+    }
+
+    return variant;
+}
+
+// Builds every fog variant of a debug view, so changing the fog mode mid-frame never links
+static void PrewarmATIProgram(ATIProgram& linked, int debugMode) {
+    for (int fog = ATI_FOG_OFF; fog <= ATI_FOG_LINEAR; fog++)
+        GetATIProgramVariant(linked, ATIVariant_Index(debugMode, fog));
+}
+
+// The variant to bind when 'index' isn't built yet: the same debug view with another fog mode, otherwise any
+static ATIProgramVariant* FallbackATIProgramVariant(ATIProgram& linked, int index) {
+    int debugMode = ATIVariant_DebugMode(index);
+    for (int fog = ATI_FOG_OFF; fog <= ATI_FOG_LINEAR; fog++) {
+        ATIProgramVariant& variant = linked.variants[ATIVariant_Index(debugMode, fog)];
+        if (variant.built && variant.glsl_program != 0)
+            return &variant;
+    }
+
+    for (ATIProgramVariant& variant : linked.variants) {
+        if (variant.built && variant.glsl_program != 0)
+            return &variant;
+    }
+    return nullptr;
+}
+
+// Builds the variants programs were bound without during the frame (a new debug view), then writes the binary cache
+void OpenGL_OnEndFrame() {
+    if (!g_ati_prewarm_pending.empty() && fglUseProgram && fglGetIntegerv) {
+        GLint current = 0;
+        fglGetIntegerv(GL_CURRENT_PROGRAM, &current);
+
+        for (ATIProgram* linked : g_ati_prewarm_pending) {
+            linked->prewarmPending = false;
+            PrewarmATIProgram(*linked, g_atiUniformViews.debugMode);
+        }
+        g_ati_prewarm_pending.clear();
 
-            // Update fog uniforms
-            loc = fglGetUniformLocation(program, "fogEnabled");
-            if (loc >= 0) fglUniform1i(loc, fogEnabled ? 1 : 0);
+        fglUseProgram(current);
+    }
+
+    OpenGL_FlushProgramCache();
+}
+
+// Unreferenced programs stay cached for the next shader with the same instructions
+static void ReleaseATIProgram(ATIShader& shader) {
+    if (shader.program && shader.program->refs > 0)
+        shader.program->refs--;
+    shader.program = nullptr;
+    shader.compiled = false;
+}
 
-            loc = fglGetUniformLocation(program, "fogMode");
-            if (loc >= 0) fglUniform1i(loc, fogMode);
+extern bool g_sun_shader_initialized;
 
-            loc = fglGetUniformLocation(program, "fogDensity");
-            if (loc >= 0) fglUniform1f(loc, fogDensity);
+void OpenGL_OnModuleUnload(HMODULE module) {
+    if (module && module == opengl_addr) {
+        OpenGL_FlushProgramCache();
+        g_fogHooksInstalled = false;
+        g_cached_fog.tracking = false;
 
-            loc = fglGetUniformLocation(program, "fogStart");
-            if (loc >= 0) fglUniform1f(loc, fogStart);
+        // the context is gone by now
+        ATIProgramCache_Drop();
+        g_sun_shader_initialized = false;
+        g_ati_programs_context = nullptr;
+    }
+}
+
+struct ATIFogState {
+    GLboolean enabled;
+    GLint mode;
+    GLfloat density;
+    GLfloat start;
+    GLfloat end;
+    const GLfloat* color;
+};
 
-            loc = fglGetUniformLocation(program, "fogEnd");
-            if (loc >= 0) fglUniform1f(loc, fogEnd);
+static ATIFogState CurrentFogState() {
+    ATIFogState fog;
+    fog.color = (GLfloat*)exe(0x47BDF80,0x4899F20);
 
-            loc = fglGetUniformLocation(program, "fogColor");
-            if (loc >= 0) fglUniform4f(loc, fogColor[0], fogColor[1], fogColor[2], fogColor[3]);
+    if (g_cached_fog.tracking) {
+        fog.enabled = g_cached_fog.enabled;
+        fog.mode = g_cached_fog.mode;
+        fog.density = g_cached_fog.density;
+        fog.start = g_cached_fog.start;
+        fog.end = g_cached_fog.end;
+    }
+    else {
+        // hooks not in place, ask the driver
+        fog.enabled = fglIsEnabled(GL_FOG);
+        fog.mode = 0;
+        fog.density = 0, fog.start = 0, fog.end = 0;
+
+        fglGetIntegerv(GL_FOG_MODE, &fog.mode);
+        fglGetFloatv(GL_FOG_DENSITY, &fog.density);
+        fglGetFloatv(GL_FOG_START, &fog.start);
+        fglGetFloatv(GL_FOG_END, &fog.end);
+    }
+
+    return fog;
+}
+
+// The variant drawing with this fog state and the current debug cevars
+static int CurrentATIVariant(const ATIFogState& fog) {
+    int fogVariant = ATI_FOG_OFF;
+    if (fog.enabled && g_atiUniformViews.disableFog != 1)
+        fogVariant = ATIVariant_FogFromMode(fog.mode);
+
+    return ATIVariant_Index(g_atiUniformViews.debugMode, fogVariant);
+}
 
-            loc = fglGetUniformLocation(program, "debugMode");
-            if (loc >= 0) fglUniform1i(loc, (GLint)r_arb_fragment_shader_debug->base->integer);
+void WINAPI glBindFragmentShaderATI_hook(GLuint id) {
+    ATI_DEBUG_PRINT_CHANNEL(1,"glBindFragmentShaderATI(% d)\n", id);
+    g_current_shader = id;
+
+    if (id == 0) {
+        if (fglUseProgram) {
+            fglUseProgram(0);
+        }
+        ATI_DEBUG_PRINT_CHANNEL(1, "Disabled shaders (fixed function)\n");
+    }
+    else if (auto it = g_ati_shaders.find(id); it != g_ati_shaders.end() && it->second.compiled && it->second.program) {
+        ATIFogState fog = CurrentFogState();
+        ATIProgram& linked = *it->second.program;
+        int index = CurrentATIVariant(fog);
+
+        // Never link here. A debug view the program has no variants for yet draws with what it has for this frame.
+        ATIProgramVariant* bound = &linked.variants[index];
+        if (!bound->built) {
+            if (!linked.prewarmPending) {
+                linked.prewarmPending = true;
+                g_ati_prewarm_pending.push_back(&linked);
+            }
+            bound = FallbackATIProgramVariant(linked, index);
+            if (!bound)
+                return;
+        }
+
+        ATIProgramVariant& variant = *bound;
+        GLuint program = variant.glsl_program;
+        if (program == 0)
+            return;
+
+        if (fglUseProgram) {
+            fglUseProgram(program);
+        }
 
-            loc = fglGetUniformLocation(program, "debugMode");
-            if (loc >= 0) fglUniform1i(loc, r_arb_fragment_shader_debug->base->integer);
+        if (fglUniform1f && fglUniform4f) {
+            ATI_DEBUG_PRINT_CHANNEL(1, "[FOG DEBUG] Enabled=%d, Mode=0x%X, Start=%.2f, End=%.2f, Density=%.4f, Color=(%.2f,%.2f,%.2f,%.2f)\n",
+                fog.enabled, fog.mode, fog.start, fog.end, fog.density,
+                fog.color[0], fog.color[1], fog.color[2], fog.color[3]);
 
-            loc = fglGetUniformLocation(program, "fresnelPower");
-            if (loc >= 0) fglUniform1f(loc, r_arb_fragment_fresnel_power->base->value);
+            // Fog enable/mode and the debug view are compiled into the variant
+            const ATIUniformLocations& loc = variant.uniforms;
+            ATIUniformValues& uploaded = variant.uploaded;
+            bool force = !variant.uploadedValid;
 
-            loc = fglGetUniformLocation(program, "fresnelBias");
-            if (loc >= 0) fglUniform1f(loc, r_arb_fragment_fresnel_bias->base->value);
+            SetUniform1f(loc.fogDensity, uploaded.fogDensity, fog.density, force);
+            SetUniform1f(loc.fogStart, uploaded.fogStart, fog.start, force);
+            SetUniform1f(loc.fogEnd, uploaded.fogEnd, fog.end, force);
+            SetUniform4f(loc.fogColor, uploaded.fogColor, fog.color, force);
 
-            loc = fglGetUniformLocation(program, "disableFog");
-            if (loc >= 0) fglUniform1i(loc, r_arb_fragment_disable_fog->base->integer);
+            SetUniform1f(loc.fresnelPower, uploaded.fresnelPower, g_atiUniformViews.fresnelPower, force);
+            SetUniform1f(loc.fresnelBias, uploaded.fresnelBias, g_atiUniformViews.fresnelBias, force);
 
+            variant.uploadedValid = true;
         }
 
         ATI_DEBUG_PRINT_CHANNEL(1, " Activated shader program %d\n", program);
@@ -597,13 +822,8 @@ void WINAPI glBindFragmentShaderATI_hook(GLuint id) {
 void WINAPI glDeleteFragmentShaderATI_hook(GLuint id) {
     ATI_DEBUG_PRINT_CHANNEL(1, "glDeleteFragmentShaderATI(%d)\n", id);
     if (g_ati_shaders.count(id)) {
-        if (g_ati_shaders[id].glsl_program != 0) {
-            if (fglDeleteProgram) {
-                fglDeleteProgram(g_ati_shaders[id].glsl_program);
-                ATI_DEBUG_PRINT_CHANNEL(0, "Deleted GLSL program %d for ATI shader %d\n",
-                    g_ati_shaders[id].glsl_program, id);
-            }
-        }
+        // the program stays cached
+        ReleaseATIProgram(g_ati_shaders[id]);
 
         // If deleting the currently bound shader, unbind it
         if (g_current_shader == id) {
@@ -621,14 +841,9 @@ void DeleteAllATIFragmentShaders() {
     ATI_DEBUG_PRINT_CHANNEL(0, "Deleting all ATI fragment shaders (%d total)\n",
         (int)g_ati_shaders.size());
 
+    // Programs stay cached for the shaders the renderer records after a restart
     for (auto& pair : g_ati_shaders) {
-        if (pair.second.glsl_program != 0) {
-            if (fglDeleteProgram) {
-                fglDeleteProgram(pair.second.glsl_program);
-                ATI_DEBUG_PRINT_CHANNEL(1, "Deleted GLSL program %d for ATI shader %d\n",
-                    pair.second.glsl_program, pair.first);
-            }
-        }
+        ReleaseATIProgram(pair.second);
     }
 
     g_ati_shaders.clear();
@@ -643,9 +858,11 @@ void DeleteAllATIFragmentShaders() {
 void WINAPI glBeginFragmentShaderATI_hook() {
     ATI_DEBUG_PRINT_CHANNEL(1, "glBeginFragmentShaderATI()\n");
     g_building = true;
+    ReleaseATIProgram(g_ati_shaders[g_current_shader]);
     g_ati_shaders[g_current_shader].setup.clear();
     g_ati_shaders[g_current_shader].instructions.clear();
     g_ati_shaders[g_current_shader].orderedInstructions.clear();  // NEW
+    g_ati_shaders[g_current_shader].constantsSet = 0;
     g_ati_shaders[g_current_shader].compiled = false;
 }
 
@@ -668,53 +885,23 @@ void WINAPI glEndFragmentShaderATI_hook() {
         g_current_shader,
         (int)shader.orderedInstructions.size());
 
-    // Translate to GLSL
-    std::string glslSource = TranslateToGLSL(shader);
-    auto logfile = Cvar_Find("logfile");
-
-    if (logfile && logfile->integer) {
-        ATI_DEBUG_PRINT_CHANNEL(0, "[ATI->GLSL] Generated shader : \n % s\n", glslSource.c_str());
-    }
-    // Compile GLSL
-    shader.glsl_program = CompileGLSL(glslSource);
+    ReleaseATIProgram(shader);
+    shader.program = AcquireATIProgram(shader);
     shader.compiled = true;
 
-    // Activate it
-    if (shader.glsl_program != 0) {
-        fglUseProgram(shader.glsl_program);
-
-
-        // Get uniform locations and set them
-        auto glGetUniformLocation = (GLint(WINAPI*)(GLuint, const GLchar*))
-            wglGetProcAddressD->unsafe_stdcall<void*>("glGetUniformLocation");
-        auto glUniform1i = (void(WINAPI*)(GLint, GLint))
-            wglGetProcAddressD->unsafe_stdcall<void*>("glUniform1i");
-
-        if (glGetUniformLocation && glUniform1i) {
-            GLint loc;
-            loc = glGetUniformLocation(shader.glsl_program, "tex0");
-            if (loc >= 0) glUniform1i(loc, 0);
-
-            loc = glGetUniformLocation(shader.glsl_program, "tex1");
-            if (loc >= 0) glUniform1i(loc, 1);
-
-            loc = glGetUniformLocation(shader.glsl_program, "tex2");
-            if (loc >= 0) glUniform1i(loc, 2);
-
-            loc = glGetUniformLocation(shader.glsl_program, "tex3");
-            if (loc >= 0) glUniform1i(loc, 3);
-
-            loc = glGetUniformLocation(shader.glsl_program, "tex4");
-            if (loc >= 0) glUniform1i(loc, 4);
+    if (shader.program->refs > 1) {
+        ATI_DEBUG_PRINT_CHANNEL(0, "Shader %d shares its program (%u users)\n", g_current_shader, shader.program->refs);
+    }
 
-            loc = glGetUniformLocation(shader.glsl_program, "tex5");
-            if (loc >= 0) glUniform1i(loc, 5);
-
-            ATI_DEBUG_PRINT_CHANNEL(0, "Bound texture uniforms\n");
-        }
+    // Link every fog variant of the current debug view now rather than at a bind, and activate the one the current
+    // state draws with
+    PrewarmATIProgram(*shader.program, g_atiUniformViews.debugMode);
+    ATIProgramVariant& variant = GetATIProgramVariant(*shader.program, CurrentATIVariant(CurrentFogState()));
+    if (variant.glsl_program != 0) {
+        fglUseProgram(variant.glsl_program);
 
         ATI_DEBUG_PRINT_CHANNEL(0, "Shader %d compiled and activated (program %d)\n",
-            g_current_shader, shader.glsl_program);
+            g_current_shader, variant.glsl_program);
     }
 }
 
@@ -891,6 +1078,8 @@ void WINAPI glSetFragmentShaderConstantATI_hook(GLuint dst, const GLfloat* value
     int idx = dst - GL_CON_0_ATI;
     if (idx >= 0 && idx < 8) {
         memcpy(g_ati_shaders[g_current_shader].constants[idx], value, sizeof(float) * 4);
+        if (g_building)
+            g_ati_shaders[g_current_shader].constantsSet |= 1 << idx;
     }
 }
 
@@ -977,6 +1166,14 @@ GLuint CreateSunShader() {
         "    gl_FragColor = texture2D(texture0, gl_TexCoord[0].xy) * gl_Color;\n"
         "}\n";
 
+    std::string key = std::string("sun\n") + vsSrc + fsSrc;
+    uint64_t hash = Hash_FNV1a64(key.data(), key.size());
+
+    GLuint cached = ProgramCache_Load(hash, key, nullptr);
+    if (cached)
+        return cached;
+
+    auto start = std::chrono::steady_clock::now();
     GLuint vs = fglCreateShader(GL_VERTEX_SHADER);
     fglShaderSource(vs, 1, &vsSrc, NULL);
     fglCompileShader(vs);
@@ -1004,6 +1201,8 @@ GLuint CreateSunShader() {
     GLuint program = fglCreateProgram();
     fglAttachShader(program, vs);
     fglAttachShader(program, fs);
+    if (fglProgramParameteri)
+        fglProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     fglLinkProgram(program);
 
 
@@ -1017,6 +1216,8 @@ GLuint CreateSunShader() {
     fglDeleteShader(vs);
     fglDeleteShader(fs);
 
+    ProgramCache_Store(hash, key, fsSrc, program, MillisecondsSince(start));
+
     ATI_DEBUG_PRINT_CHANNEL(0, "[SUN SHADER] Compiled shader program: %d\n", program);
     return program;
 }
@@ -1081,12 +1282,28 @@ namespace opengl_ati_frag {
     uintptr_t saved_addr = 0;
     class component final : public component_interface
     {
+        void* draw_sun_sprite_call = nullptr;
+        void* fragment_shader_check = nullptr;
+
     public:
 
+        bool is_scan_phase(component_phase phase) override
+        {
+            return phase == component_phase::post_unpack;
+        }
+
+        void prepare(component_phase) override
+        {
+            auto pattern = hook::pattern("E8 ? ? ? ? ? ? ? 52 E8 ? ? ? ? 83 C4 ? 59"_sig);
+            draw_sun_sprite_call = pattern.empty() ? nullptr : pattern.get_first();
+
+            pattern = hook::pattern("0F 84 ? ? ? ? 8B 0D ? ? ? ? 39 71 ? 0F 84 ? ? ? ? 68 ? ? ? ? FF 15 ? ? ? ? 68 ? ? ? ? A3 ? ? ? ? A3 ? ? ? ? FF 15 ? ? ? ? 68 ? ? ? ? A3 ? ? ? ? A3 ? ? ? ? FF 15 ? ? ? ? 68 ? ? ? ? A3 ? ? ? ? A3 ? ? ? ? FF 15 ? ? ? ? 68 ? ? ? ? A3 ? ? ? ? A3 ? ? ? ? FF 15 ? ? ? ? 68 ? ? ? ? A3 ? ? ? ? A3 ? ? ? ? FF 15 ? ? ? ? 68 ? ? ? ? A3 ? ? ? ? A3 ? ? ? ? FF 15 ? ? ? ? 68 ? ? ? ? A3 ? ? ? ? A3 ? ? ? ? FF 15 ? ? ? ? 68 ? ? ? ? A3 ? ? ? ? A3 ? ? ? ? FF 15 ? ? ? ? 68 ? ? ? ? A3 ? ? ? ? A3 ? ? ? ? FF 15 ? ? ? ? 68 ? ? ? ? A3 ? ? ? ? A3 ? ? ? ? FF 15 ? ? ? ? 68"_sig);
+            fragment_shader_check = pattern.empty() ? nullptr : pattern.get_first();
+        }
+
         void post_unpack() override {
-            auto pattern = hook::pattern("E8 ? ? ? ? ? ? ? 52 E8 ? ? ? ? 83 C4 ? 59");
-            if(!pattern.empty())
-            Memory::VP::InterceptCall(pattern.get_first(), RB_DrawSunSprite_addr, hooked_RB_DrawSunSprite);
+            if(draw_sun_sprite_call)
+            Memory::VP::InterceptCall(draw_sun_sprite_call, RB_DrawSunSprite_addr, hooked_RB_DrawSunSprite);
 
             r_arb_fragment_shader_wrap_ati = Cevar_Get("r_arb_fragment_shader_wrap_ati", 1, CVAR_ARCHIVE | CVAR_LATCH, 0, 2);
             r_arb_fragment_shader_debug = Cevar_Get("r_arb_fragment_shader_debug", 0, CVAR_ARCHIVE, -1, 6);
@@ -1094,21 +1311,15 @@ namespace opengl_ati_frag {
             r_arb_fragment_fresnel_power = Cevar_Get("r_arb_fragment_fresnel_power",2.0f, CVAR_ARCHIVE);  // current Default: 2.0
             r_arb_fragment_fresnel_bias = Cevar_Get("r_arb_fragment_fresnel_bias", 0.f, CVAR_ARCHIVE);      // current Default: 0.0
             r_arb_fragment_disable_fog = Cevar_Get("r_arb_fragment_disable_fog", 0, 0, 0,1);  // default 0 (fog enabled)
-            //pattern = hook::pattern("57 33 FF 3B C7 0F 84 ? ? ? ? 8B 15");
-            //if(!pattern.empty())
-            //    if (!pattern.empty())
-            //        static auto RE_beinframe = safetyhook::create_mid(pattern.get_first(-5), [](SafetyHookContext& ctx) {
-            //        // Capture fog state once per frame
-            //        g_cached_fog.enabled = fglIsEnabled(GL_FOG);
-            //        fglGetIntegerv(GL_FOG_MODE, &g_cached_fog.mode);
-            //        fglGetFloatv(GL_FOG_DENSITY, &g_cached_fog.density);
-            //        fglGetFloatv(GL_FOG_START, &g_cached_fog.start);
-            //        fglGetFloatv(GL_FOG_END, &g_cached_fog.end);
-            //        fglGetFloatv(GL_FOG_COLOR, g_cached_fog.color);
-            //            });
-
-             pattern = hook::pattern("0F 84 ? ? ? ? 8B 0D ? ? ? ? 39 71 ? 0F 84 ? ? ? ? 68 ? ? ? ? FF 15 ? ? ? ? 68 ? ? ? ? A3 ? ? ? ? A3 ? ? ? ? FF 15 ? ? ? ? 68 ? ? ? ? A3 ? ? ? ? A3 ? ? ? ? FF 15 ? ? ? ? 68 ? ? ? ? A3 ? ? ? ? A3 ? ? ? ? FF 15 ? ? ? ? 68 ? ? ? ? A3 ? ? ? ? A3 ? ? ? ? FF 15 ? ? ? ? 68 ? ? ? ? A3 ? ? ? ? A3 ? ? ? ? FF 15 ? ? ? ? 68 ? ? ? ? A3 ? ? ? ? A3 ? ? ? ? FF 15 ? ? ? ? 68 ? ? ? ? A3 ? ? ? ? A3 ? ? ? ? FF 15 ? ? ? ? 68 ? ? ? ? A3 ? ? ? ? A3 ? ? ? ? FF 15 ? ? ? ? 68 ? ? ? ? A3 ? ? ? ? A3 ? ? ? ? FF 15 ? ? ? ? 68 ? ? ? ? A3 ? ? ? ? A3 ? ? ? ? FF 15 ? ? ? ? 68");
-            GL_ATI_fragment_shader_force_jump = safetyhook::create_mid(pattern.get_first(), [](SafetyHookContext& ctx) {
+            r_arb_fragment_program_cache = Cevar_Get("r_arb_fragment_program_cache", 1, CVAR_ARCHIVE, 0, 1);   // binaries in CoDUO-YAP.glprograms.cache
+
+            game::Cmd_AddCommand("yap_glprogramcache", PrintProgramCacheStats);
+
+            Cevar_BindView(g_atiUniformViews.debugMode, r_arb_fragment_shader_debug, 0);
+            Cevar_BindView(g_atiUniformViews.fresnelPower, r_arb_fragment_fresnel_power, 2.f);
+            Cevar_BindView(g_atiUniformViews.fresnelBias, r_arb_fragment_fresnel_bias, 0.f);
+            Cevar_BindView(g_atiUniformViews.disableFog, r_arb_fragment_disable_fog, 0);
+            GL_ATI_fragment_shader_force_jump = safetyhook::create_mid(fragment_shader_check, [](SafetyHookContext& ctx) {
 
                 if (!fglCreateShader || !fglShaderSource || !fglCompileShader) {
                     printf("[ERROR] Failed to load GLSL functions! OpenGL 2.0 not available?\n");
@@ -1156,12 +1367,14 @@ namespace opengl_ati_frag {
             fglIsEnabled = (PFNGLISENABLEDPROC)GetProcAddress(tOHGL, "glIsEnabled");
             fglEnable = (PFNGLENABLEPROC)GetProcAddress(tOHGL, "glEnable");
             fglDisable = (PFNGLENABLEPROC)GetProcAddress(tOHGL, "glDisable");
+            fwglGetCurrentContext = (PFNWGLGETCURRENTCONTEXTPROC)GetProcAddress(tOHGL, "wglGetCurrentContext");
 
 
             fGlGetString = (PFNGLGETSTRINGPROC)GetProcAddress(tOHGL, "glGetString");
 
+            FogShadow_InstallHooks(tOHGL);
 
-            auto pattern1 = hook::pattern("51 53 56 33 F6 57 68");
+            auto pattern1 = hook::pattern("51 53 56 33 F6 57 68"_sig);
             if (!pattern1.empty())
                 saved_addr = (uintptr_t)pattern1.get_first();
             if (saved_addr)
@@ -1191,6 +1404,14 @@ namespace opengl_ati_frag {
                 fglUniform1f = (PFNGLUNIFORM1FPROC)realWglGetProcAddress("glUniform1f");
                 fglUniform4f = (PFNGLUNIFORM4FPROC)realWglGetProcAddress("glUniform4f");
 
+                fglProgramParameteri = (PFNGLPROGRAMPARAMETERIPROC)realWglGetProcAddress("glProgramParameteri");
+                fglGetProgramBinary = (PFNGLGETPROGRAMBINARYPROC)realWglGetProcAddress("glGetProgramBinary");
+                fglProgramBinary = (PFNGLPROGRAMBINARYPROC)realWglGetProcAddress("glProgramBinary");
+
+                // new context, fog state starts over
+                FogShadow_Seed();
+                ProgramCache_Open();
+
                 printf("[OpenGL] Loaded GLSL function pointers:\n");
                 printf("  fglCreateShader: %p\n", fglCreateShader);
                 printf("  fglShaderSource: %p\n", fglShaderSource);
@@ -105,13 +105,13 @@ namespace rinput {
 		Memory::VP::Read(exe(0x454992 + 1, 0x46BF01 + 1), MainWndProc_addr);
 		Memory::VP::Patch<void*>(exe(0x454992 + 1, 0x46BF01 + 1), stub_MainWndProc);
 
-		auto pattern = hook::pattern("8B 15 ? ? ? ? 51 52 FF 15 ? ? ? ? 8B 0D ? ? ? ? ? ? ? 8B 15");
+		auto pattern = hook::pattern("8B 15 ? ? ? ? 51 52 FF 15 ? ? ? ? 8B 0D ? ? ? ? ? ? ? 8B 15"_sig);
 		if (!pattern.empty()) {
 			window_center_x = *(uint32_t**)pattern.get_first(2);
 			window_center_y = *(uint32_t**)pattern.get_first(-4);
 
 		}
-		 pattern = hook::pattern("A1 ? ? ? ? 85 C0 74 ? A1 ? ? ? ? 85 C0 74 ? C7 05 ? ? ? ? 00 00 00 00 E9 ? ? ? ? E8");
+		 pattern = hook::pattern("A1 ? ? ? ? 85 C0 74 ? A1 ? ? ? ? 85 C0 74 ? C7 05 ? ? ? ? 00 00 00 00 E9 ? ? ? ? E8"_sig);
 
 		if (!pattern.empty()) {
 			static auto clear_rawinput = safetyhook::create_mid(pattern.get_first(), [](SafetyHookContext& ctx) {
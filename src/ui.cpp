@@ -17,6 +17,7 @@
 bool GetGameScreenRes(vector2& res);
 double process_width(double width);
 double process_widths(double width); 
+void OpenGL_OnEndFrame();
 
 typedef int(__stdcall* glClearColorT)(float r, float g, float b, float a);
 
@@ -56,7 +57,12 @@ namespace gui {
     SafetyHookInline RE_EndFrameD;
     int __cdecl RE_EndFrame_hook(DWORD* a1, DWORD* a2) {
         draw_branding();
-        return RE_EndFrameD.unsafe_ccall<int>(a1, a2);
+        auto result = RE_EndFrameD.unsafe_ccall<int>(a1, a2);
+
+        // shader registration is over once a frame ends: link the variants binds were missing and write the programs
+        // linked since the last frame once
+        OpenGL_OnEndFrame();
+        return result;
     }
 
     void* VM_call_og;
@@ -87,13 +93,48 @@ namespace gui {
 
     class component final : public component_interface
     {
+        // scanned by prepare(), null when the pattern was not found
+        void* end_frame = nullptr;
+        void* subtitle_syscall = nullptr;
+        void* clear_check = nullptr;
+        void* gl_clear_call = nullptr;
+        void* gl_color_call = nullptr;
+
     public:
+        std::vector<std::string> get_dependencies() override
+        {
+            // RE_EndFrame_hook draws the branding through SCR_DrawString
+            return { "game::component" };
+        }
+
+        bool is_scan_phase(component_phase phase) override
+        {
+            return phase == component_phase::post_unpack;
+        }
+
+        void prepare(component_phase) override
+        {
+            auto pattern = hook::pattern("A1 ? ? ? ? 57 33 FF 3B C7 0F 84 ? ? ? ? A1"_sig);
+            end_frame = pattern.empty() ? nullptr : pattern.get_first();
+
+            pattern = hook::pattern("FF 15 ? ? ? ? 6A 00 FF 15 ? ? ? ? 83 C4 ? A1"_sig);
+            subtitle_syscall = pattern.empty() ? nullptr : pattern.get_first();
+
+            pattern = hook::pattern("8B 0D ? ? ? ? 8B 41 ? 85 C0 74 ? ? ? ? ? ? ? 8B 15"_sig);
+            clear_check = pattern.empty() ? nullptr : pattern.get_first();
+
+            pattern = hook::pattern("FF 15 ? ? ? ? F6 05 ? ? ? ? ? 5E"_sig);
+            gl_clear_call = pattern.empty() ? nullptr : pattern.get_first();
+
+            pattern = hook::pattern("FF 15 ? ? ? ? 68 ? ? ? ? FF 15 ? ? ? ? C7 05"_sig);
+            gl_color_call = pattern.empty() ? nullptr : pattern.get_first();
+        }
+
         void post_unpack() override
         {
             branding = Cevar_Get("branding", 1, CVAR_ARCHIVE, 0, 2);
-            auto pattern = hook::pattern("A1 ? ? ? ? 57 33 FF 3B C7 0F 84 ? ? ? ? A1");
-            if (!pattern.empty()) {
-                RE_EndFrameD = safetyhook::create_inline(pattern.get_first(), RE_EndFrame_hook);
+            if (end_frame) {
+                RE_EndFrameD = safetyhook::create_inline(end_frame, RE_EndFrame_hook);
             }
             cg_ammo_overwrite_size = Cevar_Get("cg_ammo_overwrite_size", 0.3f,CVAR_ARCHIVE);
             cg_ammo_overwrite_size_enabled = Cevar_Get("cg_ammo_overwrite_size_enabled", 1, CVAR_ARCHIVE);
@@ -149,18 +190,13 @@ namespace gui {
 
                     });
             }
-                pattern = hook::pattern("FF 15 ? ? ? ? 6A 00 FF 15 ? ? ? ? 83 C4 ? A1");
-                if (!pattern.empty()) {
-                    Memory::VP::Nop(pattern.get_first(), 6);
+                if (subtitle_syscall) {
+                    Memory::VP::Nop(subtitle_syscall, 6);
                 }
             
-            pattern = hook::pattern("8B 0D ? ? ? ? 8B 41 ? 85 C0 74 ? ? ? ? ? ? ? 8B 15");
-            auto glclearpat = hook::pattern("FF 15 ? ? ? ? F6 05 ? ? ? ? ? 5E");
-            auto glcolorpat = hook::pattern("FF 15 ? ? ? ? 68 ? ? ? ? FF 15 ? ? ? ? C7 05");
-
-            if (!glcolorpat.empty() && !glclearpat.empty() && !pattern.empty()) {
+            if (gl_color_call && gl_clear_call && clear_check) {
                 r_fixedaspect_clear = Cevar_Get("r_fixedaspect_clear", 2, CVAR_ARCHIVE, 0, 2);
-                static auto yeah = safetyhook::create_mid(pattern.get_first(), [](SafetyHookContext& ctx) {
+                static auto yeah = safetyhook::create_mid(clear_check, [](SafetyHookContext& ctx) {
                     if (!r_fixedaspect_clear)
                         return;
                     if ((r_fixedaspect_clear->base->integer == 1 || (r_fixedaspect_clear->base->integer == 2 && (*game::cstate != 2 || *game::keycatchers & KEYCATCH_UI)))) {
@@ -174,8 +210,8 @@ namespace gui {
                     }
                     });
 
-                glClearColor = *glcolorpat.get_first<glClearColorT*>(2);
-                glClear = *glclearpat.get_first<glClearT*>(2);
+                glClearColor = *(glClearColorT**)((uintptr_t)gl_color_call + 2);
+                glClear = *(glClearT**)((uintptr_t)gl_clear_call + 2);
 
             }
         }
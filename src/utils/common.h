@@ -1,6 +1,7 @@
 #pragma once
 #include "..\framework.h"
 std::wstring thisModuleFileName();
+std::wstring GetCurrentModuleName();
 std::wstring GetModulePath(HMODULE hModule);
 
 typedef struct {
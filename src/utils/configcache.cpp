@@ -0,0 +1,325 @@
+#include "configcache.h"
+#include "hash.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(config_cache_header) == 56, "config_cache_header layout is part of the file format");
+static_assert(sizeof(config_cache_source_record) == 40, "config_cache_source_record layout is part of the file format");
+static_assert(sizeof(menuwide_cache_record) == 16, "menuwide_cache_record layout is part of the file format");
+static_assert(sizeof(eweapon_cache_record) == 52, "eweapon_cache_record layout is part of the file format");
+
+static std::string ConfigCache_PathString(const std::filesystem::path& path) {
+    auto text = path.generic_u8string();
+    return std::string(reinterpret_cast<const char*>(text.data()), text.size());
+}
+
+static std::filesystem::path ConfigCache_Path(const std::string& text) {
+    return std::filesystem::path(std::u8string(text.begin(), text.end()));
+}
+
+static bool ConfigCache_HashFile(const std::filesystem::path& path, uint64_t& hash) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    hash = Hash_FNV1a64(data.data(), data.size());
+    return true;
+}
+
+static bool ConfigCache_Stat(const std::filesystem::path& path, uint64_t& size, int64_t& mtime) {
+    std::error_code ec;
+    size = std::filesystem::file_size(path, ec);
+    if (ec)
+        return false;
+
+    auto time = std::filesystem::last_write_time(path, ec);
+    if (ec)
+        return false;
+
+    mtime = time.time_since_epoch().count();
+    return true;
+}
+
+std::vector<config_cache_source> ConfigCache_Snapshot(const std::vector<std::filesystem::path>& dirs) {
+    std::vector<config_cache_source> sources;
+
+    for (const auto& dir : dirs) {
+        std::error_code ec;
+        bool exists = std::filesystem::is_directory(dir, ec);
+
+        // a directory appearing or disappearing invalidates the cache too, 'size' records whether it exists
+        sources.push_back({ ConfigCache_PathString(dir), true, exists ? 1u : 0u, 0, 0 });
+        if (!exists)
+            continue;
+
+        std::vector<std::filesystem::path> files;
+        for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+            if (entry.path().extension() == ".json")
+                files.push_back(entry.path());
+        }
+        std::sort(files.begin(), files.end());
+
+        for (const auto& file : files) {
+            config_cache_source source{ ConfigCache_PathString(file), false, 0, 0, 0 };
+            ConfigCache_Stat(file, source.size, source.mtime);
+            sources.push_back(std::move(source));
+        }
+    }
+
+    return sources;
+}
+
+// ============================================================================
+// WRITER
+// ============================================================================
+
+config_cache_writer::config_cache_writer(config_cache_kind kind, uint32_t recordSize)
+    : m_kind(kind), m_recordSize(recordSize) {
+}
+
+config_cache_string config_cache_writer::add_string(std::string_view text) {
+    config_cache_string str{ (uint32_t)m_strings.size(), (uint32_t)text.size() };
+    m_strings.append(text);
+    return str;
+}
+
+void config_cache_writer::add_record(const void* record) {
+    auto bytes = static_cast<const uint8_t*>(record);
+    m_records.insert(m_records.end(), bytes, bytes + m_recordSize);
+    m_recordCount++;
+}
+
+bool config_cache_writer::write(const std::filesystem::path& file, std::vector<config_cache_source> sources) {
+    std::vector<config_cache_source_record> sourceRecords;
+    sourceRecords.reserve(sources.size());
+
+    for (auto& source : sources) {
+        if (!source.isDirectory) {
+            // a file edited since the snapshot was taken would pair old records with its new hash
+            uint64_t size;
+            int64_t mtime;
+            if (!ConfigCache_HashFile(ConfigCache_Path(source.path), source.hash) ||
+                !ConfigCache_Stat(ConfigCache_Path(source.path), size, mtime) ||
+                size != source.size || mtime != source.mtime) {
+                return false;
+            }
+        }
+
+        config_cache_source_record record{};
+        record.path = add_string(source.path);
+        record.isDirectory = source.isDirectory;
+        record.size = source.size;
+        record.mtime = source.mtime;
+        record.hash = source.hash;
+        sourceRecords.push_back(record);
+    }
+
+    config_cache_header header{};
+    header.magic = CONFIG_CACHE_MAGIC;
+    header.version = CONFIG_CACHE_VERSION;
+    header.kind = m_kind;
+    header.recordSize = m_recordSize;
+    header.sourceCount = (uint32_t)sourceRecords.size();
+    header.recordCount = m_recordCount;
+    header.sourcesOffset = sizeof(config_cache_header);
+    header.recordsOffset = header.sourcesOffset + (uint32_t)(sourceRecords.size() * sizeof(config_cache_source_record));
+    header.stringsOffset = header.recordsOffset + (uint32_t)m_records.size();
+    header.stringsSize = (uint32_t)m_strings.size();
+    header.fileSize = header.stringsOffset + header.stringsSize;
+
+    std::vector<uint8_t> data(header.fileSize);
+    memcpy(data.data() + header.sourcesOffset, sourceRecords.data(), sourceRecords.size() * sizeof(config_cache_source_record));
+    memcpy(data.data() + header.recordsOffset, m_records.data(), m_records.size());
+    memcpy(data.data() + header.stringsOffset, m_strings.data(), m_strings.size());
+
+    header.checksum = Hash_FNV1a64(data.data() + sizeof(header), data.size() - sizeof(header));
+    memcpy(data.data(), &header, sizeof(header));
+
+    // unique per process and thread, a config reload on the watcher thread can store the same cache as the game
+    // thread, and whichever renames last wins with a complete file
+#ifdef _WIN32
+    const unsigned long pid = GetCurrentProcessId();
+#else
+    const unsigned long pid = (unsigned long)getpid();
+#endif
+    std::filesystem::path temp = file;
+    temp += "." + std::to_string(pid) + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+
+    std::error_code ec;
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        if (!out.write(reinterpret_cast<const char*>(data.data()), data.size())) {
+            out.close();
+            std::filesystem::remove(temp, ec);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(temp, file, ec);
+    if (ec) {
+        std::filesystem::remove(temp, ec);
+        return false;
+    }
+
+    return true;
+}
+
+// ============================================================================
+// READER
+// ============================================================================
+
+config_cache_reader::~config_cache_reader() {
+    close();
+}
+
+void config_cache_reader::close() {
+#ifdef _WIN32
+    if (m_data)
+        UnmapViewOfFile(m_data);
+    if (m_mapping)
+        CloseHandle(m_mapping);
+    if (m_file)
+        CloseHandle(m_file);
+    m_mapping = nullptr;
+    m_file = nullptr;
+#else
+    if (m_data)
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+    if (m_fd >= 0)
+        ::close(m_fd);
+    m_fd = -1;
+#endif
+    m_data = nullptr;
+    m_size = 0;
+}
+
+static bool ConfigCache_InBounds(uint64_t offset, uint64_t size, uint64_t fileSize) {
+    return offset <= fileSize && size <= fileSize - offset;
+}
+
+bool config_cache_reader::open(const std::filesystem::path& file, std::string& error) {
+    close();
+
+#ifdef _WIN32
+    HANDLE handle = CreateFileW(file.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, 0, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        error = "no cache file";
+        return false;
+    }
+    m_file = handle;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(handle, &size) || size.QuadPart < (LONGLONG)sizeof(config_cache_header)) {
+        error = "file too small";
+        return false;
+    }
+    m_size = (size_t)size.QuadPart;
+
+    m_mapping = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_mapping)
+        m_data = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+    m_fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (m_fd < 0) {
+        error = "no cache file";
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(m_fd, &st) != 0 || st.st_size < (off_t)sizeof(config_cache_header)) {
+        error = "file too small";
+        return false;
+    }
+    m_size = (size_t)st.st_size;
+
+    void* view = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+    if (view != MAP_FAILED)
+        m_data = static_cast<const uint8_t*>(view);
+#endif
+
+    if (!m_data) {
+        error = "could not map file";
+        m_size = 0;
+        return false;
+    }
+
+    const auto& head = header();
+    if (head.magic != CONFIG_CACHE_MAGIC || head.version != CONFIG_CACHE_VERSION) {
+        error = "not a cache file or a different version";
+        return false;
+    }
+
+    if (head.fileSize != m_size ||
+        head.sourcesOffset % alignof(config_cache_source_record) != 0 || head.recordsOffset % 4 != 0 || head.recordSize % 4 != 0 ||
+        !ConfigCache_InBounds(head.sourcesOffset, uint64_t(head.sourceCount) * sizeof(config_cache_source_record), m_size) ||
+        !ConfigCache_InBounds(head.recordsOffset, uint64_t(head.recordCount) * head.recordSize, m_size) ||
+        !ConfigCache_InBounds(head.stringsOffset, head.stringsSize, m_size) ||
+        head.sourcesOffset < sizeof(config_cache_header)) {
+        error = "truncated or malformed";
+        return false;
+    }
+
+    if (Hash_FNV1a64(m_data + sizeof(config_cache_header), m_size - sizeof(config_cache_header)) != head.checksum) {
+        error = "checksum mismatch";
+        return false;
+    }
+
+    return true;
+}
+
+bool config_cache_reader::open(const std::filesystem::path& file, config_cache_kind kind, uint32_t recordSize,
+    const std::vector<config_cache_source>& current, std::string& error) {
+    if (!open(file, error))
+        return false;
+
+    if (header().kind != kind || header().recordSize != recordSize) {
+        error = "different cache kind";
+        return false;
+    }
+
+    return sources_match(current, error);
+}
+
+bool config_cache_reader::sources_match(const std::vector<config_cache_source>& current, std::string& error) const {
+    if (current.size() != header().sourceCount) {
+        error = "source files were added or removed";
+        return false;
+    }
+
+    for (size_t i = 0; i < current.size(); i++) {
+        const auto& cached = source(i);
+        const auto& now = current[i];
+
+        if (string(cached.path) != now.path || (cached.isDirectory != 0) != now.isDirectory || cached.size != now.size) {
+            error = now.path + " changed";
+            return false;
+        }
+
+        if (now.isDirectory || cached.mtime == now.mtime)
+            continue;
+
+        // touched but maybe not edited (checkouts, copies), the contents decide
+        uint64_t hash;
+        if (!ConfigCache_HashFile(ConfigCache_Path(now.path), hash) || hash != cached.hash) {
+            error = now.path + " changed";
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,150 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Binary cache for the JSON configs (menuwide, eWeapons). One flat file: header, source list, fixed-size records and
+// a string table, all little-endian and 4-byte aligned, read straight out of a file mapping. The source list holds
+// every scanned directory and *.json file with size, mtime and content hash; a cache whose sources don't match the
+// disk anymore is ignored and rebuilt from JSON.
+//
+// Portable on purpose, tools/yapcache links this file to dump and verify caches.
+
+constexpr uint32_t CONFIG_CACHE_MAGIC = 0x43504159; // "YAPC"
+constexpr uint32_t CONFIG_CACHE_VERSION = 1;
+
+enum class config_cache_kind : uint32_t {
+    menuwide = 1,
+    eweapons = 2,
+};
+
+struct config_cache_header {
+    uint32_t magic;
+    uint32_t version;
+    config_cache_kind kind;
+    uint32_t recordSize;
+    uint32_t sourceCount;
+    uint32_t recordCount;
+    uint32_t sourcesOffset;
+    uint32_t recordsOffset;
+    uint32_t stringsOffset;
+    uint32_t stringsSize;
+    uint32_t fileSize;
+    uint32_t _pad;
+    uint64_t checksum;          // FNV-1a of everything after the header
+};
+
+// a string in the string table
+struct config_cache_string {
+    uint32_t offset;
+    uint32_t length;
+};
+
+struct config_cache_source_record {
+    config_cache_string path;
+    uint32_t isDirectory;
+    uint32_t _pad;
+    uint64_t size;
+    int64_t mtime;
+    uint64_t hash;              // FNV-1a of the contents, 0 for directories
+};
+
+struct menuwide_cache_record {
+    uint32_t isHudShader;       // 0 menu config, 1 _hudelem_shaders.json entry
+    config_cache_string name;
+    uint32_t alignment;         // Alignment bits
+};
+
+struct eweapon_cache_record {
+    config_cache_string name;
+    float sprintBob[2];
+    float sprintSpeedScale;
+    uint32_t hasSprintRot;
+    float sprintRot[3];
+    uint32_t hasSprintMove;
+    float sprintMove[3];
+};
+
+// What a cache was built from. 'hash' is only filled in when the cache is written or a changed mtime has to be
+// double checked.
+struct config_cache_source {
+    std::string path;
+    bool isDirectory;
+    uint64_t size;
+    int64_t mtime;
+    uint64_t hash;
+};
+
+// Every directory in 'dirs' (missing ones too) followed by its *.json files in name order, from stat only
+std::vector<config_cache_source> ConfigCache_Snapshot(const std::vector<std::filesystem::path>& dirs);
+
+
+class config_cache_writer {
+public:
+    config_cache_writer(config_cache_kind kind, uint32_t recordSize);
+
+    config_cache_string add_string(std::string_view text);
+    void add_record(const void* record);
+
+    // hashes the sources, writes to a temporary file and renames it over 'file'
+    bool write(const std::filesystem::path& file, std::vector<config_cache_source> sources);
+
+private:
+    config_cache_kind m_kind;
+    uint32_t m_recordSize;
+    uint32_t m_recordCount = 0;
+    std::vector<uint8_t> m_records;
+    std::string m_strings;
+};
+
+class config_cache_reader {
+public:
+    config_cache_reader() = default;
+    ~config_cache_reader();
+
+    config_cache_reader(const config_cache_reader&) = delete;
+    config_cache_reader& operator=(const config_cache_reader&) = delete;
+
+    // Maps 'file' and checks the header, bounds and checksum. 'error' says why it failed.
+    bool open(const std::filesystem::path& file, std::string& error);
+
+    // open() plus kind/record size checks and the sources compared against 'current' (a fresh snapshot)
+    bool open(const std::filesystem::path& file, config_cache_kind kind, uint32_t recordSize,
+        const std::vector<config_cache_source>& current, std::string& error);
+
+    bool sources_match(const std::vector<config_cache_source>& current, std::string& error) const;
+
+    const config_cache_header& header() const {
+        return *reinterpret_cast<const config_cache_header*>(m_data);
+    }
+
+    const config_cache_source_record& source(size_t index) const {
+        return reinterpret_cast<const config_cache_source_record*>(m_data + header().sourcesOffset)[index];
+    }
+
+    template <typename T>
+    const T& record(size_t index) const {
+        return reinterpret_cast<const T*>(m_data + header().recordsOffset)[index];
+    }
+
+    // empty for a string outside the table
+    std::string_view string(const config_cache_string& str) const {
+        if (str.offset > header().stringsSize || str.length > header().stringsSize - str.offset)
+            return {};
+        return std::string_view(reinterpret_cast<const char*>(m_data + header().stringsOffset) + str.offset, str.length);
+    }
+
+private:
+    void close();
+
+    const uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+#ifdef _WIN32
+    void* m_file = nullptr;
+    void* m_mapping = nullptr;
+#else
+    int m_fd = -1;
+#endif
+};
@@ -1,4 +1,203 @@
 #include "helper.hpp"
 #include <safetyhook.hpp>
-std::vector<std::unique_ptr<SafetyHookInline>> g_inlineHooks;
-std::vector<std::unique_ptr<SafetyHookMid>> g_midHooks;
+#include "hooking.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+
+namespace {
+    struct HookBucket {
+        // end == begin once the module is unloaded, the stats stay around for the next load
+        uintptr_t begin = 0;
+        uintptr_t end = 0;
+        char name[64]{};
+        std::vector<std::unique_ptr<SafetyHookInline>> inlineHooks;
+        std::vector<std::unique_ptr<SafetyHookMid>> midHooks;
+        double installMs = 0.0;
+        double teardownMs = 0.0;
+        uint32_t loads = 0;
+    };
+
+    // keyed by module base, 0 holds the hooks outside of any module
+    std::map<uintptr_t, HookBucket> g_hookBuckets;
+    std::mutex g_hookBucketsMutex;
+
+    std::vector<HookBatchStats> g_hookBatchStats;
+    std::mutex g_hookBatchStatsMutex;
+
+    HookBucket& GetHookBucket(uintptr_t address) {
+        auto it = g_hookBuckets.upper_bound(address);
+        if (it != g_hookBuckets.begin()) {
+            auto& bucket = std::prev(it)->second;
+            if (address >= bucket.begin && address < bucket.end)
+                return bucket;
+        }
+
+        HMODULE module = NULL;
+        if (!address || !GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+            reinterpret_cast<LPCSTR>(address), &module)) {
+            return g_hookBuckets[0];
+        }
+
+        auto base = reinterpret_cast<uintptr_t>(module);
+        auto& bucket = g_hookBuckets[base];
+
+        if (bucket.end == bucket.begin) {
+            auto ntHeaders = reinterpret_cast<PIMAGE_NT_HEADERS>(base + reinterpret_cast<PIMAGE_DOS_HEADER>(base)->e_lfanew);
+            bucket.begin = base;
+            bucket.end = base + ntHeaders->OptionalHeader.SizeOfImage;
+            bucket.loads++;
+
+            char path[MAX_PATH]{};
+            GetModuleFileNameA(module, path, sizeof(path));
+            const char* fileName = strrchr(path, '\\');
+            strncpy_s(bucket.name, fileName ? fileName + 1 : path, _TRUNCATE);
+        }
+
+        return bucket;
+    }
+
+    double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void ResetBucket(HookBucket& bucket) {
+        for (auto& hook : bucket.inlineHooks) {
+            if (hook)
+                hook->reset();
+        }
+
+        for (auto& hook : bucket.midHooks) {
+            if (hook)
+                hook->reset();
+        }
+
+        bucket.inlineHooks.clear();
+        bucket.midHooks.clear();
+        bucket.end = bucket.begin;
+    }
+}
+
+SafetyHookInline* RegisterHook(std::unique_ptr<SafetyHookInline> hook, std::chrono::steady_clock::time_point createStart) {
+    std::lock_guard<std::mutex> lock(g_hookBucketsMutex);
+    auto& bucket = GetHookBucket(reinterpret_cast<uintptr_t>(hook->target_address()));
+    auto* ptr = hook.get();
+    bucket.inlineHooks.push_back(std::move(hook));
+    bucket.installMs += MillisecondsSince(createStart);
+    return ptr;
+}
+
+SafetyHookMid* RegisterHook(std::unique_ptr<SafetyHookMid> hook, std::chrono::steady_clock::time_point createStart) {
+    std::lock_guard<std::mutex> lock(g_hookBucketsMutex);
+    auto& bucket = GetHookBucket(reinterpret_cast<uintptr_t>(hook->target_address()));
+    auto* ptr = hook.get();
+    bucket.midHooks.push_back(std::move(hook));
+    bucket.installMs += MillisecondsSince(createStart);
+    return ptr;
+}
+
+size_t UnloadModuleHooks(HMODULE module) {
+    auto start = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(g_hookBucketsMutex);
+
+    auto it = g_hookBuckets.find(reinterpret_cast<uintptr_t>(module));
+    if (!module || it == g_hookBuckets.end())
+        return 0;
+
+    auto& bucket = it->second;
+    size_t count = bucket.inlineHooks.size() + bucket.midHooks.size();
+    ResetBucket(bucket);
+    bucket.teardownMs = MillisecondsSince(start);
+    return count;
+}
+
+void ResetAllHooks() {
+    std::lock_guard<std::mutex> lock(g_hookBucketsMutex);
+    for (auto& [base, bucket] : g_hookBuckets) {
+        ResetBucket(bucket);
+    }
+}
+
+std::vector<HookModuleStats> GetHookModuleStats() {
+    std::lock_guard<std::mutex> lock(g_hookBucketsMutex);
+    std::vector<HookModuleStats> stats;
+    stats.reserve(g_hookBuckets.size());
+
+    for (const auto& [base, bucket] : g_hookBuckets) {
+        HookModuleStats entry{};
+        entry.begin = bucket.begin;
+        entry.end = bucket.end;
+        strncpy_s(entry.name, base ? bucket.name : "<no module>", _TRUNCATE);
+        entry.inlineHooks = bucket.inlineHooks.size();
+        entry.midHooks = bucket.midHooks.size();
+        entry.installMs = bucket.installMs;
+        entry.teardownMs = bucket.teardownMs;
+        entry.loads = bucket.loads;
+        stats.push_back(entry);
+    }
+
+    return stats;
+}
+
+std::vector<HookBatchStats> GetHookBatchStats() {
+    std::lock_guard<std::mutex> lock(g_hookBatchStatsMutex);
+    return g_hookBatchStats;
+}
+
+static void RecordHookBatch(const char* name, size_t hooks, size_t writes, size_t pages, double ms) {
+    std::lock_guard<std::mutex> lock(g_hookBatchStatsMutex);
+    auto it = std::find_if(g_hookBatchStats.begin(), g_hookBatchStats.end(),
+        [&](const HookBatchStats& stats) { return strcmp(stats.name, name) == 0; });
+
+    if (it == g_hookBatchStats.end()) {
+        HookBatchStats entry{};
+        strncpy_s(entry.name, name, _TRUNCATE);
+        it = g_hookBatchStats.insert(g_hookBatchStats.end(), entry);
+    }
+
+    it->hooks += hooks;
+    it->writes += writes;
+    it->pages += pages;
+    it->commitMs += ms;
+    it->commits++;
+}
+
+void HookBatch::Commit() {
+    if (m_ops.empty())
+        return;
+
+    auto start = std::chrono::steady_clock::now();
+    size_t hooks = 0;
+    size_t writes = 0;
+
+    safetyhook::begin_trap_batch();
+
+    for (auto& op : m_ops) {
+        auto createStart = std::chrono::steady_clock::now();
+
+        switch (op.type) {
+        case OpType::Inline:
+            *op.inlineHook = safetyhook::create_inline(reinterpret_cast<void*>(op.address), op.destination, op.inlineFlags);
+            RegisterHook(std::move(op.inlineHook), createStart);
+            hooks++;
+            break;
+        case OpType::Mid:
+            *op.midHook = safetyhook::create_mid(reinterpret_cast<void*>(op.address), op.midDestination, op.midFlags);
+            RegisterHook(std::move(op.midHook), createStart);
+            hooks++;
+            break;
+        case OpType::Write:
+            safetyhook::trap_batch_unprotect(reinterpret_cast<uint8_t*>(op.address), op.size);
+            op.write();
+            writes++;
+            break;
+        }
+    }
+
+    size_t pages = safetyhook::end_trap_batch();
+    m_ops.clear();
+
+    RecordHookBatch(m_name, hooks, writes, pages, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+}
@@ -1,26 +1,156 @@
 	#pragma once
 	#include <safetyhook.hpp>
 	#include "MemoryMgr.h"
+	#include <chrono>
+	#include <functional>
+
+    // Hooks are kept in one bucket per module owning the hooked address, found once when the hook is created.
+    // Unloading a module then only resets and drops its own bucket. Hooks outside of any module share a bucket
+    // that is only dropped by ResetAllHooks.
+    struct HookModuleStats {
+        uintptr_t begin;
+        uintptr_t end;
+        char name[64];
+        size_t inlineHooks;
+        size_t midHooks;
+        double installMs;   // creating the hooks, summed over every load of the module
+        double teardownMs;  // last unload
+        uint32_t loads;
+    };
+
+    SafetyHookInline* RegisterHook(std::unique_ptr<SafetyHookInline> hook, std::chrono::steady_clock::time_point createStart);
+    SafetyHookMid* RegisterHook(std::unique_ptr<SafetyHookMid> hook, std::chrono::steady_clock::time_point createStart);
+
+    // returns how many hooks the module had
+    size_t UnloadModuleHooks(HMODULE module);
+    void ResetAllHooks();
+
+    std::vector<HookModuleStats> GetHookModuleStats();
+
+    // HookBatch commits by batch name, summed over every commit (a module's batch commits again on each load)
+    struct HookBatchStats {
+        char name[64];
+        size_t hooks;
+        size_t writes;
+        size_t pages;
+        double commitMs;
+        uint32_t commits;
+    };
+
+    std::vector<HookBatchStats> GetHookBatchStats();
 
-	extern std::vector<std::unique_ptr<SafetyHookInline>> g_inlineHooks;
-	extern std::vector<std::unique_ptr<SafetyHookMid>> g_midHooks;
     // Define the templates HERE in the header
     template<typename T, typename Fn>
     SafetyHookInline* CreateInlineHook(T target, Fn destination, SafetyHookInline::Flags flags = SafetyHookInline::Default) {
         if (!target)
             return NULL;
+        auto start = std::chrono::steady_clock::now();
         auto hook = std::make_unique<SafetyHookInline>(safetyhook::create_inline(target, destination, flags));
-        auto* ptr = hook.get();
-        g_inlineHooks.push_back(std::move(hook));
-        return ptr;
+        return RegisterHook(std::move(hook), start);
     }
 
     template<typename T>
     SafetyHookMid* CreateMidHook(T target, safetyhook::MidHookFn destination, safetyhook::MidHook::Flags flags = safetyhook::MidHook::Default) {
         if (!target)
             return NULL;
+        auto start = std::chrono::steady_clock::now();
         auto hook = std::make_unique<SafetyHookMid>(safetyhook::create_mid(target, destination, flags));
-        auto* ptr = hook.get();
-        g_midHooks.push_back(std::move(hook));
-        return ptr;
-    }
\ No newline at end of file
+        return RegisterHook(std::move(hook), start);
+    }
+
+
+    // Queues hooks and Memory patches and installs them together in Commit(), in the order they were queued, inside
+    // one safetyhook trap batch: every page changes protection once and other threads are held off for one window
+    // instead of once per hook. The hook pointers are handed out right away but only hold a hook after Commit().
+    // Nothing queued runs before Commit(), so reads of patched memory (Memory::VP::Read etc.) see the old bytes.
+    class HookBatch {
+    public:
+        explicit HookBatch(const char* name) : m_name(name) {}
+        ~HookBatch() { Commit(); }
+
+        HookBatch(const HookBatch&) = delete;
+        HookBatch& operator=(const HookBatch&) = delete;
+
+        template<typename T, typename Fn>
+        SafetyHookInline* Inline(T target, Fn destination, SafetyHookInline::Flags flags = SafetyHookInline::Default) {
+            if (!target)
+                return NULL;
+            auto& op = Queue(OpType::Inline, (uintptr_t)target, 5);
+            op.destination = reinterpret_cast<void*>(destination);
+            op.inlineFlags = flags;
+            op.inlineHook = std::make_unique<SafetyHookInline>();
+            return op.inlineHook.get();
+        }
+
+        template<typename T>
+        SafetyHookMid* Mid(T target, safetyhook::MidHookFn destination, safetyhook::MidHook::Flags flags = safetyhook::MidHook::Default) {
+            if (!target)
+                return NULL;
+            auto& op = Queue(OpType::Mid, (uintptr_t)target, 5);
+            op.midDestination = destination;
+            op.midFlags = flags;
+            op.midHook = std::make_unique<SafetyHookMid>();
+            return op.midHook.get();
+        }
+
+        // same as the Memory::VP functions
+        template<typename T, typename AT>
+        void Patch(AT address, T value) {
+            QueueWrite((uintptr_t)address, sizeof(T), [=] { Memory::Patch(address, value); });
+        }
+
+        template<typename AT>
+        void Nop(AT address, size_t count) {
+            QueueWrite((uintptr_t)address, count, [=] { Memory::Nop(address, count); });
+        }
+
+        template<typename AT, typename Func>
+        void InjectHook(AT address, Func hook) {
+            QueueWrite((uintptr_t)address, 5, [=] { Memory::InjectHook(address, hook); });
+        }
+
+        template<typename AT, typename Func>
+        void InjectHook(AT address, Func hook, Memory::VP::HookType type) {
+            QueueWrite((uintptr_t)address, 5, [=] { Memory::InjectHook(address, hook, static_cast<Memory::HookType>(type)); });
+        }
+
+        template<typename AT, typename Func, typename Hook>
+        void InterceptCall(AT address, Func& func, Hook hook) {
+            QueueWrite((uintptr_t)address, 5, [=, &func] { Memory::InterceptCall(address, func, hook); });
+        }
+
+        void Commit();
+
+    private:
+        enum class OpType { Inline, Mid, Write };
+
+        struct Op {
+            OpType type;
+            uintptr_t address;
+            size_t size;
+            void* destination = nullptr;
+            SafetyHookInline::Flags inlineFlags = SafetyHookInline::Default;
+            std::unique_ptr<SafetyHookInline> inlineHook;
+            safetyhook::MidHookFn midDestination = nullptr;
+            safetyhook::MidHook::Flags midFlags = safetyhook::MidHook::Default;
+            std::unique_ptr<SafetyHookMid> midHook;
+            std::function<void()> write;
+        };
+
+        Op& Queue(OpType type, uintptr_t address, size_t size) {
+            auto& op = m_ops.emplace_back();
+            op.type = type;
+            op.address = address;
+            op.size = size;
+            return op;
+        }
+
+        void QueueWrite(uintptr_t address, size_t size, std::function<void()> write) {
+            if (!address)
+                return;
+            Queue(OpType::Write, address, size).write = std::move(write);
+        }
+
+        const char* m_name;
+        std::vector<Op> m_ops;
+    };
@@ -0,0 +1,76 @@
+#include "..\framework.h"
+#include <game.h>
+#include "hookstats.h"
+#include "common.h"
+
+#ifdef YAP_HOOKSTATS
+#include <algorithm>
+#include <vector>
+
+namespace {
+    HookStat* g_hookStats = nullptr;
+
+    // rdtsc and QPC at the first registration, to convert ticks to time at dump time
+    uint64_t g_calibrationTicks = 0;
+    LARGE_INTEGER g_calibrationCounter{};
+
+    double TicksPerMicrosecond() {
+        LARGE_INTEGER now, frequency;
+        uint64_t ticks = __rdtsc();
+        QueryPerformanceCounter(&now);
+        QueryPerformanceFrequency(&frequency);
+
+        double us = double(now.QuadPart - g_calibrationCounter.QuadPart) * 1000000.0 / double(frequency.QuadPart);
+        return us > 0.0 ? double(ticks - g_calibrationTicks) / us : 1.0;
+    }
+}
+
+HookStat::HookStat(const char* name) : name(name) {
+    if (!g_hookStats) {
+        g_calibrationTicks = __rdtsc();
+        QueryPerformanceCounter(&g_calibrationCounter);
+    }
+
+    next = g_hookStats;
+    g_hookStats = this;
+}
+
+void HookStats_Dump() {
+    std::vector<HookStat*> stats;
+    for (auto* stat = g_hookStats; stat; stat = stat->next) {
+        stats.push_back(stat);
+    }
+
+    std::sort(stats.begin(), stats.end(), [](const HookStat* a, const HookStat* b) { return a->totalTicks > b->totalTicks; });
+
+    const double ticksPerUs = TicksPerMicrosecond();
+
+    std::wstring path = GetCurrentModuleName();
+    path.resize(path.find_last_of(L"/\\") + 1);
+    path += L"yap_hookstats.csv";
+
+    FILE* csv = _wfopen(path.c_str(), L"w");
+    if (csv)
+        fprintf(csv, "hook,calls,total_ms,avg_us,max_us\n");
+
+    Com_Printf("%-32s %10s %10s %10s %10s\n", "hook", "calls", "total ms", "avg us", "max us");
+    for (auto* stat : stats) {
+        double totalUs = stat->totalTicks / ticksPerUs;
+        double avgUs = stat->calls ? totalUs / stat->calls : 0.0;
+        double maxUs = stat->maxTicks / ticksPerUs;
+
+        Com_Printf("%-32s %10llu %10.3f %10.3f %10.3f\n", stat->name, stat->calls, totalUs / 1000.0, avgUs, maxUs);
+        if (csv)
+            fprintf(csv, "%s,%llu,%.3f,%.3f,%.3f\n", stat->name, stat->calls, totalUs / 1000.0, avgUs, maxUs);
+
+        stat->calls = 0;
+        stat->totalTicks = 0;
+        stat->maxTicks = 0;
+    }
+
+    if (csv) {
+        fclose(csv);
+        Com_Printf("wrote %ls\n", path.c_str());
+    }
+}
+#endif
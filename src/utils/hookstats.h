@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+
+// Opt-in call counts and timings for hooks. Build with YAP_HOOKSTATS defined to enable it, HOOK_STATS("name") at
+// the top of a hook body then times the rest of that scope with rdtsc and yap_hookstats prints the table.
+// Without YAP_HOOKSTATS the macro expands to nothing.
+#ifdef YAP_HOOKSTATS
+#include <intrin.h>
+
+struct HookStat {
+    const char* name;
+    uint64_t calls = 0;
+    uint64_t totalTicks = 0;
+    uint64_t maxTicks = 0;
+    HookStat* next = nullptr;
+
+    explicit HookStat(const char* name);
+};
+
+class HookStatScope {
+    HookStat& m_stat;
+    uint64_t m_start;
+
+public:
+    explicit HookStatScope(HookStat& stat) : m_stat(stat), m_start(__rdtsc()) {}
+
+    ~HookStatScope() {
+        uint64_t ticks = __rdtsc() - m_start;
+        m_stat.calls++;
+        m_stat.totalTicks += ticks;
+        if (ticks > m_stat.maxTicks)
+            m_stat.maxTicks = ticks;
+    }
+};
+
+// prints the stats sorted by total time, writes them to yap_hookstats.csv next to the plugin and resets them
+void HookStats_Dump();
+
+#define HOOK_STATS_CONCAT_(a, b) a##b
+#define HOOK_STATS_CONCAT(a, b) HOOK_STATS_CONCAT_(a, b)
+#define HOOK_STATS(name) \
+    static HookStat HOOK_STATS_CONCAT(hookStat_, __LINE__){ name }; \
+    HookStatScope HOOK_STATS_CONCAT(hookStatScope_, __LINE__){ HOOK_STATS_CONCAT(hookStat_, __LINE__) }
+#else
+#define HOOK_STATS(name)
+#endif
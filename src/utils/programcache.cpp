@@ -0,0 +1,246 @@
+#include "programcache.h"
+#include "hash.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <system_error>
+
+// File layout, little-endian: program_cache_file_header, the driver string, then per entry a
+// program_cache_file_entry followed by its key, fragment source and binary. A FNV-1a of everything before it ends
+// the file.
+struct program_cache_file_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t driverLength;
+    uint32_t entryCount;
+};
+
+struct program_cache_file_entry {
+    uint64_t hash;
+    uint32_t keyLength;
+    uint32_t sourceLength;
+    uint32_t binaryFormat;
+    uint32_t binaryLength;
+    float linkMs;
+    uint32_t _pad;
+};
+
+static_assert(sizeof(program_cache_file_header) == 16, "program_cache_file_header layout is part of the file format");
+static_assert(sizeof(program_cache_file_entry) == 32, "program_cache_file_entry layout is part of the file format");
+
+// Bounds checked reads out of the loaded file
+class program_cache_cursor {
+public:
+    program_cache_cursor(const std::vector<uint8_t>& data, size_t end) : m_data(data), m_end(end) {}
+
+    template <typename T>
+    bool read(T& value) {
+        if (sizeof(T) > m_end - m_pos)
+            return false;
+        memcpy(&value, m_data.data() + m_pos, sizeof(T));
+        m_pos += sizeof(T);
+        return true;
+    }
+
+    bool read(std::string& text, uint32_t length) {
+        if (length > m_end - m_pos)
+            return false;
+        text.assign(reinterpret_cast<const char*>(m_data.data() + m_pos), length);
+        m_pos += length;
+        return true;
+    }
+
+    bool read(std::vector<uint8_t>& bytes, uint32_t length) {
+        if (length > m_end - m_pos)
+            return false;
+        bytes.assign(m_data.begin() + m_pos, m_data.begin() + m_pos + length);
+        m_pos += length;
+        return true;
+    }
+
+    bool at_end() const { return m_pos == m_end; }
+
+private:
+    const std::vector<uint8_t>& m_data;
+    size_t m_end;
+    size_t m_pos = 0;
+};
+
+bool program_cache::open(const std::filesystem::path& file, std::string_view driver, std::string& error) {
+    close();
+    m_open = true;
+    m_file = file;
+    m_driver = driver;
+
+    std::ifstream in(file, std::ios::binary);
+    if (!in) {
+        error = "no cache file";
+        return false;
+    }
+
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (data.size() < sizeof(program_cache_file_header) + sizeof(uint64_t)) {
+        error = "file too small";
+        return false;
+    }
+
+    size_t end = data.size() - sizeof(uint64_t);
+    uint64_t checksum;
+    memcpy(&checksum, data.data() + end, sizeof(checksum));
+    if (Hash_FNV1a64(data.data(), end) != checksum) {
+        error = "checksum mismatch";
+        return false;
+    }
+
+    program_cache_cursor cursor(data, end);
+    program_cache_file_header header;
+    std::string fileDriver;
+
+    if (!cursor.read(header) || header.magic != PROGRAM_CACHE_MAGIC || header.version != PROGRAM_CACHE_VERSION) {
+        error = "not a cache file or a different version";
+        return false;
+    }
+
+    if (!cursor.read(fileDriver, header.driverLength)) {
+        error = "truncated or malformed";
+        return false;
+    }
+
+    if (fileDriver != driver) {
+        error = "written for a different driver";
+        return false;
+    }
+
+    std::unordered_map<uint64_t, program_cache_entry> entries;
+    for (uint32_t i = 0; i < header.entryCount; i++) {
+        program_cache_file_entry record;
+        program_cache_entry entry;
+
+        if (!cursor.read(record) ||
+            !cursor.read(entry.key, record.keyLength) ||
+            !cursor.read(entry.fragmentSource, record.sourceLength) ||
+            !cursor.read(entry.binary, record.binaryLength)) {
+            error = "truncated or malformed";
+            return false;
+        }
+
+        entry.binaryFormat = record.binaryFormat;
+        entry.linkMs = record.linkMs;
+        entries[record.hash] = std::move(entry);
+    }
+
+    if (!cursor.at_end()) {
+        error = "truncated or malformed";
+        return false;
+    }
+
+    m_entries = std::move(entries);
+    return true;
+}
+
+void program_cache::close() {
+    m_open = false;
+    m_dirty = false;
+    m_file.clear();
+    m_driver.clear();
+    m_entries.clear();
+}
+
+const program_cache_entry* program_cache::find(uint64_t hash, std::string_view key) const {
+    auto it = m_entries.find(hash);
+    if (it == m_entries.end() || it->second.key != key)
+        return nullptr;
+    return &it->second;
+}
+
+bool program_cache::store(uint64_t hash, program_cache_entry entry) {
+    if (!m_open)
+        return false;
+
+    m_entries[hash] = std::move(entry);
+    m_stats.stored++;
+    m_dirty = true;
+    return true;
+}
+
+bool program_cache::remove(uint64_t hash) {
+    if (!m_open || !m_entries.erase(hash))
+        return false;
+    m_dirty = true;
+    return true;
+}
+
+bool program_cache::flush() {
+    if (!m_open || !m_dirty)
+        return true;
+
+    if (!write())
+        return false;
+
+    m_dirty = false;
+    return true;
+}
+
+void program_cache::record_hit(const program_cache_entry& entry, double loadMs) {
+    m_stats.hits++;
+    m_stats.loadMs += loadMs;
+    m_stats.savedMs += std::max(0.0, entry.linkMs - loadMs);
+}
+
+bool program_cache::write() const {
+    std::vector<uint8_t> data;
+
+    auto append = [&data](const void* bytes, size_t size) {
+        data.insert(data.end(), static_cast<const uint8_t*>(bytes), static_cast<const uint8_t*>(bytes) + size);
+    };
+
+    program_cache_file_header header{ PROGRAM_CACHE_MAGIC, PROGRAM_CACHE_VERSION, (uint32_t)m_driver.size(), (uint32_t)m_entries.size() };
+    append(&header, sizeof(header));
+    append(m_driver.data(), m_driver.size());
+
+    // in hash order so rewriting an unchanged cache gives the same file
+    std::vector<uint64_t> hashes;
+    hashes.reserve(m_entries.size());
+    for (const auto& [hash, entry] : m_entries)
+        hashes.push_back(hash);
+    std::sort(hashes.begin(), hashes.end());
+
+    for (uint64_t hash : hashes) {
+        const program_cache_entry& entry = m_entries.at(hash);
+
+        program_cache_file_entry record{};
+        record.hash = hash;
+        record.keyLength = (uint32_t)entry.key.size();
+        record.sourceLength = (uint32_t)entry.fragmentSource.size();
+        record.binaryFormat = entry.binaryFormat;
+        record.binaryLength = (uint32_t)entry.binary.size();
+        record.linkMs = entry.linkMs;
+
+        append(&record, sizeof(record));
+        append(entry.key.data(), entry.key.size());
+        append(entry.fragmentSource.data(), entry.fragmentSource.size());
+        append(entry.binary.data(), entry.binary.size());
+    }
+
+    uint64_t checksum = Hash_FNV1a64(data.data(), data.size());
+    append(&checksum, sizeof(checksum));
+
+    std::filesystem::path temp = m_file;
+    temp += ".tmp";
+
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        if (!out.write(reinterpret_cast<const char*>(data.data()), data.size()))
+            return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temp, m_file, ec);
+    if (ec) {
+        std::filesystem::remove(temp, ec);
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// On-disk cache of linked GL programs (GL_ARB_get_program_binary) for the ATI fragment shader wrapper. Each entry is
+// found by a 64-bit hash and confirmed with the full key it was computed from (the flattened ATI instruction stream,
+// the sources for fixed shaders). It also keeps the GLSL it was linked from, so a binary the driver rejects only costs
+// the compile and not the translation.
+//
+// Binaries are only valid for the driver that produced them: the file records the GL vendor, renderer and version
+// strings (plus the plugin build, which decides the GLSL) and is ignored when they differ. Stores only mark the cache
+// dirty, flush() writes the file once registration is over. No GL calls in here, opengl_ati_frag.cpp retrieves and loads the binaries.
+
+constexpr uint32_t PROGRAM_CACHE_MAGIC = 0x47504159; // "YAPG"
+constexpr uint32_t PROGRAM_CACHE_VERSION = 2;
+
+struct program_cache_entry {
+    std::string key;
+    std::string fragmentSource;
+    uint32_t binaryFormat = 0;
+    std::vector<uint8_t> binary;
+    float linkMs = 0.f;         // what compiling and linking from source took
+};
+
+struct program_cache_stats {
+    uint32_t hits = 0;          // linked from a cached binary
+    uint32_t misses = 0;        // nothing cached, compiled from source
+    uint32_t rejected = 0;      // the driver refused a cached binary
+    uint32_t stored = 0;
+    double loadMs = 0.0;        // spent loading cached binaries
+    double savedMs = 0.0;       // recorded link times of the hits minus loadMs
+};
+
+class program_cache {
+public:
+    // Reads 'file' if it was written for 'driver', starts empty otherwise. 'error' says why nothing was loaded.
+    bool open(const std::filesystem::path& file, std::string_view driver, std::string& error);
+    void close();
+
+    bool is_open() const { return m_open; }
+    size_t size() const { return m_entries.size(); }
+
+    const program_cache_entry* find(uint64_t hash, std::string_view key) const;
+
+    // Replaces the entry for 'hash', written by the next flush()
+    bool store(uint64_t hash, program_cache_entry entry);
+    bool remove(uint64_t hash);
+
+    // Rewrites the file if anything changed since it was read or last flushed
+    bool flush();
+    bool is_dirty() const { return m_dirty; }
+
+    void record_hit(const program_cache_entry& entry, double loadMs);
+    void record_miss() { m_stats.misses++; }
+    void record_reject() { m_stats.rejected++; }
+    const program_cache_stats& stats() const { return m_stats; }
+
+private:
+    bool write() const;
+
+    bool m_open = false;
+    bool m_dirty = false;
+    std::filesystem::path m_file;
+    std::string m_driver;
+    std::unordered_map<uint64_t, program_cache_entry> m_entries;
+    program_cache_stats m_stats;
+};
@@ -4,6 +4,9 @@
 #include "cevar.h"
 #include <Hooking.Patterns.h>
 #include "utils/hooking.h"
+#include "utils/hookstats.h"
+#include "utils/configcache.h"
+#include "utils/common.h"
 
 #include <filesystem>
 #include <fstream>
@@ -38,9 +41,20 @@ namespace weapon {
 
     std::unordered_map<std::string, eWeaponDef> g_eWeaponDefs;
 
+    // read by the sprint hooks every frame, bound in post_unpack
+    struct alignas(64) sprint_cvar_views {
+        cevar_view<int> weaponSprintMod;
+        cevar_view<float> weaponSprintModValue;
+        cevar_view<float> weaponBobSprintHorz;
+        cevar_view<float> weaponBobSprintVert;
+        cevar_view<float> bobSprintHorz;
+        cevar_view<float> bobSprintVert;
+        cevar_view<float> sprintSpeedScale;
+    } g_sprintViews;
+
 
     bool sprint_rotate_is_sprinting() {
-        return (player_flags && (*player_flags & 0x10000) != 0) && (cg_weaponSprint_mod && cg_weaponSprint_mod->base->integer);
+        return (player_flags && (*player_flags & 0x10000) != 0) && g_sprintViews.weaponSprintMod;
     }
 
     const char* GetCurrentWeaponName() {
@@ -95,7 +109,7 @@ namespace weapon {
             if (weaponName) {
                 auto eWeapon = GetEWeapon(weaponName);
                 if (eWeapon) {
-                    float vert_bob = cg_weaponBobAmplitudeSprinting_vert->base->value * eWeapon->vSprintBob[1];
+                    float vert_bob = g_sprintViews.weaponBobSprintVert * eWeapon->vSprintBob[1];
                     v3 = vert_bob;
                 }
             }
@@ -130,7 +144,7 @@ namespace weapon {
         }
 
         if (sprint_rotate_is_sprinting()) {
-            v3 = cg_bobAmplitudeSprinting_vert->base->value;
+            v3 = g_sprintViews.bobSprintVert;
         }
 
         v4 = v3 * a2;
@@ -162,7 +176,7 @@ namespace weapon {
         }
 
         if (sprint_rotate_is_sprinting()) {
-            v3 = cg_bobAmplitudeSprinting_horz->base->value;
+            v3 = g_sprintViews.bobSprintHorz;
         }
 
         v4 = v3 * a2;
@@ -191,13 +205,13 @@ namespace weapon {
         if (!sp_mp(1))
             return;
 
-        auto pattern = hook::pattern(handle, "A1 ? ? ? ? A9 ? ? ? ? 0F 84");
+        auto pattern = hook::pattern(handle, "A1 ? ? ? ? A9 ? ? ? ? 0F 84"_sig);
 
         if (!pattern.empty()) {
             player_flags = *pattern.get_first<uint32_t*>(1);
         }
 
-        pattern = hook::pattern(handle, "? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? EB ? C7 44 24 ? 00 00 00 00 C7 44 24 ? 00 00 00 00 C7 44 24 ? 00 00 00 00 ? ? 5B");
+        pattern = hook::pattern(handle, "? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? EB ? C7 44 24 ? 00 00 00 00 C7 44 24 ? 00 00 00 00 C7 44 24 ? 00 00 00 00 ? ? 5B"_sig);
 
         //sprint_cevar_assembly(NULL, "hi");
         DWORD old_protect = 0;
@@ -235,6 +249,7 @@ namespace weapon {
         Memory::VP::Nop((void*)cg(0x30031E10), 6);
 
         CreateMidHook(cg(0x30031DF0), [](SafetyHookContext& ctx) {
+            HOOK_STATS("SprintT4_lol gun_rot_p");
             vmCvar_t* cg_gun_rot_p = (vmCvar_t*)cg(0x30258E60);
             vector3* game_sprint_rot = (vector3*)(ctx.edx + 0x128);
             auto eWeapon = GetCurrentEWeapon();
@@ -253,6 +268,7 @@ namespace weapon {
             });
 
         CreateMidHook(cg(0x30031DFE), [](SafetyHookContext& ctx) {
+            HOOK_STATS("SprintT4_lol gun_rot_y");
             vmCvar_t* cg_gun_rot_y = (vmCvar_t*)cg(0x30256CA0);
             vector3* game_sprint_rot = (vector3*)(ctx.edx + 0x128);
             auto eWeapon = GetCurrentEWeapon();
@@ -271,6 +287,7 @@ namespace weapon {
             });
 
         CreateMidHook(cg(0x30031E10), [](SafetyHookContext& ctx) {
+            HOOK_STATS("SprintT4_lol gun_rot_r");
             vmCvar_t* cg_gun_rot_r = (vmCvar_t*)cg(0x30252A40);
 
             vector3* game_sprint_rot = (vector3*)(ctx.edx + 0x128);
@@ -295,8 +312,8 @@ namespace weapon {
                 const char* weaponName = GetCurrentWeaponName();
                 if (weaponName) {
                     auto eWeapon = GetEWeapon(weaponName);
-                    if (eWeapon && cg_weaponSprint_mod->base->value) {
-                        float horz_bob = cg_weaponBobAmplitudeSprinting_horz->base->value * eWeapon->vSprintBob[0];
+                    if (eWeapon && g_sprintViews.weaponSprintModValue) {
+                        float horz_bob = g_sprintViews.weaponBobSprintHorz * eWeapon->vSprintBob[0];
                         //printf("horz_bob %f\n", horz_bob);
                         FPU::FLD(horz_bob);
                         ctx.eip = cg(0x30031054);
@@ -314,7 +331,7 @@ namespace weapon {
             vector3* game_sprintMove = (vector3*)(ctx.edx + 0x11C);
 
             auto eWeapon = GetCurrentEWeapon();
-            if (eWeapon && eWeapon->vSprintMove && eWeapon->vSprintMove.has_value() && cg_weaponSprint_mod->base->value) {
+            if (eWeapon && eWeapon->vSprintMove && eWeapon->vSprintMove.has_value() && g_sprintViews.weaponSprintModValue) {
                 FPU::FMUL((*eWeapon->vSprintMove)[0]);
                 return;
             }
@@ -326,7 +343,7 @@ namespace weapon {
             vector3* game_sprintMove = (vector3*)(ctx.edx + 0x11C);
 
             auto eWeapon = GetCurrentEWeapon();
-            if (eWeapon && eWeapon->vSprintMove && eWeapon->vSprintMove.has_value() && cg_weaponSprint_mod->base->value) {
+            if (eWeapon && eWeapon->vSprintMove && eWeapon->vSprintMove.has_value() && g_sprintViews.weaponSprintModValue) {
                 FPU::FMUL((*eWeapon->vSprintMove)[1]);
                 return;
             }
@@ -339,7 +356,7 @@ namespace weapon {
 
 
             auto eWeapon = GetCurrentEWeapon();
-            if (eWeapon && eWeapon->vSprintMove && eWeapon->vSprintMove.has_value() && cg_weaponSprint_mod->base->value) {
+            if (eWeapon && eWeapon->vSprintMove && eWeapon->vSprintMove.has_value() && g_sprintViews.weaponSprintModValue) {
                 FPU::FMUL((*eWeapon->vSprintMove)[2]);
                 return;
             }
@@ -353,21 +370,35 @@ namespace weapon {
     }
 
 
-    void LoadEWeaponsFromDirectory(const std::filesystem::path& eWeaponsDir, bool overwrite = true) {
+    // eWeapons parsed off the game thread, Com_Printf output is kept until the definitions are applied
+    struct eWeaponLoad {
+        std::unordered_map<std::string, eWeaponDef> defs;
+        std::vector<std::string> log;
+        bool complete = true;   // no file failed to parse, only then the result is cached
+    };
+
+    template <typename... Args>
+    void LogEWeapons(eWeaponLoad& load, const char* fmt, Args... args) {
+        char buffer[1024];
+        snprintf(buffer, sizeof(buffer), fmt, args...);
+        load.log.emplace_back(buffer);
+    }
+
+    void LoadEWeaponsFromDirectory(eWeaponLoad& load, const std::filesystem::path& eWeaponsDir, bool overwrite = true) {
         if (!std::filesystem::exists(eWeaponsDir)) {
-            Com_Printf("eWeapons directory not found: %s\n", eWeaponsDir.string().c_str());
+            LogEWeapons(load, "eWeapons directory not found: %s\n", eWeaponsDir.string().c_str());
             return;
         }
 
-        Com_Printf("Loading eWeapons from: %s\n", eWeaponsDir.string().c_str());
+        LogEWeapons(load, "Loading eWeapons from: %s\n", eWeaponsDir.string().c_str());
 
         for (const auto& entry : std::filesystem::directory_iterator(eWeaponsDir)) {
             if (entry.path().extension() != ".json") continue;
 
             std::string weaponName = entry.path().stem().string();
 
-            if (!overwrite && g_eWeaponDefs.find(weaponName) != g_eWeaponDefs.end()) {
-                Com_Printf("Skipping '%s' (already loaded with higher priority)\n", weaponName.c_str());
+            if (!overwrite && load.defs.find(weaponName) != load.defs.end()) {
+                LogEWeapons(load, "Skipping '%s' (already loaded with higher priority)\n", weaponName.c_str());
                 continue;
             }
 
@@ -408,9 +439,9 @@ namespace weapon {
                     };
                 }
 
-                g_eWeaponDefs[weaponName] = weaponDef;
+                load.defs[weaponName] = weaponDef;
 
-                Com_Printf("Loaded eWeapon '%s' - sprintBobH: %.3f, sprintBobV: %.3f, sprintSpeedScale %.3f\n",
+                LogEWeapons(load, "Loaded eWeapon '%s' - sprintBobH: %.3f, sprintBobV: %.3f, sprintSpeedScale %.3f\n",
                     weaponName.c_str(),
                     weaponDef.vSprintBob[0],
                     weaponDef.vSprintBob[1],
@@ -418,57 +449,170 @@ namespace weapon {
 
             }
             catch (const std::exception& e) {
-                Com_Printf("Failed to parse %s: %s\n",
+                LogEWeapons(load, "Failed to parse %s: %s\n",
                     entry.path().string().c_str(), e.what());
+                load.complete = false;
             }
         }
     }
 
-    void loadEWeapons() {
-        if (!sp_mp(1, 0))
-            return;
-        g_eWeaponDefs.clear();
+    std::filesystem::path GetEWeaponsCachePath() {
+        std::wstring path = GetCurrentModuleName();
+        path.resize(path.find_last_of(L"/\\") + 1);
+        return path + TEXT(MOD_NAME) L".eweapons.cache";
+    }
+
+    bool ReadEWeaponsCache(eWeaponLoad& load, const std::filesystem::path& cachePath, const std::vector<config_cache_source>& sources) {
+        config_cache_reader cache;
+        std::string error;
+        if (!cache.open(cachePath, config_cache_kind::eweapons, sizeof(eweapon_cache_record), sources, error)) {
+            LogEWeapons(load, "eWeapons cache not used: %s\n", error.c_str());
+            return false;
+        }
+
+        for (size_t i = 0; i < cache.header().recordCount; i++) {
+            const auto& record = cache.record<eweapon_cache_record>(i);
+
+            eWeaponDef weaponDef;
+            weaponDef.weaponName = cache.string(record.name);
+            weaponDef.vSprintBob[0] = record.sprintBob[0];
+            weaponDef.vSprintBob[1] = record.sprintBob[1];
+            weaponDef.sprintSpeedScale = record.sprintSpeedScale;
+
+            if (record.hasSprintRot)
+                weaponDef.vSprintRot = std::array<float, 3>{ record.sprintRot[0], record.sprintRot[1], record.sprintRot[2] };
+
+            if (record.hasSprintMove)
+                weaponDef.vSprintMove = std::array<float, 3>{ record.sprintMove[0], record.sprintMove[1], record.sprintMove[2] };
+
+            load.defs[weaponDef.weaponName] = weaponDef;
+        }
+
+        return true;
+    }
+
+    void WriteEWeaponsCache(eWeaponLoad& load, const std::filesystem::path& cachePath, std::vector<config_cache_source>&& sources) {
+        config_cache_writer cache(config_cache_kind::eweapons, sizeof(eweapon_cache_record));
+
+        for (const auto& [name, weaponDef] : load.defs) {
+            eweapon_cache_record record{};
+            record.name = cache.add_string(name);
+            record.sprintBob[0] = weaponDef.vSprintBob[0];
+            record.sprintBob[1] = weaponDef.vSprintBob[1];
+            record.sprintSpeedScale = weaponDef.sprintSpeedScale;
+
+            if (weaponDef.vSprintRot) {
+                record.hasSprintRot = 1;
+                std::copy(weaponDef.vSprintRot->begin(), weaponDef.vSprintRot->end(), record.sprintRot);
+            }
+
+            if (weaponDef.vSprintMove) {
+                record.hasSprintMove = 1;
+                std::copy(weaponDef.vSprintMove->begin(), weaponDef.vSprintMove->end(), record.sprintMove);
+            }
+
+            cache.add_record(&record);
+        }
+
+        if (!cache.write(cachePath, std::move(sources)))
+            LogEWeapons(load, "Failed to write eWeapons cache %s\n", cachePath.string().c_str());
+    }
+
+    struct eWeaponGameDirs {
+        std::string fsGame;
+        std::string fsBaseGame;
+    };
+
+    // Game thread only, the engine's cvar list isn't locked
+    eWeaponGameDirs GetEWeaponGameDirs() {
+        eWeaponGameDirs dirs;
+        cvar_s* fs_game = Cvar_Find("fs_game");
+        cvar_s* fs_basegame = Cvar_Find("fs_basegame");
+
+        if (fs_game && fs_game->string)
+            dirs.fsGame = fs_game->string;
+        if (fs_basegame && fs_basegame->string)
+            dirs.fsBaseGame = fs_basegame->string;
+        return dirs;
+    }
+
+    // Touches neither g_eWeaponDefs nor the cvars, safe to run from component prepare() with the game dirs gathered
+    // before
+    eWeaponLoad ParseEWeapons(const eWeaponGameDirs& gameDirs) {
+        eWeaponLoad load;
         char modulePath[MAX_PATH];
         GetModuleFileNameA(NULL, modulePath, MAX_PATH);
         std::filesystem::path exePath(modulePath);
         std::filesystem::path baseDir = exePath.parent_path();
-        cvar_s* fs_game = Cvar_Find("fs_game");
-        cvar_s* fs_basegame = Cvar_Find("fs_basegame");
 
-        std::filesystem::path baseEWeaponsDir = baseDir / "eWeapons";
-        LoadEWeaponsFromDirectory(baseEWeaponsDir, true);
+        // later directories override earlier ones
+        std::vector<std::filesystem::path> eWeaponsDirs{ baseDir / "eWeapons" };
+
+        if (!gameDirs.fsBaseGame.empty()) {
+            eWeaponsDirs.push_back(baseDir / gameDirs.fsBaseGame / "eWeapons");
+        }
+
+        bool hasFsGame = !gameDirs.fsGame.empty();
+        if (hasFsGame) {
+            eWeaponsDirs.push_back(baseDir / gameDirs.fsGame / "eWeapons");
+        }
+
+        // stat-only, taken before parsing so files edited meanwhile aren't cached
+        std::vector<config_cache_source> sources = ConfigCache_Snapshot(eWeaponsDirs);
+        std::filesystem::path cachePath = GetEWeaponsCachePath();
+
+        if (ReadEWeaponsCache(load, cachePath, sources)) {
+            LogEWeapons(load, "Loaded %d eWeapon definitions from %s\n",
+                load.defs.size(),
+                cachePath.string().c_str());
+            return load;
+        }
 
-        if (fs_basegame && fs_basegame->string && fs_basegame->string[0] != '\0') {
-            std::filesystem::path fsBaseGameDir = baseDir / fs_basegame->string;
-            std::filesystem::path fsBaseGameEWeaponsDir = fsBaseGameDir / "eWeapons";
-            LoadEWeaponsFromDirectory(fsBaseGameEWeaponsDir, true);
+        for (const auto& eWeaponsDir : eWeaponsDirs) {
+            LoadEWeaponsFromDirectory(load, eWeaponsDir, true);
         }
 
-        if (fs_game && fs_game->string && fs_game->string[0] != '\0') {
-            std::filesystem::path fsGameDir = baseDir / fs_game->string;
-            std::filesystem::path fsGameEWeaponsDir = fsGameDir / "eWeapons";
-            LoadEWeaponsFromDirectory(fsGameEWeaponsDir, true);
-            Com_Printf("Loaded %d eWeapon definitions (fs_game: '%s' has priority)\n",
-                g_eWeaponDefs.size(),
-                fs_game->string);
+        if (hasFsGame) {
+            LogEWeapons(load, "Loaded %d eWeapon definitions (fs_game: '%s' has priority)\n",
+                load.defs.size(),
+                gameDirs.fsGame.c_str());
         }
         else {
-            Com_Printf("Loaded %d eWeapon definitions from base directory\n",
-                g_eWeaponDefs.size());
+            LogEWeapons(load, "Loaded %d eWeapon definitions from base directory\n",
+                load.defs.size());
         }
+
+        if (load.complete)
+            WriteEWeaponsCache(load, cachePath, std::move(sources));
+
+        return load;
+    }
+
+    void ApplyEWeapons(eWeaponLoad&& load) {
+        for (const auto& line : load.log) {
+            Com_Printf("%s", line.c_str());
+        }
+
+        g_eWeaponDefs = std::move(load.defs);
+    }
+
+    void loadEWeapons() {
+        if (!sp_mp(1, 0))
+            return;
+        ApplyEWeapons(ParseEWeapons(GetEWeaponGameDirs()));
     }
 
     void PatchSprintScale(HMODULE handle) {
         if (!sp_mp(1))
             return;
-        auto pattern = hook::pattern(handle, "? ? ? ? ? ? EB ? ? ? ? ? ? ? EB ? ? ? ? ? ? ? 8B 46");
+        auto pattern = hook::pattern(handle, "? ? ? ? ? ? EB ? ? ? ? ? ? ? EB ? ? ? ? ? ? ? 8B 46"_sig);
         if (!pattern.empty() && player_sprintSpeedScale && player_sprintSpeedScale->base) {
 
 
             Memory::VP::Nop(pattern.get_first(), 6);
             CreateMidHook(pattern.get_first(), [](SafetyHookContext& ctx) {
 
-                float current_speedscale = player_sprintSpeedScale->base->value;
+                float current_speedscale = g_sprintViews.sprintSpeedScale;
                 auto eWeapon = GetCurrentEWeapon();
                 if (eWeapon) {
                     current_speedscale *= eWeapon->sprintSpeedScale;
@@ -492,7 +636,7 @@ namespace weapon {
     void PatchJumpShot(HMODULE handle) {
         if (!sp_mp(1))
             return;
-        auto pattern = hook::pattern(handle, "0F 85 ? ? ? ? 8B 0D ? ? ? ? 8B 90");
+        auto pattern = hook::pattern(handle, "0F 85 ? ? ? ? 8B 0D ? ? ? ? 8B 90"_sig);
         if (!pattern.empty()) {
 
             CreateMidHook(pattern.get_first(), [](SafetyHookContext& ctx) {
@@ -532,7 +676,41 @@ namespace weapon {
 
     class component final : public component_interface
     {
+        // scanned and parsed by prepare(), ahead of post_cgame
+        void* anim_loop = nullptr;
+        void* anim_syscall = nullptr;
+        void* anim_loop_end = nullptr;
+        std::optional<eWeaponLoad> eWeapons;
+        eWeaponGameDirs eWeaponDirs;    // read by gather(), prepare() runs off the game thread
+
     public:
+        bool is_scan_phase(component_phase phase) override
+        {
+            return phase == component_phase::post_cgame;
+        }
+
+        void gather(component_phase) override
+        {
+            if (sp_mp(1))
+                eWeaponDirs = GetEWeaponGameDirs();
+        }
+
+        void prepare(component_phase) override
+        {
+            auto pattern = hook::pattern((HMODULE)cg_game_offset, "74 ? 43 83 FB"_sig);
+            anim_loop = pattern.empty() ? nullptr : pattern.get_first();
+
+            pattern = hook::pattern((HMODULE)cg_game_offset, "FF 15 ? ? ? ? 83 C4 ? 46 83 C7"_sig);
+            anim_syscall = pattern.empty() ? nullptr : pattern.get_first();
+
+            pattern = hook::pattern((HMODULE)cg_game_offset, "75 ? 5F 5E 5D 83 C4"_sig);
+            anim_loop_end = pattern.empty() ? nullptr : pattern.get_first();
+
+            eWeapons.reset();
+            if (sp_mp(1))
+                eWeapons = ParseEWeapons(eWeaponDirs);
+        }
+
         void post_unpack() override
         {
             yap_xanim_iw3_transitionTime = Cevar_Get("yap_xanim_iw3_transitionTime", 0.5f, CVAR_ARCHIVE, 0.f, 1.f);
@@ -551,6 +729,14 @@ namespace weapon {
 
                 game::Cmd_AddCommand("reload_eweapons", loadEWeapons);
 
+                Cevar_BindView(g_sprintViews.weaponSprintMod, cg_weaponSprint_mod, 0);
+                Cevar_BindView(g_sprintViews.weaponSprintModValue, cg_weaponSprint_mod, 0.f);
+                Cevar_BindView(g_sprintViews.weaponBobSprintHorz, cg_weaponBobAmplitudeSprinting_horz, 0.f);
+                Cevar_BindView(g_sprintViews.weaponBobSprintVert, cg_weaponBobAmplitudeSprinting_vert, 0.f);
+                Cevar_BindView(g_sprintViews.bobSprintHorz, cg_bobAmplitudeSprinting_horz, 0.f);
+                Cevar_BindView(g_sprintViews.bobSprintVert, cg_bobAmplitudeSprinting_vert, 0.f);
+                Cevar_BindView(g_sprintViews.sprintSpeedScale, player_sprintSpeedScale, 1.f);
+
             }
 
         }
@@ -558,27 +744,22 @@ namespace weapon {
         void post_cgame() override
         {
 
-            auto pattern = hook::pattern((HMODULE)cg_game_offset,"74 ? 43 83 FB");
-            
-            if (!pattern.empty()) {
-                CreateMidHook(pattern.get_first(), [](SafetyHookContext& ctx) {
+            if (anim_loop) {
+                CreateMidHook(anim_loop, [](SafetyHookContext& ctx) {
 
                     if (yap_xanim_iw3_transitionTime->base->value != 0.f)
                         do_transitionTime = true;
 
                     });
 
-                pattern = hook::pattern((HMODULE)cg_game_offset, "FF 15 ? ? ? ? 83 C4 ? 46 83 C7");
-                if (!pattern.empty()) {
-
-                    Memory::VP::Read(pattern.get_first(2), syscall);
-                    Memory::VP::Nop(pattern.get_first(), 6);
-                    Memory::VP::InjectHook(pattern.get_first(), startweaponanim_syscall,Memory::VP::HookType::Call);
+                if (anim_syscall) {
 
-                    pattern = hook::pattern((HMODULE)cg_game_offset, "75 ? 5F 5E 5D 83 C4");
+                    Memory::VP::Read((uintptr_t)anim_syscall + 2, syscall);
+                    Memory::VP::Nop(anim_syscall, 6);
+                    Memory::VP::InjectHook(anim_syscall, startweaponanim_syscall,Memory::VP::HookType::Call);
 
-                    if (!pattern.empty()) {
-                        CreateMidHook(pattern.get_first(2), [](SafetyHookContext& ctx) {
+                    if (anim_loop_end) {
+                        CreateMidHook((uintptr_t)anim_loop_end + 2, [](SafetyHookContext& ctx) {
 
                             
                                 do_transitionTime = false;
@@ -605,7 +786,9 @@ namespace weapon {
 
             if (!sp_mp(1))
                 return;
-            loadEWeapons();
+            if (eWeapons)
+                ApplyEWeapons(std::move(*eWeapons));
+            eWeapons.reset();
 
             SprintT4_lol((HMODULE)cg_game_offset);
 
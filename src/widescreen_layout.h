@@ -0,0 +1,91 @@
+#pragma once
+#include <algorithm>
+
+// Widescreen/HUD layout math. Everything derived from the resolution and the cg_fixedAspect/safeArea_* cvars is
+// computed here in one place, no game state is touched, so the numbers can be checked against a resolution table
+// outside the game.
+
+struct widescreen_layout_inputs {
+    int width;
+    int height;
+    int fixedAspect;
+    float safeAreaHorizontal;
+    float safeAreaVertical;
+
+    bool operator==(const widescreen_layout_inputs& other) const {
+        return width == other.width && height == other.height && fixedAspect == other.fixedAspect &&
+            safeAreaHorizontal == other.safeAreaHorizontal && safeAreaVertical == other.safeAreaVertical;
+    }
+
+    bool operator!=(const widescreen_layout_inputs& other) const {
+        return !(*this == other);
+    }
+};
+
+struct widescreen_layout {
+    // added to glOrtho's screen-space left/right: half of what a 4:3 ortho box grows by at this aspect
+    float orthoOffset;
+
+    // extra width of the game's 640x480 virtual screen at this aspect
+    float virtualWidthOffset;
+
+    // safeArea_horizontal clamped to [0, 1], 1 when fixed aspect is off
+    float safeAreaHorizontal;
+
+    // 1 - safeArea_vertical clamped to [0, 1], 0 when fixed aspect is off
+    float safeAreaVerticalHack;
+
+    // safeAreaVerticalHack in 480-space, the y shift for top/bottom aligned elements
+    float heightHackSafe;
+};
+
+inline widescreen_layout Widescreen_ComputeLayout(const widescreen_layout_inputs& in) {
+    widescreen_layout layout{};
+
+    if (!in.fixedAspect) {
+        layout.safeAreaHorizontal = 1.f;
+        return layout;
+    }
+
+    layout.safeAreaHorizontal = std::clamp(in.safeAreaHorizontal, 0.f, 1.f);
+    layout.safeAreaVerticalHack = 1.f - std::clamp(in.safeAreaVertical, 0.f, 1.f);
+    layout.heightHackSafe = 240.f * layout.safeAreaVerticalHack;
+
+    // resolution not known yet (vid_restart in progress)
+    if (in.height <= 0) {
+        return layout;
+    }
+
+    float x = (float)in.width;
+    float y = (float)in.height;
+
+    // orthoWidth = (x / y) * (3/4) * y = (x * x * 3) / (4y)
+    float orthoWidth = (x * x * 3.0f) / (4.0f * y);
+    layout.orthoOffset = (orthoWidth - x) / 2.0f;
+
+    // Same formula but scaled to 480-height coordinate space
+    float aspect = x / y;
+    layout.virtualWidthOffset = 480.0f * aspect - 640.0f;
+
+    return layout;
+}
+
+// Keeps the last layout and recomputes it only when one of the inputs changed. Callers gather the inputs (a few
+// loads) and get the precomputed floats back; the cvars are inputs too, so a changed cvar needs no invalidation.
+class widescreen_layout_cache {
+public:
+    const widescreen_layout& get(const widescreen_layout_inputs& in) {
+        if (!valid || in != inputs) {
+            inputs = in;
+            layout = Widescreen_ComputeLayout(in);
+            valid = true;
+        }
+
+        return layout;
+    }
+
+private:
+    widescreen_layout_inputs inputs{};
+    widescreen_layout layout{};
+    bool valid = false;
+};
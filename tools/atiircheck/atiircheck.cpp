@@ -0,0 +1,603 @@
+// atiircheck: runs recorded ATI_fragment_shader programs through the IR passes in src/ati_ir.cpp (constant folding,
+// dead code elimination, write mask merging) and checks that the optimized program computes the same registers as
+// the unoptimized one, interpreted on the CPU here, for what each liveOut set and each variant's epilogue reads. The
+// GLSL of every variant is checked for its samplers, constants and balanced parentheses. No GL context is involved.
+//
+// usage: atiircheck [random program count] (exit code 0 when every check passed, also run by ctest)
+
+#include "ati_ir.h"
+
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+static int failures = 0;
+
+static void Check(bool passed, const std::string& what)
+{
+	if (passed)
+		return;
+
+	std::printf("FAIL %s\n", what.c_str());
+	failures++;
+}
+
+// ============================================================================
+// RECORDING HELPERS
+// ============================================================================
+
+struct recorded_shader
+{
+	std::string name;
+	std::vector<ATIAnyInstruction> insts;
+	float constants[8][4] = {};
+	uint8_t constantsSet = 0;
+};
+
+static ATIAnyInstruction Setup(bool passTexCoord, GLuint dst, GLuint src, GLenum swizzle = GL_SWIZZLE_STR_ATI)
+{
+	ATIAnyInstruction any;
+	any.isSetup = true;
+	any.setup = { passTexCoord, dst, src, swizzle };
+	return any;
+}
+
+struct arg
+{
+	GLuint index;
+	GLuint rep = GL_NONE;
+	GLuint mod = 0;
+};
+
+static ATIAnyInstruction Op(ATIOpType type, GLenum op, GLuint dst, GLuint dstMask, GLuint dstMod, std::initializer_list<arg> args)
+{
+	ATIAnyInstruction any;
+	any.isSetup = false;
+	any.arith = {};
+	any.arith.type = type;
+	any.arith.op = op;
+	any.arith.dst = dst;
+	any.arith.dstMask = dstMask;
+	any.arith.dstMod = dstMod;
+	for (const auto& a : args)
+	{
+		any.arith.args[any.arith.argCount++] = { a.index, a.rep, a.mod };
+	}
+	return any;
+}
+
+static ATIAnyInstruction ColorOp(GLenum op, GLuint dst, GLuint dstMask, GLuint dstMod, std::initializer_list<arg> args)
+{
+	return Op(COLOR_OP, op, dst, dstMask, dstMod, args);
+}
+
+static ATIAnyInstruction AlphaOp(GLenum op, GLuint dst, GLuint dstMod, std::initializer_list<arg> args)
+{
+	return Op(ALPHA_OP, op, dst, GL_NONE, dstMod, args);
+}
+
+static void SetConstant(recorded_shader& shader, int index, float x, float y, float z, float w)
+{
+	shader.constants[index][0] = x;
+	shader.constants[index][1] = y;
+	shader.constants[index][2] = z;
+	shader.constants[index][3] = w;
+	shader.constantsSet |= 1 << index;
+}
+
+// ============================================================================
+// INTERPRETER
+// ============================================================================
+
+struct shader_inputs
+{
+	float primary[4];
+	float secondary[4];
+	float texCoord[8][4];
+	float constants[8][4];     // atiConst, the ones not set inside the shader
+};
+
+typedef float registers[ATI_IR_REGISTERS][4];
+
+static void FetchSource(const ATIIRSource& src, const registers& regs, const shader_inputs& in, float out[4])
+{
+	const float* value = src.value;
+	switch (src.kind)
+	{
+	case ATIIRSourceKind::Reg: value = regs[src.index]; break;
+	case ATIIRSourceKind::Const: value = in.constants[src.index]; break;
+	case ATIIRSourceKind::PrimaryColor: value = in.primary; break;
+	case ATIIRSourceKind::SecondaryColor: value = in.secondary; break;
+	case ATIIRSourceKind::TexCoord: value = in.texCoord[src.index]; break;
+	case ATIIRSourceKind::Literal: break;
+	}
+
+	for (int c = 0; c < 4; c++)
+	{
+		float v = value[src.rep != ATI_IR_NO_REP ? src.rep : c];
+		if (src.mod & GL_COMP_BIT_ATI) v = 1.f - v;
+		if (src.mod & GL_NEGATE_BIT_ATI) v = -v;
+		if (src.mod & GL_BIAS_BIT_ATI) v = v - 0.5f;
+		if (src.mod & GL_2X_BIT_ATI) v = v * 2.f;
+		out[c] = v;
+	}
+}
+
+// a smooth stand-in for the textures, reads only the coordinate components the lookup uses
+static void SampleTexture(int unit, const float coord[4], uint8_t coordMask, float out[4])
+{
+	float s = unit * 0.37f;
+	for (int c = 0; c < 4; c++)
+	{
+		if (coordMask & (1 << c))
+			s += coord[c] * (c + 1) * 0.731f;
+	}
+
+	for (int c = 0; c < 4; c++)
+		out[c] = 0.5f + 0.5f * std::sin(s + c * 1.3f);
+}
+
+static void Interpret(const ATIIRProgram& ir, const shader_inputs& in, registers& regs)
+{
+	memset(regs, 0, sizeof(regs));
+
+	for (const auto& inst : ir.insts)
+	{
+		float args[3][4] = {};
+		for (int i = 0; i < inst.argCount; i++)
+			FetchSource(inst.args[i], regs, in, args[i]);
+
+		const float* a = args[0];
+		const float* b = args[1];
+		const float* c = args[2];
+
+		float result[4];
+		if (inst.op == ATIIROp::Sample)
+		{
+			SampleTexture(inst.texUnit, a, inst.coordMask, result);
+		}
+		else
+		{
+			for (int i = 0; i < 4; i++)
+			{
+				float value = 0.f;
+				switch (inst.op)
+				{
+				case ATIIROp::Mov: value = a[i]; break;
+				case ATIIROp::Add: value = a[i] + b[i]; break;
+				case ATIIROp::Mul: value = a[i] * b[i]; break;
+				case ATIIROp::Sub: value = a[i] - b[i]; break;
+				case ATIIROp::Mad: value = a[i] * b[i] + c[i]; break;
+				case ATIIROp::Lerp: value = b[i] * (1.f - a[i]) + c[i] * a[i]; break;
+				case ATIIROp::Cnd: value = a[i] > 0.5f ? b[i] : c[i]; break;
+				case ATIIROp::Cnd0: value = a[i] >= 0.f ? b[i] : c[i]; break;
+				case ATIIROp::Dot3: value = a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; break;
+				case ATIIROp::Dot4: value = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3]; break;
+				case ATIIROp::Dot2Add: value = a[0] * b[0] + a[1] * b[1] + c[2]; break;
+				case ATIIROp::Invalid: value = i == 1 ? 0.f : 1.f; break;
+				case ATIIROp::Sample: break;
+				}
+				result[i] = value;
+			}
+		}
+
+		float scale = 1.f;
+		if (inst.dstMod & GL_2X_BIT_ATI) scale *= 2.f;
+		if (inst.dstMod & GL_4X_BIT_ATI) scale *= 4.f;
+		if (inst.dstMod & GL_8X_BIT_ATI) scale *= 8.f;
+		if (inst.dstMod & GL_HALF_BIT_ATI) scale *= 0.5f;
+		if (inst.dstMod & GL_QUARTER_BIT_ATI) scale *= 0.25f;
+		if (inst.dstMod & GL_EIGHTH_BIT_ATI) scale *= 0.125f;
+
+		for (int i = 0; i < 4; i++)
+		{
+			if (!(inst.writeMask & (1 << i)))
+				continue;
+
+			float value = result[i] * scale;
+			if (inst.dstMod & GL_SATURATE_BIT_ATI)
+				value = value < 0.f ? 0.f : (value > 1.f ? 1.f : value);
+			regs[inst.dst][i] = value;
+		}
+	}
+}
+
+static bool Close(float a, float b)
+{
+	if (std::isnan(a) || std::isnan(b))
+		return std::isnan(a) && std::isnan(b);
+	return std::fabs(a - b) <= 1e-4f * std::fmax(1.f, std::fmax(std::fabs(a), std::fabs(b)));
+}
+
+// ============================================================================
+// CHECKS
+// ============================================================================
+
+static std::vector<shader_inputs> MakeInputs()
+{
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<float> unit(0.f, 1.f);
+
+	std::vector<shader_inputs> inputs(4);
+	for (auto& in : inputs)
+	{
+		for (int c = 0; c < 4; c++)
+		{
+			in.primary[c] = unit(rng);
+			in.secondary[c] = unit(rng);
+			for (int i = 0; i < 8; i++)
+			{
+				in.texCoord[i][c] = unit(rng) * 2.f - 1.f;
+				in.constants[i][c] = unit(rng);
+			}
+		}
+	}
+	return inputs;
+}
+
+static ATIIRProgram Optimize(const ATIIRProgram& built, const uint8_t liveOut[ATI_IR_REGISTERS])
+{
+	ATIIRProgram ir = built;
+	ATIIR_FoldConstants(ir);
+	ATIIR_EliminateDeadCode(ir, liveOut);
+	ATIIR_MergeWriteMasks(ir);
+	return ir;
+}
+
+static std::string LiveOutName(const uint8_t liveOut[ATI_IR_REGISTERS])
+{
+	std::string name;
+	for (int r = 0; r < ATI_IR_REGISTERS; r++)
+	{
+		char text[8];
+		snprintf(text, sizeof(text), "%s%X", r ? "," : "", liveOut[r]);
+		name += text;
+	}
+	return name;
+}
+
+// the optimized program must compute everything liveOut reads exactly like the recorded one
+static void CheckEquivalent(const recorded_shader& shader, const ATIIRProgram& built, const uint8_t liveOut[ATI_IR_REGISTERS],
+	const std::vector<shader_inputs>& inputs)
+{
+	ATIIRProgram optimized = Optimize(built, liveOut);
+	Check(optimized.insts.size() <= built.insts.size(), shader.name + ": the passes added instructions");
+
+	for (size_t n = 0; n < inputs.size(); n++)
+	{
+		registers expected, actual;
+		Interpret(built, inputs[n], expected);
+		Interpret(optimized, inputs[n], actual);
+
+		for (int r = 0; r < ATI_IR_REGISTERS; r++)
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				if (!(liveOut[r] & (1 << c)) || Close(expected[r][c], actual[r][c]))
+					continue;
+
+				char detail[128];
+				snprintf(detail, sizeof(detail), ": liveOut %s, inputs %zu, r%d.%c = %g, expected %g",
+					LiveOutName(liveOut).c_str(), n, r, "rgba"[c], actual[r][c], expected[r][c]);
+				Check(false, shader.name + detail);
+			}
+		}
+	}
+}
+
+static bool ParenthesesBalanced(const std::string& text)
+{
+	int depth = 0;
+	for (char c : text)
+	{
+		depth += c == '(' ? 1 : (c == ')' ? -1 : 0);
+		if (depth < 0)
+			return false;
+	}
+	return depth == 0;
+}
+
+// what the GLSL of a variant declares has to follow from the optimized program
+static void CheckVariantGLSL(const recorded_shader& shader, const ATIIRProgram& folded, int variant)
+{
+	const int debugMode = ATIVariant_DebugMode(variant);
+	const std::string name = shader.name + ", variant " + std::to_string(variant);
+
+	uint8_t liveOut[ATI_IR_REGISTERS];
+	ATIIR_LiveOut(debugMode, liveOut);
+
+	ATIIRProgram ir = folded;
+	ATIIR_EliminateDeadCode(ir, liveOut);
+	ATIIR_MergeWriteMasks(ir);
+
+	bool samplers[ATI_IR_REGISTERS] = {};
+	bool constants = false;
+	for (const auto& inst : ir.insts)
+	{
+		if (inst.op == ATIIROp::Sample)
+			samplers[inst.texUnit] = true;
+		for (int i = 0; i < inst.argCount; i++)
+			constants |= inst.args[i].kind == ATIIRSourceKind::Const;
+	}
+
+	const std::string glsl = ATIIR_TranslateToGLSL(folded, variant);
+	const std::string defines = "#define ATI_DEBUG_MODE " + std::to_string(debugMode) + "\n#define ATI_FOG_MODE " +
+		std::to_string(ATIVariant_Fog(variant)) + "\n";
+
+	Check(glsl.compare(0, defines.size(), defines) == 0, name + ": variant defines");
+	Check(ParenthesesBalanced(glsl), name + ": unbalanced parentheses");
+	Check((glsl.find("uniform vec4 atiConst[8];") != std::string::npos) == constants, name + ": atiConst declaration");
+
+	for (int t = 0; t < ATI_IR_REGISTERS; t++)
+	{
+		const std::string sampler = (t == 0 ? "sampler2D tex0;" : "samplerCube tex" + std::to_string(t) + ";");
+		Check((glsl.find(sampler) != std::string::npos) == samplers[t], name + ": sampler tex" + std::to_string(t));
+	}
+
+	for (int r = 0; r < ATI_IR_REGISTERS; r++)
+	{
+		if (liveOut[r])
+			Check(glsl.find("vec4 r" + std::to_string(r) + " = vec4(0.0);") != std::string::npos, name + ": r" + std::to_string(r) + " declared");
+	}
+}
+
+static void CheckShader(const recorded_shader& shader, const std::vector<shader_inputs>& inputs)
+{
+	const ATIIRProgram built = ATIIR_Build(shader.insts, shader.constants, shader.constantsSet);
+
+	// every register and component, each register on its own, and what each debug view reads
+	std::vector<std::array<uint8_t, ATI_IR_REGISTERS>> liveOuts;
+	liveOuts.push_back({ ATI_IR_XYZW, ATI_IR_XYZW, ATI_IR_XYZW, ATI_IR_XYZW, ATI_IR_XYZW, ATI_IR_XYZW });
+	for (int r = 0; r < ATI_IR_REGISTERS; r++)
+	{
+		std::array<uint8_t, ATI_IR_REGISTERS> only{};
+		only[r] = ATI_IR_XYZW;
+		liveOuts.push_back(only);
+		only[r] = ATI_IR_W;
+		liveOuts.push_back(only);
+	}
+	for (int debugMode = -1; debugMode <= 6; debugMode++)
+	{
+		std::array<uint8_t, ATI_IR_REGISTERS> liveOut;
+		ATIIR_LiveOut(debugMode, liveOut.data());
+		liveOuts.push_back(liveOut);
+	}
+
+	for (const auto& liveOut : liveOuts)
+		CheckEquivalent(shader, built, liveOut.data(), inputs);
+
+	ATIIRProgram folded = built;
+	ATIIR_FoldConstants(folded);
+	for (int variant = 0; variant < ATI_VARIANT_COUNT; variant++)
+		CheckVariantGLSL(shader, folded, variant);
+}
+
+// ============================================================================
+// SHADERS
+// ============================================================================
+
+static const arg bx2(GLuint index)
+{
+	return { index, GL_NONE, GL_BIAS_BIT_ATI | GL_2X_BIT_ATI };
+}
+
+static std::vector<recorded_shader> RecordedShaders()
+{
+	std::vector<recorded_shader> shaders;
+
+	// bump mapped specular like the game's, with an alpha op and a register nothing reads
+	{
+		recorded_shader shader;
+		shader.name = "specular";
+		shader.insts = {
+			Setup(false, GL_REG_0_ATI, GL_TEXTURE0_ARB),
+			Setup(false, GL_REG_2_ATI, GL_TEXTURE2_ARB),
+			Setup(false, GL_REG_3_ATI, GL_TEXTURE3_ARB),
+			ColorOp(GL_DOT3_ATI, GL_REG_4_ATI, GL_NONE, GL_SATURATE_BIT_ATI, { bx2(GL_REG_0_ATI), bx2(GL_PRIMARY_COLOR_ARB) }),
+			ColorOp(GL_MUL_ATI, GL_REG_2_ATI, GL_NONE, 0, { { GL_REG_2_ATI }, { GL_REG_4_ATI } }),
+			AlphaOp(GL_MOV_ATI, GL_REG_3_ATI, 0, { { GL_REG_4_ATI, GL_BLUE } }),
+			ColorOp(GL_MUL_ATI, GL_REG_3_ATI, GL_NONE, GL_2X_BIT_ATI, { { GL_REG_3_ATI }, { GL_CON_1_ATI } }),
+			ColorOp(GL_MOV_ATI, GL_REG_5_ATI, GL_NONE, 0, { { GL_SECONDARY_INTERPOLATOR_ATI } }),
+		};
+		shaders.push_back(shader);
+	}
+
+	// constants set inside the shader, r1 only ever holds literals
+	{
+		recorded_shader shader;
+		shader.name = "constants";
+		SetConstant(shader, 0, 0.5f, 0.25f, 1.f, 1.f);
+		SetConstant(shader, 2, 2.f, 2.f, 2.f, 0.5f);
+		shader.insts = {
+			ColorOp(GL_MOV_ATI, GL_REG_1_ATI, GL_NONE, 0, { { GL_CON_0_ATI } }),
+			AlphaOp(GL_MOV_ATI, GL_REG_1_ATI, 0, { { GL_CON_2_ATI } }),
+			ColorOp(GL_MUL_ATI, GL_REG_1_ATI, GL_NONE, 0, { { GL_REG_1_ATI }, { GL_CON_2_ATI, GL_NONE, GL_BIAS_BIT_ATI } }),
+			Setup(false, GL_REG_0_ATI, GL_TEXTURE0_ARB),
+			ColorOp(GL_MUL_ATI, GL_REG_0_ATI, GL_NONE, 0, { { GL_REG_0_ATI }, { GL_REG_1_ATI } }),
+			AlphaOp(GL_MUL_ATI, GL_REG_0_ATI, 0, { { GL_REG_0_ATI }, { GL_REG_1_ATI } }),
+		};
+		shaders.push_back(shader);
+	}
+
+	// color/alpha halves and split color masks computing the same thing, and a pair that must stay apart
+	{
+		recorded_shader shader;
+		shader.name = "merge";
+		shader.insts = {
+			Setup(false, GL_REG_0_ATI, GL_TEXTURE0_ARB),
+			ColorOp(GL_MUL_ATI, GL_REG_0_ATI, GL_NONE, 0, { { GL_REG_0_ATI }, { GL_PRIMARY_COLOR_ARB } }),
+			AlphaOp(GL_MUL_ATI, GL_REG_0_ATI, 0, { { GL_REG_0_ATI }, { GL_PRIMARY_COLOR_ARB } }),
+			ColorOp(GL_ADD_ATI, GL_REG_1_ATI, GL_RED_BIT_ATI, 0, { { GL_REG_0_ATI }, { GL_SECONDARY_INTERPOLATOR_ATI } }),
+			ColorOp(GL_ADD_ATI, GL_REG_1_ATI, GL_GREEN_BIT_ATI | GL_BLUE_BIT_ATI, 0, { { GL_REG_0_ATI }, { GL_SECONDARY_INTERPOLATOR_ATI } }),
+			ColorOp(GL_MOV_ATI, GL_REG_2_ATI, GL_RED_BIT_ATI, 0, { { GL_REG_2_ATI, GL_RED, GL_COMP_BIT_ATI } }),
+			ColorOp(GL_MOV_ATI, GL_REG_2_ATI, GL_GREEN_BIT_ATI, 0, { { GL_REG_2_ATI, GL_RED, GL_COMP_BIT_ATI } }),
+		};
+		shaders.push_back(shader);
+	}
+
+	// every op, replicates, argument modifiers and destination scales, a dependent read and an unknown op
+	{
+		recorded_shader shader;
+		shader.name = "ops";
+		SetConstant(shader, 3, 0.75f, -0.5f, 0.125f, 0.6f);
+		shader.insts = {
+			Setup(false, GL_REG_0_ATI, GL_TEXTURE0_ARB),
+			Setup(true, GL_REG_1_ATI, GL_TEXTURE1_ARB),
+			Setup(false, GL_REG_2_ATI, GL_TEXTURE2_ARB, GL_SWIZZLE_STQ_ATI),
+			ColorOp(GL_LERP_ATI, GL_REG_3_ATI, GL_NONE, GL_HALF_BIT_ATI, { { GL_REG_0_ATI, GL_ALPHA }, { GL_REG_1_ATI }, { GL_REG_2_ATI, GL_NONE, GL_NEGATE_BIT_ATI } }),
+			ColorOp(GL_CND_ATI, GL_REG_4_ATI, GL_NONE, 0, { { GL_REG_0_ATI }, { GL_REG_3_ATI }, { GL_CON_3_ATI } }),
+			ColorOp(GL_CND0_ATI, GL_REG_5_ATI, GL_NONE, GL_4X_BIT_ATI, { bx2(GL_REG_1_ATI), { GL_REG_4_ATI }, { GL_PRIMARY_COLOR_ARB, GL_GREEN } }),
+			ColorOp(GL_DOT2_ADD_ATI, GL_REG_1_ATI, GL_NONE, GL_QUARTER_BIT_ATI, { { GL_REG_5_ATI }, { GL_REG_2_ATI }, { GL_CON_3_ATI } }),
+			AlphaOp(GL_DOT4_ATI, GL_REG_1_ATI, GL_8X_BIT_ATI | GL_SATURATE_BIT_ATI, { { GL_REG_3_ATI }, { GL_CON_4_ATI } }),
+			ColorOp(GL_SUB_ATI, GL_REG_3_ATI, GL_NONE, GL_EIGHTH_BIT_ATI, { { GL_REG_1_ATI, GL_ALPHA, GL_COMP_BIT_ATI }, { GL_REG_4_ATI } }),
+			ColorOp(GL_MAD_ATI, GL_REG_2_ATI, GL_GREEN_BIT_ATI, GL_2X_BIT_ATI, { { GL_REG_3_ATI }, { GL_ONE, GL_NONE, GL_BIAS_BIT_ATI }, { GL_ZERO } }),
+			Setup(false, GL_REG_4_ATI, GL_REG_2_ATI),
+			ColorOp(0x1234, GL_REG_5_ATI, GL_BLUE_BIT_ATI, 0, { { GL_REG_4_ATI } }),
+			ColorOp(GL_ADD_ATI, GL_REG_0_ATI, GL_NONE, GL_SATURATE_BIT_ATI, { { GL_REG_4_ATI }, { GL_REG_5_ATI } }),
+		};
+		shaders.push_back(shader);
+	}
+
+	return shaders;
+}
+
+// what the passes are expected to leave of the recorded shaders under the normal view
+static void CheckPassResults(const std::vector<recorded_shader>& shaders)
+{
+	uint8_t liveOut[ATI_IR_REGISTERS];
+	ATIIR_LiveOut(0, liveOut);
+
+	for (const auto& shader : shaders)
+	{
+		const ATIIRProgram built = ATIIR_Build(shader.insts, shader.constants, shader.constantsSet);
+
+		if (shader.name == "specular")
+		{
+			// the alpha op and r5 are dropped
+			Check(Optimize(built, liveOut).insts.size() == 6, "specular: alpha op and unread r5 eliminated");
+		}
+		else if (shader.name == "constants")
+		{
+			const uint8_t all[ATI_IR_REGISTERS] = { ATI_IR_XYZW };
+			ATIIRProgram optimized = Optimize(built, all);
+
+			// the sample and the two multiplies by a literal, merged into one
+			Check(optimized.insts.size() == 2, "constants: r1 folded into literals");
+			for (const auto& inst : optimized.insts)
+			{
+				for (int i = 0; i < inst.argCount; i++)
+					Check(!(inst.args[i].kind == ATIIRSourceKind::Reg && inst.args[i].index == 1), "constants: r1 still read");
+			}
+		}
+		else if (shader.name == "merge")
+		{
+			const uint8_t all[ATI_IR_REGISTERS] = { ATI_IR_XYZW, ATI_IR_XYZW, ATI_IR_XYZW };
+			ATIIRProgram optimized = Optimize(built, all);
+
+			// color+alpha and red+green/blue merge, the r2 pair reads what its first half writes
+			Check(built.insts.size() == 7 && optimized.unknownOps.empty(), "merge: recorded as is");
+			Check(optimized.insts.size() == 5, "merge: two pairs merged, the dependent pair kept apart");
+		}
+		else if (shader.name == "ops")
+		{
+			Check(built.unknownOps.size() == 1 && built.unknownOps[0] == 0x1234, "ops: unknown opcode reported");
+		}
+	}
+}
+
+// ============================================================================
+// RANDOM PROGRAMS
+// ============================================================================
+
+static recorded_shader RandomShader(std::mt19937& rng, int number)
+{
+	auto pick = [&](int count) { return (int)(rng() % count); };
+
+	static const GLenum ops[] = { GL_MOV_ATI, GL_ADD_ATI, GL_MUL_ATI, GL_SUB_ATI, GL_MAD_ATI, GL_LERP_ATI, GL_CND_ATI,
+		GL_CND0_ATI, GL_DOT3_ATI, GL_DOT4_ATI, GL_DOT2_ADD_ATI };
+	static const GLuint reps[] = { GL_NONE, GL_NONE, GL_NONE, GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA };
+	static const GLuint dstMods[] = { 0, 0, 0, GL_2X_BIT_ATI, GL_HALF_BIT_ATI, GL_SATURATE_BIT_ATI, GL_4X_BIT_ATI | GL_SATURATE_BIT_ATI };
+
+	recorded_shader shader;
+		shader.name = "random " + std::to_string(number);
+
+	for (int c = 0; c < 8; c++)
+	{
+		if (pick(3) == 0)
+			SetConstant(shader, c, pick(9) * 0.25f - 1.f, pick(9) * 0.25f - 1.f, pick(9) * 0.25f - 1.f, pick(5) * 0.25f);
+	}
+
+	auto source = [&]() -> arg {
+		GLuint index;
+		switch (pick(6))
+		{
+		case 0: index = GL_CON_0_ATI + pick(8); break;
+		case 1: index = pick(2) ? GL_PRIMARY_COLOR_ARB : GL_SECONDARY_INTERPOLATOR_ATI; break;
+		case 2: index = pick(2) ? GL_ZERO : GL_ONE; break;
+		default: index = GL_REG_0_ATI + pick(ATI_IR_REGISTERS); break;
+		}
+		return { index, reps[pick(7)], (GLuint)(pick(3) == 0 ? pick(16) : 0) };
+	};
+
+	const int setups = 1 + pick(3);
+	for (int i = 0; i < setups; i++)
+	{
+		GLuint dst = GL_REG_0_ATI + pick(ATI_IR_REGISTERS);
+		GLuint src = pick(3) ? GL_TEXTURE0_ARB + pick(8) : GL_REG_0_ATI + pick(ATI_IR_REGISTERS);
+		shader.insts.push_back(Setup(pick(3) == 0, dst, src, pick(2) ? GL_SWIZZLE_STR_ATI : GL_SWIZZLE_STQ_ATI));
+	}
+
+	const int count = 3 + pick(12);
+	for (int i = 0; i < count; i++)
+	{
+		GLenum op = ops[pick(11)];
+		GLuint dst = GL_REG_0_ATI + pick(ATI_IR_REGISTERS);
+		GLuint dstMod = dstMods[pick(7)];
+		arg a = source(), b = source(), c = source();
+
+		if (pick(3) == 0)
+		{
+			shader.insts.push_back(AlphaOp(op, dst, dstMod, { a, b, c }));
+		}
+		else
+		{
+			GLuint mask = pick(2) ? GL_NONE : (GLuint)(1 + pick(7));   // GL_RED_BIT_ATI..GL_BLUE_BIT_ATI are 1, 2, 4
+			shader.insts.push_back(ColorOp(op, dst, mask, dstMod, { a, b, c }));
+
+			// the same computation into the other components, what MergeWriteMasks joins
+			if (pick(3) == 0)
+				shader.insts.push_back(AlphaOp(op, dst, dstMod, { a, b, c }));
+		}
+	}
+
+	return shader;
+}
+
+int main(int argc, char** argv)
+{
+	const int randomCount = argc > 1 ? atoi(argv[1]) : 500;
+	const std::vector<shader_inputs> inputs = MakeInputs();
+
+	const std::vector<recorded_shader> shaders = RecordedShaders();
+	for (const auto& shader : shaders)
+		CheckShader(shader, inputs);
+	CheckPassResults(shaders);
+
+	std::mt19937 rng(1);
+	for (int i = 0; i < randomCount; i++)
+		CheckShader(RandomShader(rng, i), inputs);
+
+	if (failures)
+	{
+		std::printf("%d check(s) failed\n", failures);
+		return 1;
+	}
+
+	std::printf("all ATI IR checks passed (%zu recorded, %d random programs)\n", shaders.size(), randomCount);
+	return 0;
+}
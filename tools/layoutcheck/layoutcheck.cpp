@@ -0,0 +1,139 @@
+// layoutcheck: checks Widescreen_ComputeLayout (src/widescreen_layout.h) against a table of common resolutions,
+// the safe area clamps, cg_fixedAspect 0 and that the layout cache follows every input. The header touches no game
+// state, so this runs anywhere.
+//
+// usage: layoutcheck (exit code 0 when every check passed, also run by ctest)
+
+#include "widescreen_layout.h"
+
+#include <cmath>
+#include <cstdio>
+
+static int failures = 0;
+
+static void Check(const char* fixture, const char* field, float actual, float expected)
+{
+	if (std::fabs(actual - expected) <= 0.01f)
+		return;
+
+	std::printf("FAIL %s: %s = %f, expected %f\n", fixture, field, actual, expected);
+	failures++;
+}
+
+struct resolution_fixture
+{
+	const char* name;
+	int width;
+	int height;
+	float orthoOffset;
+	float virtualWidthOffset;
+};
+
+// orthoOffset = (w * w * 3 / (4h) - w) / 2, virtualWidthOffset = 480 * w / h - 640
+static const resolution_fixture resolutions[] =
+{
+	{ "4:3 640x480",    640,  480,  0.f,       0.f },
+	{ "4:3 1600x1200",  1600, 1200, 0.f,       0.f },
+	{ "16:9 1920x1080", 1920, 1080, 320.f,     213.333f },
+	{ "16:9 1280x720",  1280, 720,  213.333f,  213.333f },
+	{ "16:10 1920x1200",1920, 1200, 192.f,     128.f },
+	{ "16:10 1680x1050",1680, 1050, 168.f,     128.f },
+	{ "21:9 2560x1080", 2560, 1080, 995.556f,  497.778f },
+	{ "21:9 3440x1440", 3440, 1440, 1361.667f, 506.667f },
+};
+
+static void CheckResolutions()
+{
+	for (const auto& res : resolutions)
+	{
+		const widescreen_layout layout = Widescreen_ComputeLayout({ res.width, res.height, 1, 1.f, 1.f });
+
+		Check(res.name, "orthoOffset", layout.orthoOffset, res.orthoOffset);
+		Check(res.name, "virtualWidthOffset", layout.virtualWidthOffset, res.virtualWidthOffset);
+		Check(res.name, "safeAreaHorizontal", layout.safeAreaHorizontal, 1.f);
+		Check(res.name, "safeAreaVerticalHack", layout.safeAreaVerticalHack, 0.f);
+		Check(res.name, "heightHackSafe", layout.heightHackSafe, 0.f);
+	}
+}
+
+static void CheckSafeArea()
+{
+	widescreen_layout layout = Widescreen_ComputeLayout({ 1920, 1080, 1, 0.9f, 0.8f });
+	Check("safe area 0.9/0.8", "safeAreaHorizontal", layout.safeAreaHorizontal, 0.9f);
+	Check("safe area 0.9/0.8", "safeAreaVerticalHack", layout.safeAreaVerticalHack, 0.2f);
+	Check("safe area 0.9/0.8", "heightHackSafe", layout.heightHackSafe, 48.f);
+	Check("safe area 0.9/0.8", "orthoOffset", layout.orthoOffset, 320.f);
+
+	layout = Widescreen_ComputeLayout({ 1920, 1080, 1, 1.5f, 2.f });
+	Check("safe area above 1", "safeAreaHorizontal", layout.safeAreaHorizontal, 1.f);
+	Check("safe area above 1", "safeAreaVerticalHack", layout.safeAreaVerticalHack, 0.f);
+	Check("safe area above 1", "heightHackSafe", layout.heightHackSafe, 0.f);
+
+	layout = Widescreen_ComputeLayout({ 1920, 1080, 1, -0.5f, -1.f });
+	Check("safe area below 0", "safeAreaHorizontal", layout.safeAreaHorizontal, 0.f);
+	Check("safe area below 0", "safeAreaVerticalHack", layout.safeAreaVerticalHack, 1.f);
+	Check("safe area below 0", "heightHackSafe", layout.heightHackSafe, 240.f);
+
+	// resolution not known yet: the safe area is still applied, the offsets stay 0
+	layout = Widescreen_ComputeLayout({ 0, 0, 1, 0.9f, 0.8f });
+	Check("no resolution", "safeAreaHorizontal", layout.safeAreaHorizontal, 0.9f);
+	Check("no resolution", "heightHackSafe", layout.heightHackSafe, 48.f);
+	Check("no resolution", "orthoOffset", layout.orthoOffset, 0.f);
+	Check("no resolution", "virtualWidthOffset", layout.virtualWidthOffset, 0.f);
+}
+
+static void CheckFixedAspectOff()
+{
+	for (const auto& res : resolutions)
+	{
+		const widescreen_layout layout = Widescreen_ComputeLayout({ res.width, res.height, 0, 0.5f, 0.5f });
+
+		Check(res.name, "fixedAspect 0 orthoOffset", layout.orthoOffset, 0.f);
+		Check(res.name, "fixedAspect 0 virtualWidthOffset", layout.virtualWidthOffset, 0.f);
+		Check(res.name, "fixedAspect 0 safeAreaHorizontal", layout.safeAreaHorizontal, 1.f);
+		Check(res.name, "fixedAspect 0 safeAreaVerticalHack", layout.safeAreaVerticalHack, 0.f);
+		Check(res.name, "fixedAspect 0 heightHackSafe", layout.heightHackSafe, 0.f);
+	}
+}
+
+static void CheckCache()
+{
+	widescreen_layout_cache cache;
+
+	// the same reference comes back each time, only its contents are recomputed
+	const widescreen_layout& layout = cache.get({ 1920, 1080, 1, 1.f, 1.f });
+	cache.get({ 1920, 1080, 1, 1.f, 1.f });
+	Check("cache", "orthoOffset after a repeated get", layout.orthoOffset, 320.f);
+
+	cache.get({ 2560, 1080, 1, 1.f, 1.f });
+	Check("cache", "orthoOffset after a resolution change", layout.orthoOffset, 995.556f);
+
+	// cvar changes reach the layout through the inputs alone
+	cache.get({ 2560, 1080, 1, 0.9f, 0.8f });
+	Check("cache", "safeAreaHorizontal after a safeArea_horizontal change", layout.safeAreaHorizontal, 0.9f);
+	Check("cache", "heightHackSafe after a safeArea_vertical change", layout.heightHackSafe, 48.f);
+
+	cache.get({ 2560, 1080, 0, 0.9f, 0.8f });
+	Check("cache", "orthoOffset after cg_fixedAspect 0", layout.orthoOffset, 0.f);
+	Check("cache", "safeAreaHorizontal after cg_fixedAspect 0", layout.safeAreaHorizontal, 1.f);
+
+	cache.get({ 2560, 1080, 1, 0.9f, 0.8f });
+	Check("cache", "orthoOffset after cg_fixedAspect 1", layout.orthoOffset, 995.556f);
+}
+
+int main()
+{
+	CheckResolutions();
+	CheckSafeArea();
+	CheckFixedAspectOff();
+	CheckCache();
+
+	if (failures)
+	{
+		std::printf("%d check(s) failed\n", failures);
+		return 1;
+	}
+
+	std::printf("all layout checks passed\n");
+	return 0;
+}
@@ -0,0 +1,183 @@
+// menuwidecheck: parses menuwide configs written to a temporary directory and checks the table handover in
+// src/menuwide.cpp: publish and swap, the generation bump, that the retired tables outlive one more swap and that
+// cache stores from two threads at once leave a valid cache.
+// Nothing in there touches the game, so this runs anywhere.
+//
+// usage: menuwidecheck (exit code 0 when every check passed, also run by ctest)
+
+#include "menuwide.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static int failures = 0;
+
+static void Check(bool passed, const char* what)
+{
+	if (passed)
+		return;
+
+	std::printf("FAIL %s\n", what);
+	failures++;
+}
+
+static void WriteFile(const fs::path& path, const char* text)
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file << text;
+}
+
+// one file with a single menu, one with an array and the HUD shader file
+static void WriteConfigs(const fs::path& dir, const char* mainAlignment)
+{
+	std::string single = std::string(R"({ "menuName": "Main", "alignment": ")") + mainAlignment + R"(" })";
+	WriteFile(dir / "main.json", single.c_str());
+
+	WriteFile(dir / "ingame.json", R"([
+		{ "menuName": "InGame_Options", "alignment": "[LT]" },
+		{ "menuName": "scoreboard", "alignment": "[STRETCH]" }
+	])");
+
+	WriteFile(dir / "_hudelem_shaders.json", R"([
+		{ "shaderName": "gfx/hud/hud@compass", "alignment": "[RB]" }
+	])");
+}
+
+static void CheckParse(const menuwide_tables& tables, const char* source)
+{
+	std::printf("checking tables parsed %s\n", source);
+
+	Check(tables.menus.size() == 3, "three menu configs");
+	Check(tables.shaders.size() == 1, "one HUD shader config");
+	Check(tables.menuLookup.size() == 3, "three menu lookup entries");
+
+	// the lookups are keyed by the lowercase name
+	auto menu = tables.menuLookup.find("ingame_options");
+	Check(menu != tables.menuLookup.end(), "InGame_Options found by its lowercase name");
+	if (menu != tables.menuLookup.end())
+		Check(menu->second->alignment.h_left && menu->second->alignment.v_top, "InGame_Options is [LT]");
+
+	auto shader = tables.shaderLookup.find("gfx/hud/hud@compass");
+	Check(shader != tables.shaderLookup.end(), "compass shader found");
+	if (shader != tables.shaderLookup.end())
+		Check(shader->second->alignment.h_right && shader->second->alignment.v_bottom, "compass shader is [RB]");
+}
+
+static void CheckHandover(const fs::path& dir)
+{
+	std::printf("checking publish and swap\n");
+
+	Check(Menuwide_GetGeneration() == 0, "generation 0 before anything was published");
+	Check(FindMenuConfig("main") == nullptr, "no config before anything was published");
+
+	Menuwide_Publish(Menuwide_Parse(dir));
+	Check(Menuwide_GetGeneration() == 1, "generation 1 after the first swap");
+
+	const MenuConfig* first = FindMenuConfig("MAIN");
+	Check(first && first->alignment.h_center, "Main found case-insensitively and [CENTER]");
+	Check(FindHudShaderConfig("gfx/hud/hud@compass") != nullptr, "compass shader found through FindHudShaderConfig");
+	Check(Menuwide_GetGeneration() == 1, "lookups without a publish don't bump the generation");
+
+	// what a reload does: the watcher parses and publishes, the next lookup swaps
+	WriteConfigs(dir, "[RIGHT]");
+	Menuwide_Publish(Menuwide_Parse(dir));
+
+	const MenuConfig* second = FindMenuConfig("main");
+	Check(Menuwide_GetGeneration() == 2, "generation 2 after the second swap");
+	Check(second && second != first && second->alignment.h_right, "Main is [RIGHT] after the swap");
+
+	// the first tables are retired now, a pointer from the previous frame still reads them
+	Check(first && first->menuName == "Main" && first->alignment.h_center, "pointer into the retired tables still valid");
+
+	// two publishes before a lookup: the first is dropped, only one swap happens
+	WriteConfigs(dir, "[LEFT]");
+	Menuwide_Publish(Menuwide_Parse(dir));
+	WriteConfigs(dir, "[BOTTOM]");
+	Menuwide_Publish(Menuwide_Parse(dir));
+
+	const MenuConfig* third = FindMenuConfig("main");
+	Check(Menuwide_GetGeneration() == 3, "generation 3, two publishes swap once");
+	Check(third && third->alignment.v_bottom, "the later of two publishes wins");
+	Check(second && second->menuName == "Main" && second->alignment.h_right, "second tables retired and still valid");
+}
+
+// the watcher thread and the game thread can both store the cache after a full parse
+static void CheckConcurrentStores(const fs::path& dir)
+{
+	const fs::path cachePath = dir / "concurrent.cache";
+
+	for (int round = 0; round < 20; round++)
+	{
+		std::error_code ec;
+		fs::remove(cachePath, ec);
+
+		std::vector<size_t> menuCounts(4);
+		std::vector<std::thread> threads;
+		for (size_t i = 0; i < menuCounts.size(); i++)
+		{
+			threads.emplace_back([&, i] { menuCounts[i] = Menuwide_Parse(dir, cachePath).menus.size(); });
+		}
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+
+		for (size_t count : menuCounts)
+		{
+			Check(count == 3, "concurrent parse with a cache path");
+		}
+	}
+
+	CheckParse(Menuwide_Parse(dir, cachePath), "from a cache stored by several threads");
+
+	for (const auto& entry : fs::directory_iterator(dir))
+	{
+		Check(entry.path().extension() != ".tmp", "no temporary cache file left behind");
+	}
+}
+
+int main()
+{
+	std::error_code ec;
+	const fs::path dir = fs::temp_directory_path() / ("menuwidecheck-" + std::to_string(std::random_device{}()));
+	fs::create_directories(dir, ec);
+	if (ec)
+	{
+		std::printf("can't create %s: %s\n", dir.string().c_str(), ec.message().c_str());
+		return 1;
+	}
+
+	WriteConfigs(dir, "[CENTER]");
+
+	CheckParse(Menuwide_Parse(dir), "from JSON");
+
+	// the first parse with a cache path writes it, the second reads it
+	const fs::path cachePath = dir / "menuwide.cache";
+	CheckParse(Menuwide_Parse(dir, cachePath), "from JSON with a cache path");
+	Check(fs::exists(cachePath), "cache written after a complete parse");
+	CheckParse(Menuwide_Parse(dir, cachePath), "from the cache");
+
+	Check(Menuwide_Parse(dir / "missing").menus.empty(), "missing directory parses to empty tables");
+
+	CheckConcurrentStores(dir);
+	CheckHandover(dir);
+
+	fs::remove_all(dir, ec);
+
+	if (failures)
+	{
+		std::printf("%d check(s) failed\n", failures);
+		return 1;
+	}
+
+	std::printf("all menuwide checks passed\n");
+	return 0;
+}
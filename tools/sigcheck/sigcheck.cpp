@@ -0,0 +1,353 @@
+// sigcheck: runs every signature found in the plugin sources against CoDUO executables/DLLs loaded from disk.
+// The images are mapped by hand (headers + sections at their RVAs), no Windows loader is involved, so this also
+// runs on Linux. It reports match counts, ambiguous signatures, offsets and scan times per pattern.
+//
+// usage: sigcheck [--repeat N] [--verbose] --src <file or directory>... <image>...
+//
+// Images must be unpacked, the code of the Steam executables is encrypted on disk and will not match.
+
+#include "Hooking.Patterns.h"
+
+#include <windows.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <regex>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct mapped_image
+{
+	std::string name;
+	std::vector<uint8_t> memory;
+	uint32_t imageBase = 0;
+};
+
+struct signature
+{
+	std::string pattern;
+	std::vector<std::string> sites;
+};
+
+struct scan_result
+{
+	size_t count = 0;
+	uint32_t firstRva = 0;
+	double ms = 0.0;
+};
+
+static bool MapImage(const fs::path& path, mapped_image& image, std::string& error)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+	{
+		error = "could not open file";
+		return false;
+	}
+
+	std::vector<uint8_t> raw((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	if (raw.size() < sizeof(IMAGE_DOS_HEADER))
+	{
+		error = "file too small";
+		return false;
+	}
+
+	auto dosHeader = reinterpret_cast<const IMAGE_DOS_HEADER*>(raw.data());
+	if (dosHeader->e_magic != IMAGE_DOS_SIGNATURE || dosHeader->e_lfanew < 0 ||
+		size_t(dosHeader->e_lfanew) + sizeof(IMAGE_NT_HEADERS) > raw.size())
+	{
+		error = "not a PE file";
+		return false;
+	}
+
+	auto ntHeader = reinterpret_cast<const IMAGE_NT_HEADERS*>(raw.data() + dosHeader->e_lfanew);
+	if (ntHeader->Signature != IMAGE_NT_SIGNATURE || ntHeader->OptionalHeader.Magic != IMAGE_NT_OPTIONAL_HDR32_MAGIC)
+	{
+		error = "not a PE32 image";
+		return false;
+	}
+
+	auto sections = reinterpret_cast<const IMAGE_SECTION_HEADER*>(
+		reinterpret_cast<const uint8_t*>(&ntHeader->OptionalHeader) + ntHeader->FileHeader.SizeOfOptionalHeader);
+	const size_t numSections = ntHeader->FileHeader.NumberOfSections;
+
+	if (reinterpret_cast<const uint8_t*>(sections + numSections) > raw.data() + raw.size())
+	{
+		error = "truncated section table";
+		return false;
+	}
+
+	// executable_meta bounds the scan by SizeOfRawData, which may run past SizeOfImage for the last section
+	size_t mappedSize = ntHeader->OptionalHeader.SizeOfImage;
+	for (size_t i = 0; i < numSections; i++)
+	{
+		mappedSize = std::max<size_t>(mappedSize, size_t(sections[i].VirtualAddress) + std::max(sections[i].SizeOfRawData, sections[i].Misc.VirtualSize));
+	}
+
+	image.name = path.filename().string();
+	image.imageBase = ntHeader->OptionalHeader.ImageBase;
+	image.memory.assign(mappedSize, 0);
+
+	std::memcpy(image.memory.data(), raw.data(), std::min<size_t>(ntHeader->OptionalHeader.SizeOfHeaders, raw.size()));
+
+	for (size_t i = 0; i < numSections; i++)
+	{
+		const auto& section = sections[i];
+		const size_t offset = section.PointerToRawData;
+		const size_t size = std::min<size_t>(section.SizeOfRawData, offset < raw.size() ? raw.size() - offset : 0);
+
+		std::memcpy(image.memory.data() + section.VirtualAddress, raw.data() + offset, size);
+	}
+
+	return true;
+}
+
+static void CollectSignatures(const fs::path& path, std::vector<signature>& signatures, std::map<std::string, size_t>& lookup)
+{
+	static const std::regex literal(R"re("((?:[0-9A-Fa-f]{2}|\?)(?: (?:[0-9A-Fa-f]{2}|\?)){3,})")re");
+
+	std::ifstream file(path);
+	std::string line;
+	size_t lineNumber = 0;
+
+	while (std::getline(file, line))
+	{
+		lineNumber++;
+
+		const size_t first = line.find_first_not_of(" \t");
+		if (first == std::string::npos || line.compare(first, 2, "//") == 0)
+		{
+			continue;
+		}
+
+		for (std::sregex_iterator it(line.begin(), line.end(), literal), end; it != end; ++it)
+		{
+			const std::string pattern = (*it)[1].str();
+			const std::string site = path.generic_string() + ":" + std::to_string(lineNumber);
+
+			auto found = lookup.find(pattern);
+			if (found == lookup.end())
+			{
+				lookup.emplace(pattern, signatures.size());
+				signatures.push_back({ pattern, { site } });
+			}
+			else
+			{
+				signatures[found->second].sites.push_back(site);
+			}
+		}
+	}
+}
+
+static void CollectSources(const fs::path& path, std::vector<signature>& signatures, std::map<std::string, size_t>& lookup)
+{
+	if (!fs::is_directory(path))
+	{
+		CollectSignatures(path, signatures, lookup);
+		return;
+	}
+
+	std::vector<fs::path> files;
+	for (const auto& entry : fs::recursive_directory_iterator(path))
+	{
+		const auto ext = entry.path().extension();
+		if (entry.is_regular_file() && (ext == ".cpp" || ext == ".h" || ext == ".hpp" || ext == ".ixx"))
+		{
+			files.push_back(entry.path());
+		}
+	}
+
+	// directory order is unspecified, keep the report stable between runs
+	std::sort(files.begin(), files.end());
+
+	for (const auto& file : files)
+	{
+		CollectSignatures(file, signatures, lookup);
+	}
+}
+
+static scan_result ScanSignature(mapped_image& image, const std::string& pattern, int repeat)
+{
+	scan_result result;
+
+	for (int i = 0; i < repeat; i++)
+	{
+		auto start = std::chrono::steady_clock::now();
+
+		auto matches = hook::module_pattern(image.memory.data(), pattern);
+		result.count = matches.size();
+
+		result.ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		if (result.count != 0)
+		{
+			result.firstRva = static_cast<uint32_t>(matches.get(0).get<uint8_t>() - image.memory.data());
+		}
+	}
+
+	result.ms /= repeat;
+	return result;
+}
+
+static double ScanBatch(mapped_image& image, const std::vector<signature>& signatures, int repeat)
+{
+	double ms = 0.0;
+
+	for (int i = 0; i < repeat; i++)
+	{
+		auto start = std::chrono::steady_clock::now();
+
+		hook::pattern_batch batch(image.memory.data());
+		for (const auto& sig : signatures)
+		{
+			batch.add(sig.pattern);
+		}
+		batch.scan();
+
+		ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	return ms / repeat;
+}
+
+static void PrintUsage()
+{
+	printf("usage: sigcheck [--repeat N] [--verbose] --src <file or directory>... <image>...\n");
+}
+
+int main(int argc, char** argv)
+{
+	std::vector<fs::path> sources;
+	std::vector<fs::path> imagePaths;
+	int repeat = 1;
+	bool verbose = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string arg = argv[i];
+
+		if (arg == "--src" && i + 1 < argc)
+		{
+			sources.emplace_back(argv[++i]);
+		}
+		else if (arg == "--repeat" && i + 1 < argc)
+		{
+			repeat = std::max(1, atoi(argv[++i]));
+		}
+		else if (arg == "--verbose")
+		{
+			verbose = true;
+		}
+		else if (arg == "--help" || arg == "-h")
+		{
+			PrintUsage();
+			return 0;
+		}
+		else
+		{
+			imagePaths.emplace_back(arg);
+		}
+	}
+
+	if (sources.empty() || imagePaths.empty())
+	{
+		PrintUsage();
+		return 2;
+	}
+
+	std::vector<signature> signatures;
+	std::map<std::string, size_t> lookup;
+
+	for (const auto& source : sources)
+	{
+		if (!fs::exists(source))
+		{
+			fprintf(stderr, "sigcheck: %s: no such file or directory\n", source.string().c_str());
+			return 2;
+		}
+
+		CollectSources(source, signatures, lookup);
+	}
+
+	std::vector<mapped_image> images(imagePaths.size());
+
+	for (size_t i = 0; i < imagePaths.size(); i++)
+	{
+		std::string error;
+		if (!MapImage(imagePaths[i], images[i], error))
+		{
+			fprintf(stderr, "sigcheck: %s: %s\n", imagePaths[i].string().c_str(), error.c_str());
+			return 2;
+		}
+	}
+
+	printf("%zu signatures, %zu images\n\n", signatures.size(), images.size());
+
+	size_t missing = 0;
+	size_t ambiguous = 0;
+	double totalMs = 0.0;
+
+	for (const auto& sig : signatures)
+	{
+		std::vector<scan_result> results;
+		bool found = false;
+		bool isAmbiguous = false;
+
+		for (auto& image : images)
+		{
+			results.push_back(ScanSignature(image, sig.pattern, repeat));
+			totalMs += results.back().ms;
+
+			found |= results.back().count != 0;
+			isAmbiguous |= results.back().count > 1;
+		}
+
+		const char* status = !found ? "MISSING" : isAmbiguous ? "AMBIGUOUS" : "OK";
+		missing += !found;
+		ambiguous += isAmbiguous;
+
+		printf("%-9s \"%s\"\n", status, sig.pattern.c_str());
+
+		for (const auto& site : sig.sites)
+		{
+			printf("          at %s\n", site.c_str());
+		}
+
+		for (size_t i = 0; i < images.size(); i++)
+		{
+			const auto& result = results[i];
+
+			if (result.count == 0 && !verbose)
+			{
+				continue;
+			}
+
+			printf("          %-24s %4zu match%s", images[i].name.c_str(), result.count, result.count == 1 ? "  " : "es");
+
+			if (result.count != 0)
+			{
+				printf(", first 0x%08X (rva 0x%X)", images[i].imageBase + result.firstRva, result.firstRva);
+			}
+
+			printf(", %.3f ms\n", result.ms);
+		}
+	}
+
+	printf("\n%zu ok, %zu ambiguous, %zu missing\n", signatures.size() - missing - ambiguous, ambiguous, missing);
+	printf("individual scans: %.2f ms total\n", totalMs);
+
+	for (auto& image : images)
+	{
+		printf("batched scan of %-24s %.2f ms\n", image.name.c_str(), ScanBatch(image, signatures, repeat));
+	}
+
+	return missing != 0 ? 1 : 0;
+}
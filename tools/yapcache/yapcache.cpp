@@ -0,0 +1,228 @@
+// yapcache: dumps and verifies the binary config caches the plugin writes next to itself (CoDUO-YAP.menuwide.cache,
+// CoDUO-YAP.eweapons.cache, see src/utils/configcache.h).
+//
+// usage: yapcache dump <cache>...
+//        yapcache verify [--sources] <cache>...
+//
+// verify checks the header, bounds, checksum and every string reference. With --sources it also compares the
+// recorded sources against the disk the way the plugin does, which only makes sense on the machine the cache was
+// written on.
+
+#include "utils/configcache.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+static const char* KindName(config_cache_kind kind)
+{
+	switch (kind)
+	{
+	case config_cache_kind::menuwide: return "menuwide";
+	case config_cache_kind::eweapons: return "eweapons";
+	}
+	return "unknown";
+}
+
+static uint32_t ExpectedRecordSize(config_cache_kind kind)
+{
+	switch (kind)
+	{
+	case config_cache_kind::menuwide: return sizeof(menuwide_cache_record);
+	case config_cache_kind::eweapons: return sizeof(eweapon_cache_record);
+	}
+	return 0;
+}
+
+static bool StringValid(const config_cache_reader& cache, const config_cache_string& str)
+{
+	return str.length == 0 || !cache.string(str).empty();
+}
+
+static void DumpRecord(const config_cache_reader& cache, size_t index)
+{
+	const auto kind = cache.header().kind;
+
+	if (kind == config_cache_kind::menuwide)
+	{
+		const auto& record = cache.record<menuwide_cache_record>(index);
+		const std::string name(cache.string(record.name));
+
+		printf("  %-5s %-40s alignment 0x%02X\n", record.isHudShader ? "hud" : "menu", name.c_str(), record.alignment);
+	}
+	else if (kind == config_cache_kind::eweapons)
+	{
+		const auto& record = cache.record<eweapon_cache_record>(index);
+		const std::string name(cache.string(record.name));
+
+		printf("  %-32s bob %.3f %.3f, speed scale %.3f", name.c_str(), record.sprintBob[0], record.sprintBob[1], record.sprintSpeedScale);
+
+		if (record.hasSprintRot)
+		{
+			printf(", rot %.3f %.3f %.3f", record.sprintRot[0], record.sprintRot[1], record.sprintRot[2]);
+		}
+
+		if (record.hasSprintMove)
+		{
+			printf(", move %.3f %.3f %.3f", record.sprintMove[0], record.sprintMove[1], record.sprintMove[2]);
+		}
+
+		printf("\n");
+	}
+}
+
+static bool Dump(const std::string& file)
+{
+	config_cache_reader cache;
+	std::string error;
+
+	if (!cache.open(file, error))
+	{
+		fprintf(stderr, "yapcache: %s: %s\n", file.c_str(), error.c_str());
+		return false;
+	}
+
+	const auto& header = cache.header();
+	printf("%s: %s cache v%u, %u bytes, checksum %016llX\n", file.c_str(), KindName(header.kind), header.version,
+		header.fileSize, (unsigned long long)header.checksum);
+
+	printf("%u sources\n", header.sourceCount);
+	for (size_t i = 0; i < header.sourceCount; i++)
+	{
+		const auto& source = cache.source(i);
+		const std::string path(cache.string(source.path));
+
+		if (source.isDirectory)
+		{
+			printf("  dir  %s%s\n", path.c_str(), source.size ? "" : " (missing)");
+		}
+		else
+		{
+			printf("  file %s, %llu bytes, mtime %lld, hash %016llX\n", path.c_str(), (unsigned long long)source.size,
+				(long long)source.mtime, (unsigned long long)source.hash);
+		}
+	}
+
+	printf("%u records of %u bytes\n", header.recordCount, header.recordSize);
+	if (header.recordSize == ExpectedRecordSize(header.kind))
+	{
+		for (size_t i = 0; i < header.recordCount; i++)
+		{
+			DumpRecord(cache, i);
+		}
+	}
+
+	return true;
+}
+
+static bool Verify(const std::string& file, bool checkSources)
+{
+	config_cache_reader cache;
+	std::string error;
+
+	if (!cache.open(file, error))
+	{
+		printf("FAILED %s: %s\n", file.c_str(), error.c_str());
+		return false;
+	}
+
+	const auto& header = cache.header();
+
+	if (ExpectedRecordSize(header.kind) == 0)
+	{
+		printf("FAILED %s: unknown cache kind %u\n", file.c_str(), (unsigned)header.kind);
+		return false;
+	}
+
+	if (header.recordSize != ExpectedRecordSize(header.kind))
+	{
+		printf("FAILED %s: record size %u, expected %u\n", file.c_str(), header.recordSize, ExpectedRecordSize(header.kind));
+		return false;
+	}
+
+	std::vector<std::filesystem::path> dirs;
+	for (size_t i = 0; i < header.sourceCount; i++)
+	{
+		const auto& source = cache.source(i);
+		if (!StringValid(cache, source.path))
+		{
+			printf("FAILED %s: source %zu has a bad path\n", file.c_str(), i);
+			return false;
+		}
+
+		if (source.isDirectory)
+		{
+			const auto path = cache.string(source.path);
+			dirs.emplace_back(std::u8string(path.begin(), path.end()));
+		}
+	}
+
+	for (size_t i = 0; i < header.recordCount; i++)
+	{
+		const config_cache_string& name = header.kind == config_cache_kind::menuwide
+			? cache.record<menuwide_cache_record>(i).name
+			: cache.record<eweapon_cache_record>(i).name;
+
+		if (!StringValid(cache, name))
+		{
+			printf("FAILED %s: record %zu has a bad name\n", file.c_str(), i);
+			return false;
+		}
+	}
+
+	if (checkSources && !cache.sources_match(ConfigCache_Snapshot(dirs), error))
+	{
+		printf("STALE  %s: %s\n", file.c_str(), error.c_str());
+		return false;
+	}
+
+	printf("OK     %s: %s, %u sources, %u records\n", file.c_str(), KindName(header.kind), header.sourceCount, header.recordCount);
+	return true;
+}
+
+static void PrintUsage()
+{
+	printf("usage: yapcache dump <cache>...\n");
+	printf("       yapcache verify [--sources] <cache>...\n");
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		PrintUsage();
+		return 2;
+	}
+
+	const std::string command = argv[1];
+	bool checkSources = false;
+	std::vector<std::string> files;
+
+	for (int i = 2; i < argc; i++)
+	{
+		const std::string arg = argv[i];
+
+		if (arg == "--sources")
+		{
+			checkSources = true;
+		}
+		else
+		{
+			files.push_back(arg);
+		}
+	}
+
+	if ((command != "dump" && command != "verify") || files.empty())
+	{
+		PrintUsage();
+		return 2;
+	}
+
+	bool ok = true;
+	for (const auto& file : files)
+	{
+		ok &= command == "dump" ? Dump(file) : Verify(file, checkSources);
+	}
+
+	return ok ? 0 : 1;
+}